@@ -0,0 +1,47 @@
+//======================================================================================================================
+// MountConfig
+//
+// The heliostat's hardware as the firmware drives it: pins, drive train, motion profile and mechanical limits. The
+// host tools include it too, so they simulate the mount main.cpp runs rather than a copy of its settings.
+//======================================================================================================================
+
+#ifndef MOUNTCONFIG_H
+#define MOUNTCONFIG_H
+
+#include "GearRatio.h"
+
+/* ========= STEPPER PINS ========= */
+#define STEP_X 13
+#define DIR_X  12
+#define STEP_Y 18
+#define DIR_Y  17
+#define SLEEP_RESET_STEP_PIN  6
+
+/* ========= GEAR CALIBRATION (microsteps per degree) ========= */
+// Exact fractions: 3200 microsteps/rev, Azimuth 17:144, Elevation 21:64. Adjustable via Preferences as
+// numerator/denominator; backlash is separate.
+#define MOTOR_MICROSTEPS_PER_REV 3200
+const GearRatio DEFAULT_GEAR_AZ = GearRatio::fromTeeth(MOTOR_MICROSTEPS_PER_REV, 144, 17);
+const GearRatio DEFAULT_GEAR_EL = GearRatio::fromTeeth(MOTOR_MICROSTEPS_PER_REV, 64, 21);
+
+/* ========= MOTION PROFILE ========= */
+// Start at a rate the motors pull in cold under the mirror load, then accelerate
+#define STEP_START_RATE 800.0f     // steps/s
+#define STEP_ACCEL      3000.0f    // steps/s^2, peak
+#define SLEW_RATE       4000.0f    // steps/s, top speed of each axis
+// Ramp shape per axis: RAMP_SCURVE keeps the geared mirror from ringing at the ramp corners,
+// RAMP_TRAPEZOID ramps at constant acceleration, RAMP_FIXED steps at a fixed interval
+#define RAMP_SHAPE_AZ   RAMP_SCURVE
+#define RAMP_SHAPE_EL   RAMP_SCURVE
+
+/* ========= CABLE WRAP ========= */
+// Default mechanical azimuth range the cables allow, degrees from the aligned (north) position
+#define DEFAULT_WRAP_MIN_DEG -270.0f
+#define DEFAULT_WRAP_MAX_DEG  270.0f
+
+/* ========= ELEVATION LIMITS ========= */
+// Mechanical elevation range, degrees: from level with the horizon (home) to face up (stowed)
+#define EL_MIN_DEG 0.0f
+#define EL_MAX_DEG 90.0f
+
+#endif  //MOUNTCONFIG_H
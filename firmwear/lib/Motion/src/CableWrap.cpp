@@ -0,0 +1,26 @@
+#include "CableWrap.h"
+
+CableWrap::CableWrap(Angle minAngle, Angle maxAngle) : lo(minAngle), hi(maxAngle)
+{
+  if (lo > hi)
+  {
+    lo = maxAngle;
+    hi = minAngle;
+  }
+}
+
+Angle CableWrap::nearest(Angle current, Angle bearing) const
+{
+  // Short way first; if that crosses a limit, the same bearing a turn back the other way (more than one if the axis
+  // was jogged outside the range)
+  int64_t target = (int64_t)current + angleDelta(bearing, current);
+  while (target > hi && target - ANGLE_FULL_TURN >= lo) target -= ANGLE_FULL_TURN;
+  while (target < lo && target + ANGLE_FULL_TURN <= hi) target += ANGLE_FULL_TURN;
+
+  if (target >= lo && target <= hi) return (Angle)target;
+
+  // Out of reach: whichever limit is angularly closer to the bearing
+  Angle toLo = angleDelta(bearing, lo);
+  Angle toHi = angleDelta(bearing, hi);
+  return (toLo < 0 ? -toLo : toLo) <= (toHi < 0 ? -toHi : toHi) ? lo : hi;
+}
@@ -0,0 +1,51 @@
+//======================================================================================================================
+// CableWrap
+//
+// Wrap-aware azimuth handling. The sun's azimuth is a bearing in [0, 360), but the mount's azimuth axis counts
+// microsteps without wrapping, so one bearing corresponds to a mechanical angle on every turn. CableWrap picks the
+// turn to use: the one closest to where the axis is, so moves take the short way round, unless that would leave
+// the range the cables allow, in which case the axis goes the long way instead.
+//======================================================================================================================
+
+#ifndef CABLEWRAP_H
+#define CABLEWRAP_H
+
+#include "GearRatio.h"
+
+#define ANGLE_FULL_TURN (360L * ANGLE_PER_DEG)
+
+// Bearing in [0, 360)
+inline Angle angleNormalize(Angle angle)
+{
+  Angle a = angle % ANGLE_FULL_TURN;
+  return a < 0 ? a + ANGLE_FULL_TURN : a;
+}
+
+// Shortest signed turn from one angle to another, in (-180, 180]
+inline Angle angleDelta(Angle to, Angle from)
+{
+  int64_t d = ((int64_t)to - from) % ANGLE_FULL_TURN;
+  if (d > ANGLE_FULL_TURN / 2) d -= ANGLE_FULL_TURN;
+  if (d <= -ANGLE_FULL_TURN / 2) d += ANGLE_FULL_TURN;
+  return (Angle)d;
+}
+
+class CableWrap
+{
+public:
+  // Mechanical azimuth range the cables allow (0 = the direction set during alignment)
+  CableWrap(Angle minAngle, Angle maxAngle);
+
+  // Mechanical angle for a bearing, as close to current as the range allows. A range narrower than a turn cannot
+  // reach every bearing; those clamp to the nearer limit.
+  Angle nearest(Angle current, Angle bearing) const;
+
+  Angle minAngle() const { return lo; }
+  Angle maxAngle() const { return hi; }
+
+private:
+  Angle lo;
+  Angle hi;
+};
+
+#endif  //CABLEWRAP_H
@@ -0,0 +1,74 @@
+#include "GearRatio.h"
+
+static uint32_t gcd(uint32_t a, uint32_t b)
+{
+  while (b != 0)
+  {
+    uint32_t r = a % b;
+    a = b;
+    b = r;
+  }
+  return a;
+}
+
+// Integer division rounding half away from zero; den > 0
+static int64_t divRound(int64_t num, int64_t den)
+{
+  return num >= 0 ? (num + den / 2) / den : -((-num + den / 2) / den);
+}
+
+GearRatio::GearRatio(uint32_t num, uint32_t den) : n(num > 0 ? num : 1), d(den > 0 ? den : 1)
+{
+  uint32_t g = gcd(n, d);
+  if (g > 1)
+  {
+    n /= g;
+    d /= g;
+  }
+}
+
+GearRatio GearRatio::fromTeeth(uint32_t motorSteps, uint32_t outputTeeth, uint32_t inputTeeth)
+{
+  // Reduce before multiplying so the fraction stays within 32 bits
+  uint32_t g = gcd(motorSteps, 360);
+  return GearRatio((motorSteps / g) * outputTeeth, (360 / g) * inputTeeth);
+}
+
+GearRatio GearRatio::fromStepsPerDegree(double stepsPerDegree)
+{
+  if (!(stepsPerDegree > 0) || stepsPerDegree >= 4294967295.0) return GearRatio(1, 1);
+  // Continued fraction convergents h/k; the first within a float's precision is the one it was made from
+  uint64_t h0 = 0, h1 = 1, k0 = 1, k1 = 0;
+  double x = stepsPerDegree;
+  for (;;)
+  {
+    double a = floor(x);
+    uint64_t h = (uint64_t)a * h1 + h0, k = (uint64_t)a * k1 + k0;
+    if (h > 0xFFFFFFFFULL || k > 0xFFFFFFFFULL) break;
+    h0 = h1;
+    h1 = h;
+    k0 = k1;
+    k1 = k;
+    if (fabs((double)h1 / k1 - stepsPerDegree) <= stepsPerDegree * 1.2e-7) break;
+    x = 1 / (x - a);
+  }
+  return GearRatio((uint32_t)h1, (uint32_t)k1);
+}
+
+long GearRatio::toSteps(Angle angle) const
+{
+  return (long)divRound((int64_t)angle * n, (int64_t)d * ANGLE_PER_DEG);
+}
+
+int64_t GearRatio::toAngle(long steps) const
+{
+  // steps * d * ANGLE_PER_DEG overflows 64 bits for a large count or denominator. Whole multiples of n convert
+  // exactly on their own; the rest is below n, so rest * d fits 64 bits unsigned, and is split by n once more
+  // before scaling to microdegrees.
+  int64_t whole = steps / (int64_t)n;
+  int64_t rest = steps % (int64_t)n;
+  uint64_t r = (uint64_t)(rest < 0 ? -rest : rest) * d;
+  uint64_t q = r / n;
+  int64_t part = (int64_t)(q * ANGLE_PER_DEG) + divRound((int64_t)(r - q * n) * ANGLE_PER_DEG, (int64_t)n);
+  return whole * d * ANGLE_PER_DEG + (rest < 0 ? -part : part);
+}
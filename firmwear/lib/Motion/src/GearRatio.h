@@ -0,0 +1,69 @@
+//======================================================================================================================
+// GearRatio
+//
+// Exact conversion between output angles and motor microsteps. The drive trains have odd tooth counts (17:144 and
+// 21:64), so microsteps per degree is not a round number; as a float it carries rounding error into every target.
+// Here it is kept as a reduced fraction num/den, angles are integer microdegrees, and both directions round to the
+// nearest unit in 64-bit integer arithmetic. Positions therefore stay integer microsteps end to end, and converting
+// the same angle always gives the same step, however long the mount has been running.
+//======================================================================================================================
+
+#ifndef GEARRATIO_H
+#define GEARRATIO_H
+
+#include <stdint.h>
+#include <math.h>
+
+#define ANGLE_PER_DEG 1000000L
+#define ANGLE_MAX_DEG 2147.0
+
+typedef int32_t Angle;  // microdegrees, +-ANGLE_MAX_DEG
+
+// Out-of-range input (a typo in a goto) saturates instead of wrapping round
+inline Angle angleFromDegrees(double degrees)
+{
+  if (degrees > ANGLE_MAX_DEG) degrees = ANGLE_MAX_DEG;
+  if (degrees < -ANGLE_MAX_DEG) degrees = -ANGLE_MAX_DEG;
+  return (Angle)llround(degrees * ANGLE_PER_DEG);
+}
+inline double angleToDegrees(Angle angle) { return angle / (double)ANGLE_PER_DEG; }
+
+// Back into Angle range from a wider result, saturating like angleFromDegrees
+inline Angle angleSaturate(int64_t angle)
+{
+  if (angle > (int64_t)(ANGLE_MAX_DEG * ANGLE_PER_DEG)) return (Angle)(ANGLE_MAX_DEG * ANGLE_PER_DEG);
+  if (angle < -(int64_t)(ANGLE_MAX_DEG * ANGLE_PER_DEG)) return -(Angle)(ANGLE_MAX_DEG * ANGLE_PER_DEG);
+  return (Angle)angle;
+}
+
+class GearRatio
+{
+public:
+  // num/den microsteps per degree. Neither may be 0; a 0 is taken as 1 rather than dividing by it.
+  GearRatio(uint32_t num, uint32_t den);
+
+  // Motor microsteps per revolution, geared down by outputTeeth:inputTeeth
+  static GearRatio fromTeeth(uint32_t motorSteps, uint32_t outputTeeth, uint32_t inputTeeth);
+
+  // The simplest fraction a float microsteps-per-degree calibration could have been rounded from
+  static GearRatio fromStepsPerDegree(double stepsPerDegree);
+
+  long toSteps(Angle angle) const;  // nearest microstep
+  // Nearest microdegree, in 64 bits: any step count converts without overflow at any real gear ratio, also beyond
+  // the range of Angle
+  int64_t toAngle(long steps) const;
+
+  // Convenience for the float boundary (sun position, user input, rates); exact from the Angle on
+  long degreesToSteps(double degrees) const { return toSteps(angleFromDegrees(degrees)); }
+  double stepsToDegrees(long steps) const { return toAngle(steps) / (double)ANGLE_PER_DEG; }
+  float stepsPerDegree() const { return (float)n / d; }
+
+  uint32_t num() const { return n; }
+  uint32_t den() const { return d; }
+
+private:
+  uint32_t n;
+  uint32_t d;
+};
+
+#endif  //GEARRATIO_H
@@ -0,0 +1,98 @@
+#include "Keyhole.h"
+#include <math.h>
+
+// Sun's azimuth change over one sample interval, the short way round
+static double sampleDelta(const double azimuth[], uint8_t k)
+{
+  double d = fmod(azimuth[k + 1] - azimuth[k], 360.0);
+  if (d > 180) d -= 360;
+  if (d <= -180) d += 360;
+  return d;
+}
+
+double keyholeError(double azimuthDelta, double elevation)
+{
+  // Both directions lie on the same elevation circle; the chord between them gives the angle
+  const double toRad = M_PI / 180;
+  double half = cos(elevation * toRad) * fabs(sin(azimuthDelta * toRad / 2));
+  return 2 * asin(half > 1 ? 1 : half) / toRad;
+}
+
+KeyholePass::KeyholePass() : valid(false), t0(0), t1(0), az0(0), az1(0), sunPeak(0), error(0)
+{
+}
+
+void KeyholePass::clear()
+{
+  valid = false;
+  error = 0;
+}
+
+bool KeyholePass::plan(unsigned long start, uint16_t stepSec, const double azimuth[], const double elevation[],
+                       uint8_t count, float maxRate)
+{
+  clear();
+  sunPeak = 0;
+  if (count < 2 || stepSec == 0) return false;
+
+  // Intervals where the sun turns faster than the axis may
+  int first = -1, last = -1;
+  for (uint8_t k = 0; k + 1 < count; k++)
+  {
+    float r = fabs(sampleDelta(azimuth, k)) / stepSec;
+    if (r > sunPeak) sunPeak = r;
+    if (r <= maxRate) continue;
+    if (first < 0) first = k;
+    last = k;
+  }
+  if (first < 0) return false;
+
+  // Widen the window round them, a sample each side in turn, until a straight ramp across it is slow enough. If
+  // that runs past the last sample, the pass is not fully in view yet.
+  uint8_t a = first, b = last + 1;
+  double swing = 0;
+  for (uint8_t k = a; k < b; k++)
+    swing += sampleDelta(azimuth, k);
+  bool before = true;
+  while (fabs(swing) > (double)maxRate * stepSec * (b - a))
+  {
+    if (before && a > 0) swing += sampleDelta(azimuth, --a);
+    else if (b + 1 < count) swing += sampleDelta(azimuth, b++);
+    else return false;
+    before = !before;
+  }
+
+  t0 = start + (unsigned long)a * stepSec;
+  t1 = start + (unsigned long)b * stepSec;
+  az0 = azimuth[a];
+  az1 = az0 + swing;
+
+  // Worst pointing error at the samples, against the sun's azimuth followed continuously from the start
+  double sun = az0;
+  for (uint8_t k = a; k <= b; k++)
+  {
+    double e = keyholeError(az0 + swing * (k - a) / (b - a) - sun, elevation[k]);
+    if (e > error) error = e;
+    if (k < b) sun += sampleDelta(azimuth, k);
+  }
+  valid = true;
+  return true;
+}
+
+void KeyholePass::shift(double degrees)
+{
+  az0 += degrees;
+  az1 += degrees;
+}
+
+double KeyholePass::azimuth(double t) const
+{
+  if (t <= t0) return az0;
+  if (t >= t1) return az1;
+  return az0 + (az1 - az0) * (t - t0) / (t1 - t0);
+}
+
+double KeyholePass::rate() const
+{
+  return valid ? (az1 - az0) / (t1 - t0) : 0;
+}
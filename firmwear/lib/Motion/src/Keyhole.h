@@ -0,0 +1,63 @@
+//======================================================================================================================
+// Keyhole
+//
+// Azimuth planning through a near-zenith pass. An alt-az mount following a sun that passes close to the zenith has
+// to swing its azimuth by up to 180 degrees within seconds around transit, with the rate growing without bound as
+// the pass gets closer. Near the zenith a large azimuth error costs little pointing error, so KeyholePass replaces
+// the swing with a straight ramp at no more than a given rate: it starts before the sun's azimuth takes off and ends
+// after it has settled, keeping the elevation on the sun throughout.
+//
+// The pass is found in sun positions sampled at a fixed step ahead of time, so it can be committed to before it
+// starts and then followed unchanged.
+//======================================================================================================================
+
+#ifndef KEYHOLE_H
+#define KEYHOLE_H
+
+#include <stdint.h>
+
+class KeyholePass
+{
+public:
+  KeyholePass();
+
+  // Look for a pass in count sun positions (degrees) sampled every stepSec seconds from start. True if the sun's
+  // azimuth rate somewhere exceeds maxRate (degrees/s) and the ramp that replaces it ends within the samples.
+  bool plan(unsigned long start, uint16_t stepSec, const double azimuth[], const double elevation[], uint8_t count,
+            float maxRate);
+  void clear();
+
+  // Move the ramp by a whole number of turns, e.g. onto the mechanical angle the azimuth axis uses
+  void shift(double degrees);
+
+  bool planned() const { return valid; }
+  bool covers(unsigned long t) const { return valid && t >= t0 && t <= t1; }
+  unsigned long startTime() const { return t0; }
+  unsigned long endTime() const { return t1; }
+  double startAzimuth() const { return az0; }
+  double endAzimuth() const { return az1; }
+
+  // Azimuth (degrees) to point at, t seconds since the epoch of the samples; between startTime and endTime
+  double azimuth(double t) const;
+  // Azimuth rate of the ramp, degrees/s
+  double rate() const;
+
+  // Largest azimuth rate of the sun in the samples, and the largest angle between the sun and the planned pointing
+  // through the pass, degrees/s and degrees
+  float peakRate() const { return sunPeak; }
+  float maxError() const { return error; }
+
+private:
+  bool valid;
+  unsigned long t0;
+  unsigned long t1;
+  double az0;
+  double az1;
+  float sunPeak;
+  float error;
+};
+
+// Angle between two directions at the same elevation, degrees
+double keyholeError(double azimuthDelta, double elevation);
+
+#endif  //KEYHOLE_H
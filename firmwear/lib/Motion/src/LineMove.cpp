@@ -0,0 +1,67 @@
+#include "LineMove.h"
+
+LineMove::LineMove() : majorSteps(0), stepsDone(0), major(AXIS_AZ), dirBits(0), axisBits(0)
+{
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    delta[i] = 0;
+    error[i] = 0;
+  }
+}
+
+void MOTION_ISR_ATTR LineMove::begin(const long from[AXIS_COUNT], const long to[AXIS_COUNT])
+{
+  majorSteps = 0;
+  stepsDone = 0;
+  major = AXIS_AZ;
+  dirBits = 0;
+  axisBits = 0;
+
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    long d = to[i] - from[i];
+    delta[i] = d < 0 ? -d : d;
+    if (d > 0) dirBits |= 1 << i;
+    if (d != 0) axisBits |= 1 << i;
+    if (delta[i] > majorSteps)
+    {
+      majorSteps = delta[i];
+      major = i;
+    }
+  }
+
+  // Start each error term half a step in, so minor steps are centred on the line rather than bunched at one end
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    error[i] = majorSteps / 2;
+}
+
+float LineMove::majorLimit(const float axisLimit[AXIS_COUNT]) const
+{
+  float limit = axisLimit[major];
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    if (i == major || delta[i] == 0) continue;
+    float scaled = axisLimit[i] * majorSteps / delta[i];
+    if (scaled < limit) limit = scaled;
+  }
+  return limit;
+}
+
+uint8_t MOTION_ISR_ATTR LineMove::next()
+{
+  if (done()) return 0;
+  stepsDone++;
+
+  uint8_t stepBits = 1 << major;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    if (i == major) continue;
+    error[i] -= delta[i];
+    if (error[i] < 0)
+    {
+      error[i] += majorSteps;
+      stepBits |= 1 << i;
+    }
+  }
+  return stepBits;
+}
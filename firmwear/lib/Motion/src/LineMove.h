@@ -0,0 +1,51 @@
+//======================================================================================================================
+// LineMove
+//
+// Coordinated multi-axis move generator (Bresenham/DDA). The axis with the most steps to go is the major axis; every
+// step of it advances the line, and the other axes step whenever their integer error term overflows. All axes
+// therefore start together, finish on the same step and keep a straight path in step space, using integer
+// arithmetic only so next() is safe to call from the step ISR.
+//======================================================================================================================
+
+#ifndef LINEMOVE_H
+#define LINEMOVE_H
+
+#include "MotionTypes.h"
+#include "MotionPort.h"
+
+class LineMove
+{
+public:
+  LineMove();
+
+  // Plan a line between two absolute positions (microsteps per axis)
+  void begin(const long from[AXIS_COUNT], const long to[AXIS_COUNT]);
+
+  bool done() const { return stepsDone >= majorSteps; }
+  unsigned long remaining() const { return majorSteps - stepsDone; }
+  unsigned long length() const { return majorSteps; }
+  unsigned long steps(uint8_t axis) const { return delta[axis]; }
+  uint8_t majorAxis() const { return major; }
+
+  // Direction of each axis (bit set = forward) and which axes move at all
+  uint8_t dirMask() const { return dirBits; }
+  uint8_t axisMask() const { return axisBits; }
+
+  // Largest major-axis value (rate, acceleration) that keeps every axis within its own limit. The minor axes move
+  // proportionally slower, so the line runs as fast as the most constrained axis allows.
+  float majorLimit(const float axisLimit[AXIS_COUNT]) const;
+
+  // Advance the line by one major-axis step. Returns the bit mask (1 << axis) of the axes that step.
+  uint8_t next();
+
+private:
+  unsigned long delta[AXIS_COUNT];
+  long error[AXIS_COUNT];
+  unsigned long majorSteps;
+  unsigned long stepsDone;
+  uint8_t major;
+  uint8_t dirBits;
+  uint8_t axisBits;
+};
+
+#endif  //LINEMOVE_H
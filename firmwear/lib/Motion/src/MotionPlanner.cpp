@@ -0,0 +1,113 @@
+#include "MotionPlanner.h"
+#include <math.h>
+
+MotionPlanner::MotionPlanner(StepEngine& stepEngine) : engine(stepEngine), count(0)
+{
+}
+
+bool MotionPlanner::addWaypoint(long azTarget, long elTarget)
+{
+  if (count >= PLANNER_MAX_WAYPOINTS) return false;
+  legs[count].target[AXIS_AZ] = azTarget;
+  legs[count].target[AXIS_EL] = elTarget;
+  count++;
+  return true;
+}
+
+float MotionPlanner::junctionSpeed(const Leg& a, const Leg& b, const float axisStart[AXIS_COUNT]) const
+{
+  float v = a.cruise < b.cruise ? a.cruise : b.cruise;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    float change = fabsf(a.dir[i] - b.dir[i]);
+    if (change > 0 && axisStart[i] / change < v) v = axisStart[i] / change;
+  }
+  return v;
+}
+
+void MotionPlanner::plan()
+{
+  float startRate[AXIS_COUNT], accel[AXIS_COUNT], maxRate[AXIS_COUNT];
+  engine.getLimits(startRate, accel, maxRate);
+
+  long from[AXIS_COUNT] = { engine.plannedPosition(AXIS_AZ), engine.plannedPosition(AXIS_EL) };
+  for (uint8_t k = 0; k < count; k++)
+  {
+    Leg& leg = legs[k];
+    LineMove line;
+    line.begin(from, leg.target);
+    leg.length = line.length();
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      long d = leg.target[i] - from[i];
+      leg.dir[i] = leg.length > 0 ? (float)d / leg.length : 0;
+      from[i] = leg.target[i];
+    }
+    leg.startRate = line.majorLimit(startRate);
+    leg.accel = line.majorLimit(accel);
+    leg.cruise = engine.clearOfBands(line, line.majorLimit(maxRate));
+    leg.entry = 0;
+    leg.exit = 0;
+  }
+
+  // Junction limits, skipping empty legs so a repeated waypoint does not force a stop
+  int8_t prev = -1;
+  for (uint8_t k = 0; k < count; k++)
+  {
+    if (legs[k].length == 0) continue;
+    if (prev >= 0)
+    {
+      float v = junctionSpeed(legs[prev], legs[k], startRate);
+      legs[prev].exit = v;
+      legs[k].entry = v;
+    }
+    prev = k;
+  }
+
+  // Backward pass: every leg must be able to slow down to its exit speed, the last one to a stop
+  float exit = 0;
+  for (int8_t k = count - 1; k >= 0; k--)
+  {
+    Leg& leg = legs[k];
+    if (leg.length == 0) continue;
+    leg.exit = exit;
+    float reachable = sqrtf(leg.exit * leg.exit + 2 * leg.accel * leg.length);
+    if (leg.accel > 0 && leg.entry > reachable) leg.entry = reachable;
+    exit = leg.entry;
+  }
+
+  // Forward pass: and speed up to it, starting from rest
+  float entry = 0;
+  for (uint8_t k = 0; k < count; k++)
+  {
+    Leg& leg = legs[k];
+    if (leg.length == 0) continue;
+    leg.entry = entry;
+    float reachable = sqrtf(leg.entry * leg.entry + 2 * leg.accel * leg.length);
+    if (leg.accel > 0 && leg.exit > reachable) leg.exit = reachable;
+    entry = leg.exit;
+  }
+}
+
+bool MotionPlanner::execute()
+{
+  if (count == 0) return true;
+  if (engine.queuedSegments() + count + 1 > STEP_QUEUE_SIZE) return false;
+
+  plan();
+  bool queued = false;
+  for (uint8_t k = 0; k < count; k++)
+  {
+    const Leg& leg = legs[k];
+    if (leg.length == 0) continue;
+    if (!engine.queueLine(leg.target[AXIS_AZ], leg.target[AXIS_EL], leg.entry, leg.exit))
+    {
+      // Whatever made it into the queue ends at speed; bring it down rather than leave it without a successor
+      if (queued) engine.stop(AXIS_AZ);
+      return false;
+    }
+    queued = true;
+  }
+  count = 0;
+  return true;
+}
@@ -0,0 +1,61 @@
+//======================================================================================================================
+// MotionPlanner
+//
+// Look-ahead planner for a path of waypoints. Each leg becomes a coordinated line on the step engine, and the legs are
+// blended so the mount does not stop at every corner:
+//
+//  - The speed through a junction is limited so that no axis changes its rate by more than its start rate, the jump
+//    the motor can take without a ramp. Straight-through junctions run at full speed, reversals at the start rate.
+//  - A backward pass lowers each leg's entry speed so the leg can still decelerate to its exit speed within its
+//    length; the last leg ends at rest. A forward pass then lowers each exit speed to what the leg can accelerate to.
+//
+// Speeds are major-axis rates (the infinity norm of the step-space velocity), so a junction speed means the same on
+// both legs. All planning is float maths on the main loop; the engine only sees precomputed segments.
+//======================================================================================================================
+
+#ifndef MOTIONPLANNER_H
+#define MOTIONPLANNER_H
+
+#include "StepEngine.h"
+
+// One queue slot stays free for the approach overshoot a backlash policy may add to the last leg
+#define PLANNER_MAX_WAYPOINTS (STEP_QUEUE_SIZE - 1)
+
+class MotionPlanner
+{
+public:
+  explicit MotionPlanner(StepEngine& stepEngine);
+
+  // Append an absolute waypoint (microsteps). Returns false once the buffer is full.
+  bool addWaypoint(long azTarget, long elTarget);
+
+  uint8_t pending() const { return count; }
+  void clear() { count = 0; }
+
+  // Plan the buffered path from the engine's planned position and queue it as one chain. The whole chain goes in at
+  // once, so a leg entered at speed always has its successor queued. Returns false, keeping the waypoints, if the
+  // engine queue lacks room or refuses a segment.
+  bool execute();
+
+private:
+  struct Leg
+  {
+    long target[AXIS_COUNT];
+    float dir[AXIS_COUNT];  // signed per-axis share of the major-axis rate
+    unsigned long length;   // major-axis steps
+    float startRate;        // major-axis limits of this leg
+    float accel;
+    float cruise;
+    float entry;
+    float exit;
+  };
+
+  StepEngine& engine;
+  Leg legs[PLANNER_MAX_WAYPOINTS];
+  uint8_t count;
+
+  void plan();
+  float junctionSpeed(const Leg& a, const Leg& b, const float axisStart[AXIS_COUNT]) const;
+};
+
+#endif  //MOTIONPLANNER_H
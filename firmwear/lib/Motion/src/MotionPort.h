@@ -0,0 +1,37 @@
+//======================================================================================================================
+// Motion port layer
+//
+// The motion code is plain C++ so it builds both for the ESP32 firmware and on a development host. This header maps
+// the few platform services it needs (ISR code and data placement, critical sections) onto the target.
+//======================================================================================================================
+
+#ifndef MOTIONPORT_H
+#define MOTIONPORT_H
+
+#include <stdint.h>
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <Arduino.h>
+
+#define MOTION_ISR_ATTR IRAM_ATTR
+#define MOTION_ISR_DATA DRAM_ATTR  // constant tables read by the ISR, kept out of flash
+
+typedef portMUX_TYPE MotionLock;
+#define MOTION_LOCK_INIT portMUX_INITIALIZER_UNLOCKED
+#define motionLock(l) portENTER_CRITICAL(l)
+#define motionUnlock(l) portEXIT_CRITICAL(l)
+
+#else
+
+#define MOTION_ISR_ATTR
+#define MOTION_ISR_DATA
+
+// On the host the step tick is driven synchronously by the caller, so there is nothing to lock against
+typedef int MotionLock;
+#define MOTION_LOCK_INIT 0
+#define motionLock(l) ((void)(l))
+#define motionUnlock(l) ((void)(l))
+
+#endif
+
+#endif  //MOTIONPORT_H
@@ -0,0 +1,35 @@
+//======================================================================================================================
+// Motion types shared by the step engine and the move generators
+//======================================================================================================================
+
+#ifndef MOTIONTYPES_H
+#define MOTIONTYPES_H
+
+#include <stdint.h>
+
+enum StepAxis
+{
+  AXIS_AZ = 0,
+  AXIS_EL = 1,
+  AXIS_COUNT = 2
+};
+
+// Velocity profile of an axis between rates
+enum RampShape
+{
+  RAMP_FIXED,      // jump straight to the requested rate, like a fixed step interval
+  RAMP_TRAPEZOID,  // constant acceleration
+  RAMP_SCURVE      // jerk-limited: acceleration builds up and dies away linearly (see RampTable)
+};
+
+// How an axis deals with play in its gear train. The play is always taken up with uncounted steps on reversal; the
+// approach policies additionally finish every move that ends at rest travelling the same way, so the gears settle
+// against the same flank whatever the move before.
+enum BacklashPolicy
+{
+  BACKLASH_TAKEUP,
+  BACKLASH_APPROACH_FORWARD,
+  BACKLASH_APPROACH_REVERSE
+};
+
+#endif  //MOTIONTYPES_H
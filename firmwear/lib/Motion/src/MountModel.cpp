@@ -0,0 +1,206 @@
+#include "MountModel.h"
+
+#ifndef ARDUINO_ARCH_ESP32
+
+#include <math.h>
+
+#define POLE_PAIRS 50       // hybrid stepper: 200 full steps, four to an electrical cycle
+#define REST_RATE 1e-4      // rad/s, slower than this counts as standing still for friction
+#define SLIP_MARGIN 0.25    // share of half an electrical cycle the rotor must go past the halfway point to slip
+
+AxisPlant AxisPlant::nema17A4988(const GearRatio& gear, float loadInertia, float backlash, float friction)
+{
+  AxisPlant p;
+  p.microstepsPerRev = 3200;
+  p.current = 1.0f;
+  p.torqueConstant = 0.25f;
+  p.resistance = 1.5f;
+  p.inductance = 2.8e-3f;
+  p.supply = 12.0f;
+  p.rotorInertia = 54e-7f;
+  p.damping = 0.002f;
+  p.gearRatio = (double)gear.num() / gear.den() * 360 / p.microstepsPerRev;
+  p.loadInertia = loadInertia;
+  p.backlash = backlash;
+  p.coulombFriction = friction;
+  p.viscousFriction = 0.01f;
+  p.resonanceLow = p.resonanceHigh = 0;
+  p.resonanceDepth = 0;
+  p.resonanceBuildup = 0.05f;
+  return p;
+}
+
+MountModel::MountModel() : nowUs(0), started(false)
+{
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    setAxis(i, AxisPlant::nema17A4988(GearRatio(1, 1), 0, 0, 0), 0xff, 0xff);
+}
+
+void MountModel::setAxis(uint8_t axis, const AxisPlant& plant, uint8_t stepPin, uint8_t dirPin)
+{
+  Axis& a = axes[axis];
+  a.plant = plant;
+  a.stepPin = stepPin;
+  a.dirPin = dirPin;
+  a.forward = true;
+  a.steps = 0;
+  a.motor = a.motorRate = 0;
+  a.load = -plant.backlash * M_PI / 360 * plant.gearRatio;  // resting against the forward flank
+  a.loadRate = 0;
+  a.contact = 1;
+  a.peakLag = 0;
+  a.pole = 0;
+  a.slips = 0;
+  a.slipUs = 0;
+  a.resonance = 0;
+  a.peakResonance = 0;
+}
+
+void MountModel::feed(PinGroup& pins)
+{
+  for (uint32_t k = 0; k < pins.edgeCount(); k++)
+  {
+    const PinEdge& e = pins.edge(k);
+    advance(e.timeUs);
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      Axis& a = axes[i];
+      if (e.pin == a.dirPin) a.forward = e.level;
+      else if (e.pin == a.stepPin && e.level) a.steps += a.forward ? 1 : -1;
+    }
+  }
+  pins.clearEdges();
+}
+
+void MountModel::advance(uint32_t timeUs)
+{
+  if (!started)
+  {
+    nowUs = timeUs;
+    started = true;
+    return;
+  }
+  while ((int32_t)(timeUs - nowUs) > 0)
+  {
+    uint32_t dt = timeUs - nowUs < MOUNT_MODEL_SUBSTEP_US ? timeUs - nowUs : MOUNT_MODEL_SUBSTEP_US;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      step(axes[i], dt * 1e-6);
+    nowUs += dt;
+  }
+}
+
+float MountModel::pullOutTorque(const AxisPlant& p, double radPerSec)
+{
+  double emf = p.supply - p.torqueConstant * fabs(radPerSec);
+  if (emf <= 0) return 0;
+  double reactance = POLE_PAIRS * fabs(radPerSec) * p.inductance;
+  double reachable = emf / sqrt(p.resistance * p.resistance + reactance * reactance);
+  return p.torqueConstant * (reachable < p.current ? reachable : p.current);
+}
+
+double MountModel::lag(const Axis& a) const
+{
+  double commandedAngle = a.steps * 2 * M_PI / a.plant.microstepsPerRev;
+  return POLE_PAIRS * (commandedAngle - a.motor);
+}
+
+double MountModel::outputDegrees(uint8_t axis) const
+{
+  const Axis& a = axes[axis];
+  return a.load / a.plant.gearRatio * 180 / M_PI;
+}
+
+double MountModel::error(uint8_t axis) const
+{
+  const Axis& a = axes[axis];
+  return outputDegrees(axis) - a.steps * 360.0 / a.plant.microstepsPerRev / a.plant.gearRatio;
+}
+
+long MountModel::missedSteps(uint8_t axis) const
+{
+  const Axis& a = axes[axis];
+  return -a.pole * (long)(a.plant.microstepsPerRev / POLE_PAIRS);
+}
+
+// Rate change of a body under a drive torque and Coulomb/viscous friction; holds it at rest while friction can
+static double frictionAccel(double rate, double drive, double coulomb, double viscous, double inertia)
+{
+  if (fabs(rate) < REST_RATE)
+  {
+    if (fabs(drive) <= coulomb) return 0;  // stays put
+    return (drive - (drive > 0 ? coulomb : -coulomb)) / inertia;
+  }
+  return (drive - (rate > 0 ? coulomb : -coulomb) - viscous * rate) / inertia;
+}
+
+void MountModel::step(Axis& a, double dt)
+{
+  const AxisPlant& p = a.plant;
+  double r = p.gearRatio;
+  double loadInertia = p.loadInertia / (r * r);  // referred to the motor
+  double coulomb = p.coulombFriction / r;
+  double viscous = p.viscousFriction / (r * r);
+  double play = p.backlash * M_PI / 180 * r;
+
+  // Motor torque: towards the current vector, limited by the torque-speed curve
+  double phi = lag(a);
+  double stepRate = fabs(a.motorRate) / (2 * M_PI) * p.microstepsPerRev;
+  bool resonant = stepRate > p.resonanceLow && stepRate < p.resonanceHigh;
+  a.resonance += ((resonant ? 1 : 0) - a.resonance) * dt / p.resonanceBuildup;
+  if (a.resonance > a.peakResonance) a.peakResonance = a.resonance;
+  double available = pullOutTorque(p, a.motorRate) * (1 - p.resonanceDepth * a.resonance);
+  double torque = available * sin(phi) - p.damping * a.motorRate;
+
+  // Load angle against the nearest pole, and slips past it. A rotor hovering halfway between two poles near stall
+  // crosses back and forth: the slip only counts once it is SLIP_MARGIN past the halfway point.
+  long pole = (long)floor(phi / (2 * M_PI) + 0.5);
+  double rel = fabs(phi - 2 * M_PI * pole) / (M_PI / 2);
+  if (rel > a.peakLag) a.peakLag = rel;
+  if (pole != a.pole && fabs(phi - 2 * M_PI * a.pole) > M_PI * (1 + SLIP_MARGIN))
+  {
+    if (a.slips == 0) a.slipUs = nowUs;
+    a.slips += labs(pole - a.pole);
+    a.pole = pole;
+  }
+
+  if (a.contact != 0)
+  {
+    // Stay in contact while the motor drives into the flank harder than the load would move on its own
+    double motorAccel = torque / p.rotorInertia;
+    double loadAccel = frictionAccel(a.loadRate, 0, coulomb, viscous, loadInertia);
+    if (a.contact * (motorAccel - loadAccel) >= 0)
+    {
+      double accel = frictionAccel(a.motorRate, torque, coulomb, viscous, p.rotorInertia + loadInertia);
+      double rate = a.motorRate + accel * dt;
+      if (rate * a.motorRate < 0 && fabs(torque) <= coulomb) rate = 0;  // friction stops it, not reverses it
+      a.motorRate = a.loadRate = rate;
+      a.motor += rate * dt;
+      a.load = a.motor - a.contact * play / 2;
+      return;
+    }
+    a.contact = 0;
+  }
+
+  // Across the play: the motor runs free, the load coasts to a stop
+  a.motorRate += torque / p.rotorInertia * dt;
+  a.motor += a.motorRate * dt;
+  if (fabs(a.loadRate) >= REST_RATE)
+  {
+    double rate = a.loadRate + frictionAccel(a.loadRate, 0, coulomb, viscous, loadInertia) * dt;
+    a.loadRate = rate * a.loadRate > 0 ? rate : 0;
+  }
+  else a.loadRate = 0;
+  a.load += a.loadRate * dt;
+
+  // Reached a flank: the two inertias meet and move on together
+  double gap = a.motor - a.load;
+  if (fabs(gap) >= play / 2)
+  {
+    a.contact = gap > 0 ? 1 : gap < 0 ? -1 : (a.motorRate >= a.loadRate ? 1 : -1);
+    double rate = (p.rotorInertia * a.motorRate + loadInertia * a.loadRate) / (p.rotorInertia + loadInertia);
+    a.motorRate = a.loadRate = rate;
+    a.load = a.motor - a.contact * play / 2;
+  }
+}
+
+#endif  //ARDUINO_ARCH_ESP32
@@ -0,0 +1,130 @@
+//======================================================================================================================
+// MountModel
+//
+// Host-side physical model of the two mount axes, driven by the STEP/DIR edges the firmware emits (as recorded by the
+// host PinGroup). Each axis is a hybrid stepper on a microstepping chopper driver, geared down to the mirror:
+//  - the driver sets the current vector to the commanded microstep; the rotor feels a torque Kt I(w) sin(Nr (c - m))
+//    towards it, where Nr = 50 pole pairs. I(w) is the torque-speed curve of a chopper driver: the set current until
+//    the supply, less the back-EMF, can no longer push it through the winding impedance at the electrical frequency
+//  - the rotor and the mirror (referred through the gear ratio) are two inertias with a dead zone of backlash between
+//    them: in contact they move as one, across the play the motor runs free and the mirror coasts on its friction
+//  - Coulomb and viscous friction at the output, with sticking at rest, and damping at the rotor
+//  - optionally a mid-band resonance: while the step rate stays inside a band, an oscillation builds up and takes
+//    part of the torque away; it dies down again outside the band, so a ramp that passes through quickly gets away
+//    with it and a cruise inside the band stalls
+//
+// A step is missed when the rotor falls more than half an electrical cycle behind (or ahead of) the current vector:
+// it then settles on the next pole, a whole electrical cycle (four full steps) off. The slip counts once the rotor is
+// clearly past the halfway point, so one hovering on it near stall is not counted slipping to and fro. missedSteps()
+// reports the microsteps lost that way, so acceleration and top speed can be tuned against the load without risking
+// hardware.
+//
+// Only built on the host.
+//======================================================================================================================
+
+#ifndef MOUNTMODEL_H
+#define MOUNTMODEL_H
+
+#ifndef ARDUINO_ARCH_ESP32
+
+#include <stdint.h>
+#include "MotionTypes.h"
+#include "GearRatio.h"
+#include "PinGroup.h"
+
+#define MOUNT_MODEL_SUBSTEP_US 5  // integration step, well below the rotor's natural period
+
+struct AxisPlant
+{
+  // Motor and driver
+  uint32_t microstepsPerRev;
+  float current;         // A, the driver's current setting
+  float torqueConstant;  // N m/A, also the back-EMF constant in V s/rad
+  float resistance;      // ohm per phase
+  float inductance;      // H per phase
+  float supply;          // V
+  float rotorInertia;    // kg m^2
+  float damping;         // N m s/rad at the rotor
+
+  // Drive train and load
+  double gearRatio;      // motor revolutions per output revolution
+  float loadInertia;     // kg m^2 at the output, mirror and frame
+  float backlash;        // degrees at the output
+  float coulombFriction; // N m at the output
+  float viscousFriction; // N m s/rad at the output
+
+  // Resonance: band of step rates, share of the torque lost once it has built up, and its time constant (s).
+  // A band of 0..0 has none.
+  float resonanceLow;
+  float resonanceHigh;
+  float resonanceDepth;
+  float resonanceBuildup;
+
+  // NEMA17 (17HS4401 class) on an A4988 at 12 V and 1 A, driving the given gear
+  static AxisPlant nema17A4988(const GearRatio& gear, float loadInertia, float backlash, float friction);
+};
+
+class MountModel
+{
+public:
+  MountModel();
+
+  void setAxis(uint8_t axis, const AxisPlant& plant, uint8_t stepPin, uint8_t dirPin);
+
+  // Play back the edges recorded since the last call and clear them; the model runs up to the last edge
+  void feed(PinGroup& pins);
+  // Run on without new edges until the given PinGroup time
+  void advance(uint32_t timeUs);
+
+  // Commanded position (microsteps, counted from the STEP edges) and where the mirror actually is
+  long commanded(uint8_t axis) const { return axes[axis].steps; }
+  double outputDegrees(uint8_t axis) const;
+  // Mirror position less commanded position, degrees at the output
+  double error(uint8_t axis) const;
+
+  // Microsteps lost to slipped poles, signed (negative: the rotor is behind)
+  long missedSteps(uint8_t axis) const;
+  // Largest electrical angle between rotor and current vector so far, in units of a quarter cycle: above 1 the
+  // motor was past its peak torque, above 2 it slipped
+  float peakLoadAngle(uint8_t axis) const { return axes[axis].peakLag; }
+  // Poles slipped either way, including slips the rotor later made up again, and when the first one happened
+  uint32_t slips(uint8_t axis) const { return axes[axis].slips; }
+  uint32_t firstSlipUs(uint8_t axis) const { return axes[axis].slipUs; }
+  // Largest share of the resonance that built up, 0..1
+  float peakResonance(uint8_t axis) const { return axes[axis].peakResonance; }
+
+  // Torque the motor can give at a speed (rad/s at the rotor), N m
+  static float pullOutTorque(const AxisPlant& plant, double radPerSec);
+
+private:
+  struct Axis
+  {
+    AxisPlant plant;
+    uint8_t stepPin;
+    uint8_t dirPin;
+    bool forward;
+    long steps;
+    double motor;     // rad
+    double motorRate;
+    double load;      // rad, referred to the motor side
+    double loadRate;
+    int8_t contact;   // 1: motor pushing forward on the load, -1: backward, 0: across the play
+    float peakLag;
+    long pole;        // electrical cycles the rotor is off the current vector
+    uint32_t slips;
+    uint32_t slipUs;
+    double resonance;
+    float peakResonance;
+  };
+
+  Axis axes[AXIS_COUNT];
+  uint32_t nowUs;
+  bool started;
+
+  void step(Axis& a, double dt);
+  double lag(const Axis& a) const;  // electrical radians the rotor trails the current vector
+};
+
+#endif  //ARDUINO_ARCH_ESP32
+
+#endif  //MOUNTMODEL_H
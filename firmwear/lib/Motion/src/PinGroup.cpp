@@ -0,0 +1,146 @@
+#include "PinGroup.h"
+#include "StepEngine.h"
+
+#ifdef ARDUINO_ARCH_ESP32
+#include <soc/gpio_struct.h>
+#endif
+
+PinGroup::PinGroup() : stepHigh(0), dirLevel(0)
+{
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    stepMask[i][0] = stepMask[i][1] = 0;
+    dirMask[i][0] = dirMask[i][1] = 0;
+  }
+#ifndef ARDUINO_ARCH_ESP32
+  edges = 0;
+  lost = 0;
+  mockTimeUs = 0;
+#endif
+}
+
+void PinGroup::begin(const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT], uint8_t dirBits)
+{
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    stepMask[i][0] = stepMask[i][1] = 0;
+    dirMask[i][0] = dirMask[i][1] = 0;
+    stepMask[i][stepPins[i] >> 5] = 1UL << (stepPins[i] & 31);
+    dirMask[i][dirPins[i] >> 5] = 1UL << (dirPins[i] & 31);
+#ifdef ARDUINO_ARCH_ESP32
+    pinMode(stepPins[i], OUTPUT);
+    pinMode(dirPins[i], OUTPUT);
+#else
+    pins[i][0] = stepPins[i];
+    pins[i][1] = dirPins[i];
+#endif
+  }
+
+  // Everything low, then DIR to its levels
+  uint32_t set[2] = { 0, 0 };
+  uint32_t clear[2] = { 0, 0 };
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    for (uint8_t b = 0; b < 2; b++)
+    {
+      clear[b] |= stepMask[i][b];
+      if (dirBits & (1 << i)) set[b] |= dirMask[i][b];
+      else clear[b] |= dirMask[i][b];
+    }
+  }
+  stepHigh = 0;
+  dirLevel = dirBits;
+  apply(set, clear);
+}
+
+void MOTION_ISR_ATTR PinGroup::write(uint8_t stepBits, uint8_t dirBits)
+{
+  uint32_t set[2] = { 0, 0 };
+  uint32_t clear[2] = { 0, 0 };
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    uint8_t bit = 1 << i;
+    for (uint8_t b = 0; b < 2; b++)
+    {
+      if (stepHigh & bit) clear[b] |= stepMask[i][b];
+      if (stepBits & bit) set[b] |= stepMask[i][b];
+    }
+  }
+  addDirEdges(dirBits, set, clear);
+  stepHigh = stepBits;
+  apply(set, clear);
+#ifndef ARDUINO_ARCH_ESP32
+  mockTimeUs += STEP_TICK_US;
+#endif
+}
+
+void MOTION_ISR_ATTR PinGroup::writeDir(uint8_t dirBits)
+{
+  uint32_t set[2] = { 0, 0 };
+  uint32_t clear[2] = { 0, 0 };
+  addDirEdges(dirBits, set, clear);
+  apply(set, clear);
+}
+
+void MOTION_ISR_ATTR PinGroup::addDirEdges(uint8_t dirBits, uint32_t set[2], uint32_t clear[2])
+{
+  uint8_t dirChanged = dirBits ^ dirLevel;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    uint8_t bit = 1 << i;
+    if (!(dirChanged & bit)) continue;
+    for (uint8_t b = 0; b < 2; b++)
+    {
+      if (dirBits & bit) set[b] |= dirMask[i][b];
+      else clear[b] |= dirMask[i][b];
+    }
+  }
+  dirLevel = dirBits;
+}
+
+#ifdef ARDUINO_ARCH_ESP32
+
+void MOTION_ISR_ATTR PinGroup::apply(uint32_t set[2], uint32_t clear[2])
+{
+  if (clear[0]) GPIO.out_w1tc = clear[0];
+  if (clear[1]) GPIO.out1_w1tc.val = clear[1];
+  if (set[0]) GPIO.out_w1ts = set[0];
+  if (set[1]) GPIO.out1_w1ts.val = set[1];
+}
+
+#else
+
+void PinGroup::clearEdges()
+{
+  edges = 0;
+  lost = 0;
+}
+
+void PinGroup::record(uint8_t pin, bool level)
+{
+  if (edges < PINGROUP_MOCK_EDGES)
+  {
+    PinEdge& e = recorded[edges++];
+    e.timeUs = mockTimeUs;
+    e.pin = pin;
+    e.level = level;
+  }
+  else lost++;
+}
+
+// Decode the masks back into per-pin edges, the way the set/clear registers would act on the pins
+void PinGroup::apply(uint32_t set[2], uint32_t clear[2])
+{
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    for (uint8_t p = 0; p < 2; p++)
+    {
+      uint8_t pin = pins[i][p];
+      uint32_t mask = 1UL << (pin & 31);
+      if (clear[pin >> 5] & mask) record(pin, false);
+      if (set[pin >> 5] & mask) record(pin, true);
+    }
+  }
+}
+
+#endif
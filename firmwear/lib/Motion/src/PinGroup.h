@@ -0,0 +1,73 @@
+//======================================================================================================================
+// PinGroup
+//
+// The STEP and DIR lines of all axes as one group. write() applies a whole engine tick at once: STEP lines raised on
+// the previous tick fall, DIR lines take their new levels and the new STEP lines rise, using one write to the GPIO
+// "set" register and one to the "clear" register per bank instead of a digitalWrite per pin. Both axes therefore
+// step on the same edge, and a tick costs a handful of cycles in the ISR.
+//
+// On the host the group records every edge with a timestamp instead, so pulse timing can be checked off-device.
+// The mock clock advances by STEP_TICK_US per write(), matching one call per engine tick.
+//======================================================================================================================
+
+#ifndef PINGROUP_H
+#define PINGROUP_H
+
+#include <stdint.h>
+#include "MotionPort.h"
+#include "MotionTypes.h"
+
+#ifndef ARDUINO_ARCH_ESP32
+#define PINGROUP_MOCK_EDGES 4096
+
+struct PinEdge
+{
+  uint32_t timeUs;
+  uint8_t pin;
+  bool level;
+};
+#endif
+
+class PinGroup
+{
+public:
+  PinGroup();
+
+  // Configure the pins as outputs, STEP low and DIR at the given levels (bit set = high)
+  void begin(const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT], uint8_t dirBits);
+
+  // One engine tick: the STEP bits to raise and the DIR levels
+  void write(uint8_t stepBits, uint8_t dirBits);
+
+  // DIR levels only, STEP lines left alone
+  void writeDir(uint8_t dirBits);
+
+#ifndef ARDUINO_ARCH_ESP32
+  uint32_t edgeCount() const { return edges; }
+  const PinEdge& edge(uint32_t i) const { return recorded[i]; }
+  bool overflowed() const { return lost > 0; }
+  void clearEdges();
+  uint32_t timeUs() const { return mockTimeUs; }
+#endif
+
+private:
+  // Pin masks per GPIO bank (pins 0-31, 32 and up)
+  uint32_t stepMask[AXIS_COUNT][2];
+  uint32_t dirMask[AXIS_COUNT][2];
+  uint8_t stepHigh;
+  uint8_t dirLevel;
+
+  void addDirEdges(uint8_t dirBits, uint32_t set[2], uint32_t clear[2]);
+  void apply(uint32_t set[2], uint32_t clear[2]);
+
+#ifndef ARDUINO_ARCH_ESP32
+  uint8_t pins[AXIS_COUNT][2];  // step, dir
+  PinEdge recorded[PINGROUP_MOCK_EDGES];
+  uint32_t edges;
+  uint32_t lost;
+  uint32_t mockTimeUs;
+  void record(uint8_t pin, bool level);
+#endif
+};
+
+#endif  //PINGROUP_H
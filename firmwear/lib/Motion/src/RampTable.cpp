@@ -0,0 +1,22 @@
+#include "RampTable.h"
+
+// s(t) = 2t^2 for t < 1/2, 1 - 2(1 - t)^2 after; regenerate with tools/ramp_table.cpp --table
+const uint32_t MOTION_ISR_DATA scurveTable[SCURVE_TABLE_SIZE + 1] = {
+  0, 32, 128, 288, 512, 800, 1152, 1568,
+  2048, 2592, 3200, 3872, 4608, 5408, 6272, 7200,
+  8192, 9248, 10368, 11552, 12800, 14112, 15488, 16928,
+  18432, 20000, 21632, 23328, 25088, 26912, 28800, 30752,
+  32768, 34784, 36736, 38624, 40448, 42208, 43904, 45536,
+  47104, 48608, 50048, 51424, 52736, 53984, 55168, 56288,
+  57344, 58336, 59264, 60128, 60928, 61664, 62336, 62944,
+  63488, 63968, 64384, 64736, 65024, 65248, 65408, 65504,
+  65536,
+};
+
+uint32_t MOTION_ISR_ATTR scurveFraction(uint32_t pos)
+{
+  uint32_t i = pos >> 16;
+  if (i >= SCURVE_TABLE_SIZE) return 0xFFFFFFFFUL;
+  uint32_t frac = pos & 0xFFFF;
+  return (scurveTable[i] << 16) + (scurveTable[i + 1] - scurveTable[i]) * frac;
+}
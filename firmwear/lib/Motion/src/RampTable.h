@@ -0,0 +1,28 @@
+//======================================================================================================================
+// RampTable
+//
+// Precomputed S-curve for jerk-limited ramps. scurveTable[k] is the fraction (Q16) of a rate change completed after
+// k/SCURVE_TABLE_SIZE of the ramp time: constant jerk up to the midpoint, constant negative jerk after it, so the
+// acceleration rises and falls as a triangle instead of switching on and off at the ramp corners. Its mean is half
+// the peak, so a ramp takes twice as long as a trapezoid at the same peak acceleration.
+//
+// The step ISR walks the table with a fixed-point position and interpolates linearly between entries, so a ramp
+// costs one division when it starts and only multiplies and shifts per tick.
+//======================================================================================================================
+
+#ifndef RAMPTABLE_H
+#define RAMPTABLE_H
+
+#include <stdint.h>
+#include "MotionPort.h"
+
+#define SCURVE_TABLE_SIZE 64
+#define SCURVE_ONE 65536UL
+
+extern const uint32_t scurveTable[SCURVE_TABLE_SIZE + 1];
+
+// Fraction of the rate change at table position pos (pos >> 16 is the entry index), interpolated to Q32 so slow
+// ramps still change the rate a little on every tick
+uint32_t scurveFraction(uint32_t pos);
+
+#endif  //RAMPTABLE_H
@@ -0,0 +1,116 @@
+#include "RmtEncoder.h"
+
+RmtEncoder::RmtEncoder(uint16_t tickDuration, uint16_t pulseDuration)
+    : tickDuration(tickDuration), pulseDuration(pulseDuration), out(0), capacity(0), count(0), halfFilled(false),
+      overflow(false), runLevel(0), runDuration(0)
+{
+}
+
+void RmtEncoder::begin(RmtSymbol* buffer, size_t size)
+{
+  out = buffer;
+  capacity = size;
+  count = 0;
+  halfFilled = false;
+  overflow = false;
+  runLevel = 0;
+  runDuration = 0;
+}
+
+bool RmtEncoder::emit(uint8_t level, uint16_t duration)
+{
+  if (halfFilled)
+  {
+    out[count].level1 = level;
+    out[count].duration1 = duration;
+    halfFilled = false;
+    count++;
+    return true;
+  }
+  if (count >= capacity)
+  {
+    overflow = true;
+    return false;
+  }
+  out[count].level0 = level;
+  out[count].duration0 = duration;
+  halfFilled = true;
+  return true;
+}
+
+// Write out the open run, split into chunks the 15-bit duration fields can hold
+void RmtEncoder::flushRun()
+{
+  while (runDuration > 0)
+  {
+    uint16_t chunk = runDuration > RMT_MAX_DURATION ? RMT_MAX_DURATION : runDuration;
+    if (!emit(runLevel, chunk)) return;
+    runDuration -= chunk;
+  }
+}
+
+bool RmtEncoder::addTick(bool step)
+{
+  if (overflow) return false;
+
+  if (!step)
+  {
+    // Low for the whole tick: extend the open low run
+    if (runLevel != 0)
+    {
+      flushRun();
+      runLevel = 0;
+    }
+    runDuration += tickDuration;
+  }
+  else
+  {
+    // High for the pulse, low for the rest of the tick
+    flushRun();
+    runLevel = 1;
+    runDuration = pulseDuration;
+    flushRun();
+    runLevel = 0;
+    runDuration = tickDuration - pulseDuration;
+  }
+  return !overflow;
+}
+
+size_t RmtEncoder::finish()
+{
+  flushRun();
+  if (halfFilled && !overflow)
+  {
+    out[count].level1 = 0;
+    out[count].duration1 = 0;
+    halfFilled = false;
+    count++;
+  }
+  return count;
+}
+
+// Half-symbols a run of the given length takes
+static uint32_t chunks(uint32_t duration)
+{
+  return (duration + RMT_MAX_DURATION - 1) / RMT_MAX_DURATION;
+}
+
+bool RmtEncoder::hasRoom() const
+{
+  if (overflow) return false;
+  // At most: the open run, grown by a tick or flushed before a pulse, then the pulse and the low rest of the tick
+  size_t free = 2 * (capacity - count) - (halfFilled ? 1 : 0);
+  return free >= chunks(runDuration + tickDuration) + 2;
+}
+
+uint32_t RmtEncoder::leadTrimmable() const
+{
+  if (count == 0 || out[0].level0 != 0) return 0;
+  return out[0].duration0 - 1;
+}
+
+void RmtEncoder::trimLead(uint32_t duration)
+{
+  uint32_t most = leadTrimmable();
+  out[0].duration0 -= duration < most ? duration : most;
+}
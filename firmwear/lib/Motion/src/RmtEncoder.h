@@ -0,0 +1,72 @@
+//======================================================================================================================
+// RmtEncoder
+//
+// Turns the per-tick step decisions of the step engine into RMT symbols for one STEP line, so the pulse train can be
+// played back by the RMT peripheral instead of being bit-banged from a timer ISR.
+//
+// The output is a sequence of (level, duration) runs packed two per symbol, in the layout of rmt_item32_t. Every
+// engine tick is accounted for, so a batch lasts exactly ticks * tickDuration and consecutive batches line up.
+// A batch that starts late can make up for it by starting with a shorter low run (see trimLead).
+// Pure C++: no hardware access.
+//======================================================================================================================
+
+#ifndef RMTENCODER_H
+#define RMTENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Same bit layout as rmt_item32_t
+struct RmtSymbol
+{
+  uint32_t duration0 : 15;
+  uint32_t level0 : 1;
+  uint32_t duration1 : 15;
+  uint32_t level1 : 1;
+};
+
+#define RMT_MAX_DURATION 32767
+
+class RmtEncoder
+{
+public:
+  // Durations in RMT clock ticks: one engine tick, and the STEP high time (shorter than a tick)
+  RmtEncoder(uint16_t tickDuration, uint16_t pulseDuration);
+
+  // Start a batch writing into out[0..capacity)
+  void begin(RmtSymbol* out, size_t capacity);
+
+  // Account for one engine tick, with or without a step on this line. Returns false once the buffer is full.
+  bool addTick(bool step);
+
+  // Room for one more tick and finish(), whatever the tick brings. A caller that stops ticking the engine once this
+  // is false never loses a step to a full buffer.
+  bool hasRoom() const;
+
+  // Close the batch; returns the number of symbols written. A half-filled last symbol is terminated with a zero
+  // duration, which is also the RMT end marker.
+  size_t finish();
+
+  // After finish(): how far the low run the batch starts with can be shortened (RMT ticks; it keeps at least one),
+  // and shortening it
+  uint32_t leadTrimmable() const;
+  void trimLead(uint32_t duration);
+
+  bool overflowed() const { return overflow; }
+
+private:
+  uint16_t tickDuration;
+  uint16_t pulseDuration;
+  RmtSymbol* out;
+  size_t capacity;
+  size_t count;
+  bool halfFilled;  // out[count] has its first half set
+  bool overflow;
+  uint8_t runLevel;
+  uint32_t runDuration;
+
+  void flushRun();
+  bool emit(uint8_t level, uint16_t duration);
+};
+
+#endif  //RMTENCODER_H
@@ -0,0 +1,57 @@
+//======================================================================================================================
+// SegmentQueue
+//
+// Lock-free single-producer/single-consumer ring buffer. The planner (main loop) pushes, the step ISR pops. Each side
+// only writes its own index, and the index is published with release ordering after the slot has been written or
+// read, so neither side ever needs a critical section.
+//
+// N must be a power of two. The indices run freely and wrap modulo 2^32, so all N slots are usable.
+//======================================================================================================================
+
+#ifndef SEGMENTQUEUE_H
+#define SEGMENTQUEUE_H
+
+#include <stdint.h>
+#include <atomic>
+#include "MotionPort.h"
+
+template <typename T, uint32_t N>
+class SegmentQueue
+{
+  static_assert(N > 0 && (N & (N - 1)) == 0, "SegmentQueue size must be a power of two");
+
+public:
+  SegmentQueue() : head(0), tail(0) {}
+
+  // Producer side
+  bool push(const T& item)
+  {
+    uint32_t h = head.load(std::memory_order_relaxed);
+    if (h - tail.load(std::memory_order_acquire) == N) return false;  // full
+    slots[h & (N - 1)] = item;
+    head.store(h + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Consumer side
+  bool MOTION_ISR_ATTR pop(T& item)
+  {
+    uint32_t t = tail.load(std::memory_order_relaxed);
+    if (t == head.load(std::memory_order_acquire)) return false;  // empty
+    item = slots[t & (N - 1)];
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Either side; a snapshot that may be stale by the time it is used
+  uint32_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+  bool empty() const { return size() == 0; }
+  static uint32_t capacity() { return N; }
+
+private:
+  T slots[N];
+  std::atomic<uint32_t> head;  // next slot to write, owned by the producer
+  std::atomic<uint32_t> tail;  // next slot to read, owned by the consumer
+};
+
+#endif  //SEGMENTQUEUE_H
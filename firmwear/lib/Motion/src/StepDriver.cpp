@@ -0,0 +1,154 @@
+#ifdef ARDUINO_ARCH_ESP32
+
+#include <Arduino.h>
+#include <driver/rmt.h>
+#include "StepDriver.h"
+#include "RmtEncoder.h"
+#include "PinGroup.h"
+
+// Shared by both backends; only one of them is started
+static StepEngine* engine = NULL;
+static PinGroup pins;
+
+//======================================================================================================================
+// Timer backend
+//======================================================================================================================
+
+static hw_timer_t* stepTimer = NULL;
+
+// One batched write per tick: the STEP lines raised on the previous tick drop as the new ones rise, so the pulse is
+// one tick wide and both axes step on the same edge
+void IRAM_ATTR TimerStepDriver::onTimer()
+{
+  uint8_t stepBits = engine->tick();
+  pins.write(stepBits, engine->dirMask());
+}
+
+bool TimerStepDriver::begin(StepEngine& e, const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT])
+{
+  engine = &e;
+  pins.begin(stepPins, dirPins, e.dirMask());
+
+  stepTimer = timerBegin(0, 80, true);  // 80 MHz APB / 80 = 1 us per count
+  if (stepTimer == NULL) return false;
+  timerAttachInterrupt(stepTimer, &TimerStepDriver::onTimer, true);
+  timerAlarmWrite(stepTimer, STEP_TICK_US, true);
+  timerAlarmEnable(stepTimer);
+  return true;
+}
+
+//======================================================================================================================
+// RMT backend
+//======================================================================================================================
+
+static const rmt_channel_t rmtChannel[AXIS_COUNT] = { RMT_CHANNEL_0, RMT_CHANNEL_1 };
+static RmtSymbol rmtBuffer[2][AXIS_COUNT][RMT_BATCH_SYMBOLS];  // double buffered: encode one while the other plays
+static size_t rmtCount[2][AXIS_COUNT];
+static RmtEncoder rmtEncoder[2][AXIS_COUNT] = {
+  { RmtEncoder(STEP_TICK_US, RMT_PULSE_US), RmtEncoder(STEP_TICK_US, RMT_PULSE_US) },
+  { RmtEncoder(STEP_TICK_US, RMT_PULSE_US), RmtEncoder(STEP_TICK_US, RMT_PULSE_US) }
+};
+
+bool RmtStepDriver::begin(StepEngine& e, const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT])
+{
+  static_assert(sizeof(RmtSymbol) == sizeof(rmt_item32_t), "RmtSymbol must match rmt_item32_t");
+  engine = &e;
+  pins.begin(stepPins, dirPins, e.dirMask());
+
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    rmt_config_t config = RMT_DEFAULT_CONFIG_TX((gpio_num_t)stepPins[i], rmtChannel[i]);
+    config.clk_div = 80;  // 80 MHz APB / 80 = 1 us per RMT tick
+    if (rmt_config(&config) != ESP_OK) return false;
+    if (rmt_driver_install(rmtChannel[i], 0, 0) != ESP_OK) return false;
+  }
+
+  // Same core as the Arduino loop, above it in priority: it preempts the loop just like the timer ISR would
+  return xTaskCreatePinnedToCore(&RmtStepDriver::task, "rmtStep", 4096, this, configMAX_PRIORITIES - 2, NULL,
+                                 ARDUINO_RUNNING_CORE) == pdPASS;
+}
+
+void RmtStepDriver::task(void* arg)
+{
+  static_cast<RmtStepDriver*>(arg)->run();
+}
+
+// Tick the engine for up to one batch. Returns the number of ticks, and the DIR levels the batch must be played with.
+uint16_t RmtStepDriver::encodeBatch(uint8_t buffer, uint8_t& dirBits)
+{
+  RmtEncoder* encoder = rmtEncoder[buffer];
+  dirBits = engine->dirMask();
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    encoder[i].begin(rmtBuffer[buffer][i], RMT_BATCH_SYMBOLS);
+
+  uint16_t ticks = 0;
+  while (ticks < RMT_BATCH_TICKS)
+  {
+    // A tick is only taken from the engine if every line has room for it, so no step is dropped: at worst the batch
+    // ends early
+    bool room = true;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      room = room && encoder[i].hasRoom();
+    if (!room)
+    {
+      shortBatches++;
+      break;
+    }
+
+    uint8_t stepBits = engine->tick();
+    ticks++;
+    bool lost = false;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      if (!encoder[i].addTick(stepBits & (1 << i))) lost = true;
+    if (lost) lostTicks++;
+    // The engine never steps an axis on the tick its DIR changes, so the batch can end right here
+    if (engine->dirMask() != dirBits) break;
+  }
+
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    rmtCount[buffer][i] = encoder[i].finish();
+  return ticks;
+}
+
+void RmtStepDriver::run()
+{
+  uint8_t buffer = 0;
+  bool started = false;
+  uint32_t due = 0;  // micros() at which the batch should start to keep time with the engine
+  for (;;)
+  {
+    uint8_t dirBits;
+    uint16_t ticks = encodeBatch(buffer, dirBits);
+
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      rmt_wait_tx_done(rmtChannel[i], portMAX_DELAY);
+    pins.writeDir(dirBits);
+
+    // Take the time this batch is starting late out of its leading idle run, the same on every line so the axes
+    // stay in step. More than a batch late, the task was held up, and that time is given up instead.
+    uint32_t now = micros();
+    int32_t late = (int32_t)(now - due);
+    if (!started || late > (int32_t)(RMT_BATCH_TICKS * STEP_TICK_US))
+    {
+      started = true;
+      due = now;
+      late = 0;
+    }
+    uint32_t trim = late > 0 ? (uint32_t)late : 0;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      uint32_t most = rmtEncoder[buffer][i].leadTrimmable();
+      if (most < trim) trim = most;
+    }
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      rmtEncoder[buffer][i].trimLead(trim);
+      const rmt_item32_t* items = reinterpret_cast<const rmt_item32_t*>(rmtBuffer[buffer][i]);
+      rmt_write_items(rmtChannel[i], items, rmtCount[buffer][i], false);
+    }
+    due += (uint32_t)ticks * STEP_TICK_US;
+    buffer ^= 1;
+  }
+}
+
+#endif
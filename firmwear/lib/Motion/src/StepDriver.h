@@ -0,0 +1,66 @@
+//======================================================================================================================
+// StepDriver
+//
+// Hardware backends that turn StepEngine ticks into STEP/DIR signals:
+//  - TimerStepDriver ticks the engine from a hardware timer ISR and writes the pins directly, all edges of a tick in
+//    one batched register write (PinGroup)
+//  - RmtStepDriver ticks the engine ahead of time in batches from a high-priority task, encodes each STEP line with
+//    RmtEncoder and lets the RMT peripheral play the pulse trains back, so WiFi interrupts cannot add jitter and the
+//    CPU is not interrupted every tick. DIR changes end a batch and are written once the previous batch has gone out.
+//    Each batch is encoded while the previous one plays, but the task only wakes to start it after the previous one
+//    has ended, so every batch starts a little late. The lateness is taken out of the idle time the next batch
+//    starts with, so the pulse trains keep time with the engine; what cannot be taken out there carries over.
+//
+// The engine API must only be used from the core the driver runs on (the Arduino loop core), as the engine relies on
+// critical sections there to keep its state consistent with tick().
+//======================================================================================================================
+
+#ifndef STEPDRIVER_H
+#define STEPDRIVER_H
+
+#include "StepEngine.h"
+
+class StepDriver
+{
+public:
+  virtual ~StepDriver() {}
+  virtual bool begin(StepEngine& engine, const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT]) = 0;
+
+  // Output faults since start: batches cut short, or ticks that could not be encoded
+  virtual uint32_t faults() const { return 0; }
+};
+
+#ifdef ARDUINO_ARCH_ESP32
+
+class TimerStepDriver : public StepDriver
+{
+public:
+  bool begin(StepEngine& engine, const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT]);
+
+private:
+  static void onTimer();
+};
+
+#define RMT_BATCH_TICKS 400  // 10 ms of engine ticks per RMT batch
+#define RMT_BATCH_SYMBOLS (RMT_BATCH_TICKS / 2 + 8)
+#define RMT_PULSE_US 3
+
+class RmtStepDriver : public StepDriver
+{
+public:
+  RmtStepDriver() : shortBatches(0), lostTicks(0) {}
+  bool begin(StepEngine& engine, const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT]);
+  uint32_t faults() const { return shortBatches + lostTicks; }
+
+private:
+  volatile uint32_t shortBatches;  // ended early because an encoder buffer was nearly full
+  volatile uint32_t lostTicks;     // ticks an encoder had no room for; their steps are missing from the output
+
+  static void task(void* arg);
+  void run();
+  uint16_t encodeBatch(uint8_t buffer, uint8_t& dirBits);
+};
+
+#endif
+
+#endif  //STEPDRIVER_H
@@ -0,0 +1,737 @@
+#include "StepEngine.h"
+#include <math.h>
+
+void StepRamp::reset()
+{
+  phaseInc = 0;
+  rampSteps = 0;
+  accelFrac = 0;
+  fromInc = 0;
+  toInc = 0;
+  curvePos = 0;
+  curveStep = 0;
+}
+
+// One tick of constant acceleration; the fraction of a phase unit left over carries to the next tick
+uint32_t MOTION_ISR_ATTR StepRamp::rampToward(uint32_t inc, uint32_t want)
+{
+  if (accelInc == 0) return want;
+  accelFrac += accelInc;
+  uint32_t step = accelFrac >> STEP_ACCEL_FRAC_BITS;
+  accelFrac &= (1UL << STEP_ACCEL_FRAC_BITS) - 1;
+  if (inc < want) return want - inc > step ? inc + step : want;
+  return inc - want > step ? inc - step : want;
+}
+
+uint32_t MOTION_ISR_ATTR StepRamp::curveToward(uint32_t inc, uint32_t want)
+{
+  if (inc == want)
+  {
+    curveStep = 0;
+    return want;
+  }
+  if (curveStep == 0 || want != toInc)
+  {
+    // New transition from the current rate, lasting as long as a trapezoid at the mean acceleration would
+    fromInc = inc;
+    toInc = want;
+    uint64_t delta = want > inc ? want - inc : inc - want;
+    uint32_t ticks = (uint32_t)((delta << STEP_ACCEL_FRAC_BITS) / accelInc);
+    curveStep = ((uint32_t)SCURVE_TABLE_SIZE << 16) / (ticks > 0 ? ticks : 1);
+    if (curveStep == 0) curveStep = 1;
+    curvePos = 0;
+  }
+
+  curvePos += curveStep;
+  if (curvePos >= (uint32_t)SCURVE_TABLE_SIZE << 16)
+  {
+    curveStep = 0;
+    return toInc;
+  }
+  uint32_t delta = toInc > fromInc ? toInc - fromInc : fromInc - toInc;
+  uint32_t done = (uint32_t)(((uint64_t)delta * scurveFraction(curvePos)) >> 32);
+  return toInc > fromInc ? fromInc + done : fromInc - done;
+}
+
+bool MOTION_ISR_ATTR StepRamp::advance(uint32_t want)
+{
+  // Anything up to the start rate is reached without a ramp
+  uint32_t prevInc = phaseInc;
+  if (prevInc < startInc) prevInc = want < startInc ? want : startInc;
+  if (shape != RAMP_SCURVE || accelInc == 0) phaseInc = rampToward(prevInc, want);
+  else if (prevInc <= startInc && want <= startInc)
+  {
+    phaseInc = want;
+    curveStep = 0;
+  }
+  else phaseInc = curveToward(prevInc, want < startInc ? startInc : want);
+
+  uint32_t prev = phase;
+  phase += phaseInc;
+  if (phase >= prev) return false;  // no wrap, no step due
+
+  if (phaseInc <= startInc) rampSteps = 0;
+  else if (phaseInc > prevInc) rampSteps++;
+  else if (phaseInc < prevInc && rampSteps > 0) rampSteps--;
+  return true;
+}
+
+StepEngine::StepEngine() : lineExitInc(0), lineDecelAfter(0), lineTicksLeft(0), lineActive(false), lineStopping(false), dirBits(0), lock(MOTION_LOCK_INIT)
+{
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    Axis& a = axes[i];
+    a.mode = MODE_IDLE;
+    a.forward = true;
+    a.position = 0;
+    a.target = 0;
+    a.approachTarget = 0;
+    a.ramp.cruiseInc = 0;
+    a.ramp.startInc = 0;
+    a.ramp.accelInc = 0;
+    a.ramp.shape = RAMP_TRAPEZOID;
+    a.ramp.phase = 0;
+    a.ramp.reset();
+    a.startRate = 0;
+    a.accel = 0;
+    a.maxRate = STEP_MAX_RATE;
+    for (uint8_t b = 0; b < STEP_RESONANCE_BANDS; b++)
+      a.bandLow[b] = a.bandHigh[b] = 0;
+    a.backlash = 0;
+    a.approach = BACKLASH_TAKEUP;
+    a.loadDir = 0;
+    a.takeup = 0;
+    a.takeupPhase = 0;
+    planned[i] = 0;
+  }
+  lineRamp.cruiseInc = 0;
+  lineRamp.startInc = 0;
+  lineRamp.accelInc = 0;
+  lineRamp.shape = RAMP_TRAPEZOID;
+  lineRamp.phase = 0;
+  lineRamp.reset();
+}
+
+uint32_t StepEngine::rateToPhaseInc(float stepsPerSec)
+{
+  if (stepsPerSec <= 0) return 0;
+  if (stepsPerSec >= STEP_MAX_RATE) return 0x80000000UL;
+  return (uint32_t)(stepsPerSec * (4294967296.0f / STEP_TICK_HZ));
+}
+
+uint32_t StepEngine::accelToPhaseInc(float accel)
+{
+  // Rate change per tick: accel * 2^32 / STEP_TICK_HZ^2, with fraction bits
+  float inc = accel * (4294967296.0f * (1UL << STEP_ACCEL_FRAC_BITS) / STEP_TICK_HZ / STEP_TICK_HZ);
+  if (accel <= 0) return 0;
+  return inc < 1 ? 1 : (uint32_t)(inc + 0.5f);
+}
+
+// A ramp needs a start rate above 0 to come down to at a target; without one, a tick's worth of acceleration
+uint32_t StepEngine::minStartInc(uint32_t startInc, uint32_t accelInc)
+{
+  if (startInc > 0) return startInc;
+  uint32_t inc = accelInc >> STEP_ACCEL_FRAC_BITS;
+  return inc > 0 ? inc : 1;
+}
+
+void StepEngine::getLimits(float startRate[AXIS_COUNT], float accel[AXIS_COUNT], float maxRate[AXIS_COUNT]) const
+{
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    startRate[i] = axes[i].startRate;
+    accel[i] = axes[i].accel;
+    maxRate[i] = axes[i].maxRate;
+  }
+}
+
+// Highest rate a move of the given length can reach between its entry and exit rates
+float StepEngine::peakRate(unsigned long steps, float entry, float exit, float accel)
+{
+  return sqrtf((2 * accel * steps + entry * entry + exit * exit) / 2);
+}
+
+// Major-axis step at which a line of the given length has to start ramping down to reach its exit rate. If the line
+// is too short to reach its cruise rate, the ramps meet at the peak rate the length allows. Rounded to start early
+// rather than late, so a leg reaches its exit rate instead of handing over above it.
+uint32_t StepEngine::decelPoint(unsigned long steps, float entry, float cruise, float exit, float accel)
+{
+  if (accel <= 0) return steps;
+  float peak = peakRate(steps, entry, exit, accel);
+  if (cruise > peak) cruise = peak;
+  float decel = (cruise * cruise - exit * exit) / (2 * accel);
+  if (decel <= 0) return steps;
+  if (decel >= steps) return 0;
+  return steps - (uint32_t)ceilf(decel);
+}
+
+void StepEngine::setProfile(uint8_t axis, float startRate, float accel, float maxRate, RampShape shape)
+{
+  if (shape == RAMP_FIXED) accel = 0;
+  if (shape == RAMP_SCURVE) accel /= 2;
+  uint32_t accelInc = accelToPhaseInc(accel);
+  uint32_t startInc = rateToPhaseInc(startRate);
+
+  Axis& a = axes[axis];
+  motionLock(&lock);
+  a.startRate = startRate;
+  a.accel = accel;
+  a.maxRate = maxRate;
+  a.ramp.accelInc = accelInc;
+  a.ramp.startInc = minStartInc(startInc, accelInc);
+  a.ramp.shape = shape;
+  a.ramp.curveStep = 0;
+  motionUnlock(&lock);
+}
+
+void StepEngine::setResonanceBand(uint8_t axis, uint8_t band, float lowRate, float highRate)
+{
+  if (band >= STEP_RESONANCE_BANDS) return;
+  if (lowRate > highRate)
+  {
+    float t = lowRate;
+    lowRate = highRate;
+    highRate = t;
+  }
+  axes[axis].bandLow[band] = lowRate;
+  axes[axis].bandHigh[band] = highRate;
+}
+
+float StepEngine::clearOfBands(uint8_t axis, float stepsPerSec) const
+{
+  const Axis& a = axes[axis];
+  // Bands may overlap, so keep going until the rate is below all of them
+  for (uint8_t pass = 0; pass < STEP_RESONANCE_BANDS; pass++)
+  {
+    bool moved = false;
+    for (uint8_t b = 0; b < STEP_RESONANCE_BANDS; b++)
+    {
+      if (stepsPerSec > a.bandLow[b] && stepsPerSec < a.bandHigh[b])
+      {
+        stepsPerSec = a.bandLow[b];
+        moved = true;
+      }
+    }
+    if (!moved) break;
+  }
+  return stepsPerSec;
+}
+
+// Highest major-axis rate up to the given one at which no axis of the line cruises in a band. Lowering it for one
+// axis can drop another into a band of its own, so repeat until nothing moves.
+float StepEngine::clearOfBands(const LineMove& plan, float majorRate) const
+{
+  for (uint8_t pass = 0; pass < AXIS_COUNT * STEP_RESONANCE_BANDS; pass++)
+  {
+    bool moved = false;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      if (plan.steps(i) == 0) continue;
+      float ratio = (float)plan.steps(i) / plan.length();
+      float clear = clearOfBands(i, majorRate * ratio);
+      if (clear < majorRate * ratio)
+      {
+        majorRate = clear / ratio;
+        moved = true;
+      }
+    }
+    if (!moved) break;
+  }
+  return majorRate;
+}
+
+float StepEngine::rate(uint8_t axis) const
+{
+  float toRate = (float)STEP_TICK_HZ / 4294967296.0f;
+  if (lineActive) return line.done() ? 0 : lineRamp.phaseInc * toRate * line.steps(axis) / line.length();
+  if (axes[axis].mode == MODE_IDLE) return 0;
+  return axes[axis].ramp.phaseInc * toRate;
+}
+
+void StepEngine::run(uint8_t axis, bool forward, float stepsPerSec)
+{
+  Axis& a = axes[axis];
+  if (stepsPerSec > a.maxRate) stepsPerSec = a.maxRate;
+  stepsPerSec = clearOfBands(axis, stepsPerSec);
+  motionLock(&lock);
+  requestSegmentStop();
+  a.forward = forward;
+  a.ramp.cruiseInc = rateToPhaseInc(stepsPerSec);
+  a.mode = MODE_RUN;
+  motionUnlock(&lock);
+}
+
+void StepEngine::setVelocity(uint8_t axis, float stepsPerSec)
+{
+  Axis& a = axes[axis];
+  bool forward = stepsPerSec >= 0;
+  if (!forward) stepsPerSec = -stepsPerSec;
+  if (stepsPerSec > a.maxRate) stepsPerSec = a.maxRate;
+  stepsPerSec = clearOfBands(axis, stepsPerSec);
+  motionLock(&lock);
+  requestSegmentStop();
+  a.forward = forward;
+  a.ramp.cruiseInc = rateToPhaseInc(stepsPerSec);
+  a.mode = MODE_VELOCITY;
+  motionUnlock(&lock);
+}
+
+void StepEngine::moveTo(uint8_t axis, long target, float stepsPerSec)
+{
+  Axis& a = axes[axis];
+  if (stepsPerSec > a.maxRate) stepsPerSec = a.maxRate;
+  long via = target - approachOvershoot(axis, target - a.position);
+  if (a.ramp.shape == RAMP_SCURVE && a.accel > 0 && a.mode == MODE_IDLE)
+  {
+    // An S-curve cannot turn round mid-ramp without a jump in acceleration, so on a short move aim for the peak the
+    // distance allows and let the curve finish before the ramp down starts
+    long distance = via - a.position;
+    float peak = peakRate(distance < 0 ? -distance : distance, a.startRate, a.startRate, a.accel);
+    if (stepsPerSec > peak) stepsPerSec = peak;
+  }
+  stepsPerSec = clearOfBands(axis, stepsPerSec);
+  motionLock(&lock);
+  requestSegmentStop();
+  a.target = via;
+  a.approachTarget = target;
+  a.ramp.cruiseInc = rateToPhaseInc(stepsPerSec);
+  a.mode = MODE_POSITION;
+  motionUnlock(&lock);
+}
+
+void StepEngine::requestSegmentStop()
+{
+  if (lineActive || !queue.empty()) lineStopping = true;
+}
+
+// Common checks for queueing; fills in the relative move from the planned position
+bool StepEngine::beginQueue(long azTarget, long elTarget, StepSegment& seg)
+{
+  if (lineStopping) return false;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    if (axes[i].mode != MODE_IDLE) return false;
+
+  // Nothing queued or running: plan from where the axes actually are. The ISR pops a segment and marks it active
+  // in one go, so checking the queue before the active flag cannot miss a segment in flight.
+  if (queue.empty() && !lineActive)
+  {
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      planned[i] = axes[i].position;
+  }
+
+  seg.steps[AXIS_AZ] = azTarget - planned[AXIS_AZ];
+  seg.steps[AXIS_EL] = elTarget - planned[AXIS_EL];
+  return true;
+}
+
+// Distance to overshoot a move by so it arrives from the axis's approach side; 0 if it does already
+long StepEngine::approachOvershoot(uint8_t axis, long distance) const
+{
+  const Axis& a = axes[axis];
+  if (a.approach == BACKLASH_APPROACH_FORWARD && distance < 0) return a.backlash;
+  if (a.approach == BACKLASH_APPROACH_REVERSE && distance > 0) return -(long)a.backlash;
+  return 0;
+}
+
+bool StepEngine::queueLine(long azTarget, long elTarget, float entryRate, float exitRate)
+{
+  StepSegment seg;
+  if (!beginQueue(azTarget, elTarget, seg)) return false;
+
+  // A line that ends at rest on the wrong side goes past the target and comes back from the approach side
+  long via[AXIS_COUNT] = { azTarget, elTarget };
+  bool overshoot = false;
+  for (uint8_t i = 0; i < AXIS_COUNT && exitRate <= 0; i++)
+  {
+    long over = approachOvershoot(i, seg.steps[i]);
+    via[i] -= over;
+    if (over != 0) overshoot = true;
+  }
+  if (!overshoot) return pushLine(azTarget, elTarget, entryRate, exitRate);
+  if (queue.size() + 2 > STEP_QUEUE_SIZE) return false;
+  return pushLine(via[AXIS_AZ], via[AXIS_EL], entryRate, 0) && pushLine(azTarget, elTarget, 0, 0);
+}
+
+bool StepEngine::pushLine(long azTarget, long elTarget, float entryRate, float exitRate)
+{
+  StepSegment seg;
+  if (!beginQueue(azTarget, elTarget, seg)) return false;
+
+  long from[AXIS_COUNT] = { 0, 0 };
+  LineMove plan;
+  plan.begin(from, seg.steps);
+  if (plan.done()) return true;
+
+  float startRate[AXIS_COUNT], accel[AXIS_COUNT], maxRate[AXIS_COUNT];
+  getLimits(startRate, accel, maxRate);
+  float lineStart = plan.majorLimit(startRate);
+  float lineAccel = plan.majorLimit(accel);
+  float lineCruise = plan.majorLimit(maxRate);
+  if (entryRate < lineStart) entryRate = lineStart;
+  if (exitRate < lineStart) exitRate = lineStart;
+
+  // Smooth the line if any axis it moves asks for it. Like moveTo, an S-curve aims for the peak of a short line.
+  seg.shape = RAMP_TRAPEZOID;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    if (plan.steps(i) > 0 && axes[i].ramp.shape == RAMP_SCURVE) seg.shape = RAMP_SCURVE;
+  if (seg.shape == RAMP_SCURVE && lineAccel > 0)
+  {
+    float peak = peakRate(plan.length(), entryRate, exitRate, lineAccel);
+    if (lineCruise > peak) lineCruise = peak;
+  }
+  // The rate the line tops out at, whether it cruises there or a short line peaks there, stays out of the bands
+  float top = lineCruise;
+  if (lineAccel > 0)
+  {
+    float peak = peakRate(plan.length(), entryRate, exitRate, lineAccel);
+    if (top > peak) top = peak;
+  }
+  float clear = clearOfBands(plan, top);
+  if (clear < top) lineCruise = clear;
+  if (entryRate > lineCruise) entryRate = lineCruise;
+  if (exitRate > lineCruise) exitRate = lineCruise;
+
+  seg.accelInc = accelToPhaseInc(lineAccel);
+  seg.startInc = minStartInc(rateToPhaseInc(lineStart), seg.accelInc);
+  seg.entryInc = rateToPhaseInc(entryRate);
+  seg.cruiseInc = rateToPhaseInc(lineCruise);
+  seg.exitInc = rateToPhaseInc(exitRate);
+  seg.decelAfter = decelPoint(plan.length(), entryRate, lineCruise, exitRate, lineAccel);
+  seg.ticks = 0;
+
+  if (!queue.push(seg)) return false;
+  planned[AXIS_AZ] = azTarget;
+  planned[AXIS_EL] = elTarget;
+  return true;
+}
+
+float StepEngine::lineTime(long azTarget, long elTarget) const
+{
+  long from[AXIS_COUNT] = { plannedPosition(AXIS_AZ), plannedPosition(AXIS_EL) };
+  long to[AXIS_COUNT] = { azTarget, elTarget };
+  long via[AXIS_COUNT] = { azTarget, elTarget };
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    via[i] -= approachOvershoot(i, to[i] - from[i]);
+  // Which way the gears last drove, as of now: exact when the queue is empty, as for a goto
+  int8_t loadDir[AXIS_COUNT] = { axes[AXIS_AZ].loadDir, axes[AXIS_EL].loadDir };
+  return takeupTime(from, via, loadDir) + legTime(from, via) + takeupTime(via, to, loadDir) + legTime(via, to);
+}
+
+// Time a leg waits before its first step while the axes it reverses cross their play (together, at the start rate).
+// Updates loadDir to the directions the leg drives in.
+float StepEngine::takeupTime(const long from[AXIS_COUNT], const long to[AXIS_COUNT], int8_t loadDir[AXIS_COUNT]) const
+{
+  float t = 0;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    long d = to[i] - from[i];
+    if (d == 0) continue;
+    int8_t dir = d > 0 ? 1 : -1;
+    if (loadDir[i] == -dir && axes[i].backlash > 0 && axes[i].startRate > 0)
+    {
+      float ti = axes[i].backlash / axes[i].startRate;
+      if (ti > t) t = ti;
+    }
+    loadDir[i] = dir;
+  }
+  return t;
+}
+
+// Same profile as pushLine builds for a line from rest to rest: jump to the start rate, ramp at the mean
+// acceleration, cruise (or peak on a short line), ramp down
+float StepEngine::legTime(const long from[AXIS_COUNT], const long to[AXIS_COUNT]) const
+{
+  LineMove plan;
+  plan.begin(from, to);
+  if (plan.done()) return 0;
+
+  float startRate[AXIS_COUNT], accel[AXIS_COUNT], maxRate[AXIS_COUNT];
+  getLimits(startRate, accel, maxRate);
+  float v0 = plan.majorLimit(startRate);
+  float a = plan.majorLimit(accel);
+  float vc = plan.majorLimit(maxRate);
+  float n = plan.length();
+  if (v0 > vc) v0 = vc;
+  if (a <= 0 || vc <= v0) return n / vc;
+
+  float peak = peakRate(plan.length(), v0, v0, a);
+  if (vc > peak) vc = peak;
+  vc = clearOfBands(plan, vc);
+  if (vc <= v0) return n / vc;
+  return 2 * (vc - v0) / a + (n - (vc * vc - v0 * v0) / a) / vc;
+}
+
+bool StepEngine::queueTimed(long azTarget, long elTarget, unsigned long durationUs)
+{
+  StepSegment seg;
+  if (!beginQueue(azTarget, elTarget, seg)) return false;
+  if (durationUs == 0) return pushTimed(azTarget, elTarget, durationUs);
+
+  // An axis whose rate falls inside a band runs part of the time at the band's lower edge and the rest at its upper
+  // edge instead, covering the same distance in the same time
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    unsigned long d = seg.steps[i] < 0 ? -seg.steps[i] : seg.steps[i];
+    float r = d * 1e6f / durationUs;
+    for (uint8_t b = 0; b < STEP_RESONANCE_BANDS; b++)
+    {
+      float lo = axes[i].bandLow[b], hi = axes[i].bandHigh[b];
+      if (!(r > lo && r < hi)) continue;
+      if (queue.size() + 2 > STEP_QUEUE_SIZE) return false;
+      float slow = durationUs * 1e-6f * (hi - r) / (hi - lo);  // seconds at the lower edge
+      float part = lo * slow / d;
+      long mid[AXIS_COUNT];
+      for (uint8_t k = 0; k < AXIS_COUNT; k++)
+        mid[k] = planned[k] + lroundf(seg.steps[k] * part);
+      unsigned long slowUs = (unsigned long)(slow * 1e6f);
+      return pushTimed(mid[AXIS_AZ], mid[AXIS_EL], slowUs) &&
+             pushTimed(azTarget, elTarget, durationUs - slowUs);
+    }
+  }
+  return pushTimed(azTarget, elTarget, durationUs);
+}
+
+bool StepEngine::pushTimed(long azTarget, long elTarget, unsigned long durationUs)
+{
+  StepSegment seg;
+  if (!beginQueue(azTarget, elTarget, seg)) return false;
+
+  uint32_t ticks = durationUs / STEP_TICK_US;
+  if (ticks == 0) ticks = 1;
+  unsigned long major = 0;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    unsigned long d = seg.steps[i] < 0 ? -seg.steps[i] : seg.steps[i];
+    if (d > major) major = d;
+  }
+
+  // Constant rate: the last step lands on the last tick of the segment
+  uint64_t inc = ((uint64_t)major << 32) / ticks;
+  seg.cruiseInc = inc > 0x80000000ULL ? 0x80000000UL : (uint32_t)inc;
+  seg.startInc = seg.cruiseInc;
+  seg.entryInc = seg.cruiseInc;
+  seg.exitInc = seg.cruiseInc;
+  seg.accelInc = 0;
+  seg.decelAfter = major;
+  seg.ticks = ticks;
+  seg.shape = RAMP_TRAPEZOID;
+
+  if (!queue.push(seg)) return false;
+  planned[AXIS_AZ] = azTarget;
+  planned[AXIS_EL] = elTarget;
+  return true;
+}
+
+void StepEngine::stop(uint8_t axis)
+{
+  Axis& a = axes[axis];
+  motionLock(&lock);
+  requestSegmentStop();
+  if (a.mode != MODE_IDLE)
+  {
+    a.forward = (dirBits & (1 << axis)) != 0;
+    a.ramp.cruiseInc = 0;
+    if (a.mode == MODE_POSITION) a.mode = MODE_VELOCITY;
+  }
+  motionUnlock(&lock);
+}
+
+void StepEngine::setPosition(uint8_t axis, long position)
+{
+  Axis& a = axes[axis];
+  motionLock(&lock);
+  a.position = position;
+  a.target = position;
+  a.approachTarget = position;
+  motionUnlock(&lock);
+}
+
+void StepEngine::setBacklash(uint8_t axis, uint16_t steps, BacklashPolicy policy)
+{
+  Axis& a = axes[axis];
+  motionLock(&lock);
+  a.backlash = steps;
+  a.approach = policy;
+  motionUnlock(&lock);
+}
+
+// Called when an axis's DIR changes; if that reverses the gears, cross the play before the next counted step
+void MOTION_ISR_ATTR StepEngine::beginTakeup(uint8_t i, bool forward)
+{
+  Axis& a = axes[i];
+  if (a.loadDir != (forward ? -1 : 1) || a.backlash == 0) return;
+  a.takeup = a.backlash;
+  a.takeupPhase = 0;
+}
+
+// One tick of takeup: steps at the start rate, which needs no ramp, and leaves position alone
+uint8_t MOTION_ISR_ATTR StepEngine::tickTakeup(uint8_t i)
+{
+  Axis& a = axes[i];
+  uint32_t prev = a.takeupPhase;
+  a.takeupPhase += a.ramp.startInc;
+  if (a.takeupPhase >= prev) return 0;
+  if (--a.takeup == 0) a.loadDir = (dirBits & (1 << i)) ? 1 : -1;
+  return 1 << i;
+}
+
+bool MOTION_ISR_ATTR StepEngine::startSegment()
+{
+  StepSegment seg;
+  if (!queue.pop(seg)) return false;
+
+  long from[AXIS_COUNT] = { 0, 0 };
+  line.begin(from, seg.steps);
+  // Carry the phase over, so a line entered at speed continues the previous pulse train seamlessly
+  lineRamp.startInc = seg.startInc;
+  lineRamp.cruiseInc = seg.cruiseInc;
+  lineRamp.accelInc = seg.accelInc;
+  lineRamp.shape = seg.shape;
+  lineRamp.reset();
+  lineRamp.phaseInc = seg.entryInc;
+  lineExitInc = seg.exitInc;
+  lineDecelAfter = seg.decelAfter;
+  lineTicksLeft = seg.ticks;
+  lineActive = true;
+  return true;
+}
+
+uint8_t MOTION_ISR_ATTR StepEngine::tickLine()
+{
+  // Latch DIR for every axis of the segment before its first step
+  uint8_t dirChange = (dirBits ^ line.dirMask()) & line.axisMask();
+  if (dirChange)
+  {
+    dirBits ^= dirChange;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      if (dirChange & (1 << i)) beginTakeup(i, (dirBits & (1 << i)) != 0);
+    return 0;
+  }
+
+  // The whole line waits while an axis crosses its play, so the axes stay in step on the output side
+  uint8_t takeupBits = 0;
+  bool takingUp = false;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    if (axes[i].takeup == 0) continue;
+    takeupBits |= tickTakeup(i);
+    takingUp = true;
+  }
+  if (takingUp) return takeupBits;
+
+  if (lineTicksLeft > 0) lineTicksLeft--;
+  if ((line.done() && lineTicksLeft == 0) || (lineStopping && !lineRamp.moving()))
+  {
+    lineActive = false;
+    lineRamp.reset();
+    return 0;
+  }
+  if (line.done()) return 0;  // timed segment, waiting out its duration
+
+  uint32_t want = lineRamp.cruiseInc;
+  if (lineStopping) want = lineRamp.startInc;
+  else if (line.length() - line.remaining() >= lineDecelAfter) want = lineExitInc;
+  if (!lineRamp.advance(want)) return 0;
+
+  uint8_t stepBits = line.next();
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    if (!(stepBits & (1 << i))) continue;
+    bool forward = (dirBits & (1 << i)) != 0;
+    axes[i].position += forward ? 1 : -1;
+    axes[i].loadDir = forward ? 1 : -1;
+  }
+  return stepBits;
+}
+
+uint8_t MOTION_ISR_ATTR StepEngine::tickAxis(uint8_t i)
+{
+  Axis& a = axes[i];
+  if (a.mode == MODE_IDLE) return 0;
+  if (a.takeup > 0) return tickTakeup(i);
+
+  uint8_t bit = 1 << i;
+  bool dirForward = (dirBits & bit) != 0;
+  bool moving = a.ramp.moving();
+  bool forward;
+  uint32_t want;
+
+  if (a.mode == MODE_POSITION)
+  {
+    long remaining = a.target - a.position;
+    if (remaining == 0 && a.target != a.approachTarget)
+    {
+      // Overshot to approach from the policy's side; now head for the real target
+      a.target = a.approachTarget;
+      return 0;
+    }
+    if (remaining == 0)
+    {
+      a.mode = MODE_IDLE;
+      a.ramp.reset();
+      return 0;
+    }
+    forward = remaining > 0;
+    unsigned long distance = forward ? remaining : -remaining;
+    want = distance > a.ramp.rampSteps ? a.ramp.cruiseInc : a.ramp.startInc;
+  }
+  else
+  {
+    forward = a.forward;
+    want = a.ramp.cruiseInc;
+    if (want == 0 && !moving)
+    {
+      a.mode = MODE_IDLE;
+      a.ramp.reset();
+      return 0;
+    }
+  }
+
+  if (forward != dirForward)
+  {
+    if (!moving)
+    {
+      // Change DIR now, step from the next tick on
+      dirBits ^= bit;
+      a.ramp.reset();
+      beginTakeup(i, forward);
+      return 0;
+    }
+    want = 0;  // slow down before reversing
+  }
+
+  if (!a.ramp.advance(want)) return 0;
+
+  if (a.mode != MODE_RUN) a.position += dirForward ? 1 : -1;
+  a.loadDir = dirForward ? 1 : -1;
+  return bit;
+}
+
+uint8_t MOTION_ISR_ATTR StepEngine::tick()
+{
+  if (!lineActive)
+  {
+    if (lineStopping)
+    {
+      // Stopped; drop whatever was planned after the interrupted segment
+      StepSegment seg;
+      while (queue.pop(seg)) {}
+      lineStopping = false;
+    }
+    else
+    {
+      bool idle = true;
+      for (uint8_t i = 0; i < AXIS_COUNT; i++)
+        if (axes[i].mode != MODE_IDLE) idle = false;
+      if (idle) startSegment();
+    }
+  }
+
+  // A segment owns both axes; single-axis commands issued meanwhile wait until it has ramped down
+  if (lineActive) return tickLine();
+
+  uint8_t stepBits = 0;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    stepBits |= tickAxis(i);
+  return stepBits;
+}
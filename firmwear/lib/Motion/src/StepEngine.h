@@ -0,0 +1,238 @@
+//======================================================================================================================
+// StepEngine
+//
+// Timer-driven step pulse generator for the two mount axes. The main loop only sets rates, directions and targets;
+// tick() is called from a hardware timer every STEP_TICK_US and decides which STEP lines rise on that tick, so pulse
+// timing no longer depends on how long the web server or WebSocket handling takes.
+//
+// Each axis runs a 32-bit phase accumulator: the rate is added every tick and a step is due when the accumulator
+// wraps. Steps therefore land on the tick grid, i.e. with at most STEP_TICK_US of jitter.
+//
+// Velocity follows a trapezoidal profile: the axis starts at its start rate (the speed the motor can pull in from
+// standstill), ramps up at a constant acceleration to the cruise rate, and ramps back down before it stops, reverses
+// or reaches its target. The ramp is applied per tick in integer arithmetic, so the ISR never touches the FPU.
+// Axes can instead use a jerk-limited S-curve (rates read from RampTable) or no ramp at all, see RampShape.
+//
+// Resonance bands: an axis can have step rates where the motor and gear train resonate and the torque collapses.
+// Ramps still pass through them at full acceleration, but no move cruises inside one (see setResonanceBand).
+//
+// Backlash: each axis remembers which way its gears last drove. When it reverses, the engine first steps across the
+// play at the start rate without counting those steps, so position() keeps following the output shaft.
+//
+// Besides independent per-axis motion, the engine executes coordinated segments (see LineMove): the major axis
+// follows the ramp and the other axis is slaved to it, so both finish together. Segments are planned in the main loop
+// and handed to the ISR through a lock-free queue, so planning latency does not show up in the pulse timing:
+//  - line segments ramp up, cruise and ramp down as fast as the per-axis profiles allow (slews, corrections)
+//  - timed segments move by a given number of steps in a given time at constant rate (continuous tracking)
+//======================================================================================================================
+
+#ifndef STEPENGINE_H
+#define STEPENGINE_H
+
+#include <stdint.h>
+#include "MotionPort.h"
+#include "MotionTypes.h"
+#include "LineMove.h"
+#include "SegmentQueue.h"
+#include "RampTable.h"
+
+#define STEP_TICK_US 25
+#define STEP_TICK_HZ (1000000UL / STEP_TICK_US)
+
+// STEP is held high for one tick and low for at least one, so an axis can step at most every other tick
+#define STEP_MAX_RATE (STEP_TICK_HZ / 2)
+
+#define STEP_QUEUE_SIZE 16
+
+// Accelerations are phase increments per tick with this many fraction bits. A whole unit is only 0.37 steps/s^2, but
+// truncated to whole units a slow ramp (200 steps/s^2) still runs 0.2% short and ends a hundred ticks late.
+#define STEP_ACCEL_FRAC_BITS 8
+
+#define STEP_RESONANCE_BANDS 2  // per axis
+
+// Coordinated move handed from the planner to the ISR. Everything is precomputed so the ISR stays integer-only.
+struct StepSegment
+{
+  long steps[AXIS_COUNT];  // relative move, microsteps
+  uint32_t startInc;       // major-axis ramp, as phase increments
+  uint32_t entryInc;
+  uint32_t cruiseInc;
+  uint32_t exitInc;
+  uint32_t accelInc;       // with STEP_ACCEL_FRAC_BITS fraction bits
+  uint32_t decelAfter;     // major-axis step from which to ramp down to the exit rate
+  uint32_t ticks;          // minimum duration, 0 for line segments
+  uint8_t shape;           // RampShape of the major-axis ramp
+};
+
+// Trapezoidal rate generator, advanced once per tick. Rates are phase increments (2^32 = one step per tick).
+struct StepRamp
+{
+  volatile uint32_t cruiseInc;  // requested rate, 0 = stop
+  volatile uint32_t startInc;   // start/stop rate
+  volatile uint32_t accelInc;   // mean rate change per tick, STEP_ACCEL_FRAC_BITS fraction bits; 0 = no ramp
+  volatile uint8_t shape;       // RAMP_TRAPEZOID or RAMP_SCURVE
+  uint32_t phaseInc;            // current rate
+  uint32_t phase;
+  uint32_t rampSteps;           // steps needed to ramp from the current rate down to the start rate
+  uint32_t accelFrac;           // fraction of accelInc not yet applied to the rate
+
+  // S-curve in progress: from/to rate and position in the RampTable (Q16), advancing curveStep per tick
+  uint32_t fromInc;
+  uint32_t toInc;
+  uint32_t curvePos;
+  uint32_t curveStep;           // 0 = no curve in progress
+
+  void reset();
+
+  // Too fast to stop or reverse on the spot
+  bool moving() const { return accelInc != 0 && phaseInc > startInc; }
+
+  // Ramp one tick towards the wanted rate; returns true if a step is due on this tick
+  bool advance(uint32_t want);
+
+private:
+  uint32_t rampToward(uint32_t inc, uint32_t want);
+  uint32_t curveToward(uint32_t inc, uint32_t want);
+};
+
+class StepEngine
+{
+public:
+  StepEngine();
+
+  // Start rate (steps/s), acceleration (steps/s^2) and top speed (steps/s) of the profile. For an S-curve, accel is
+  // the peak acceleration. RAMP_FIXED or an acceleration of 0 disables the ramp: the axis jumps straight to the
+  // requested rate, as with a fixed step interval.
+  void setProfile(uint8_t axis, float startRate, float accel, float maxRate, RampShape shape = RAMP_TRAPEZOID);
+
+  // Run continuously at the given rate (steps/s). Used for manual alignment, so these steps move the mechanics
+  // without moving the reference: position() is not updated.
+  void run(uint8_t axis, bool forward, float stepsPerSec);
+
+  // Run at a signed rate (steps/s), counting position. Used for continuous tracking; rates below the start rate are
+  // applied without a ramp.
+  void setVelocity(uint8_t axis, float stepsPerSec);
+
+  // Step towards an absolute position (microsteps), cruising at the given rate, and stop there
+  void moveTo(uint8_t axis, long target, float stepsPerSec);
+
+  // Queue a coordinated line to an absolute position, as fast as the per-axis profiles allow. Segments run back to
+  // back from the end of the previously queued one. Returns false if the queue is full, a stop is still in progress
+  // or an axis is under a direct (run/setVelocity/moveTo) command.
+  // Entry and exit rates (major-axis steps/s) let consecutive lines blend without stopping; they are raised to the
+  // line's start rate, which is also the default.
+  bool queueLine(long azTarget, long elTarget, float entryRate = 0, float exitRate = 0);
+
+  // Estimated time (s) for queueLine to reach an absolute position from the end of the queue, from and to rest,
+  // including any approach overshoot and crossing the play where an axis reverses
+  float lineTime(long azTarget, long elTarget) const;
+
+  // Queue a constant-rate segment that reaches an absolute position after durationUs
+  bool queueTimed(long azTarget, long elTarget, unsigned long durationUs);
+
+  // Play in the gear train (motor microsteps) and how to handle it, see BacklashPolicy. Approach policies apply to
+  // moveTo and to lines that end at rest: a move arriving from the other side overshoots by the play and comes back.
+  void setBacklash(uint8_t axis, uint16_t steps, BacklashPolicy policy);
+  uint16_t backlash(uint8_t axis) const { return axes[axis].backlash; }
+  BacklashPolicy backlashPolicy(uint8_t axis) const { return (BacklashPolicy)axes[axis].approach; }
+
+  // Forbid cruising between two step rates (steps/s) on an axis; a band of 0..0 is unused. A cruise rate inside a band
+  // drops to its lower edge, for lines as seen by each axis; a timed segment whose rate falls inside one is split into
+  // a part at the lower edge and a part at the upper edge that take the same time together.
+  void setResonanceBand(uint8_t axis, uint8_t band, float lowRate, float highRate);
+  float resonanceLow(uint8_t axis, uint8_t band) const { return axes[axis].bandLow[band]; }
+  float resonanceHigh(uint8_t axis, uint8_t band) const { return axes[axis].bandHigh[band]; }
+  // The rate an axis may cruise at instead of the given one, and the same for the major-axis rate of a line
+  float clearOfBands(uint8_t axis, float stepsPerSec) const;
+  float clearOfBands(const LineMove& plan, float majorRate) const;
+
+  // Ramp down to the start rate, then stop. Also stops segment motion and drops the queue.
+  void stop(uint8_t axis);
+  void setPosition(uint8_t axis, long position);
+
+  long position(uint8_t axis) const { return axes[axis].position; }
+  long plannedPosition(uint8_t axis) const { return isSegmentBusy() ? planned[axis] : axes[axis].position; }
+  // Per-axis limits for planning. accel is the mean acceleration over a ramp, which is what ramp distances and
+  // times depend on: half the peak for an S-curve.
+  void getLimits(float startRate[AXIS_COUNT], float accel[AXIS_COUNT], float maxRate[AXIS_COUNT]) const;
+  bool isRunning(uint8_t axis) const { return isSegmentBusy() || axes[axis].mode != MODE_IDLE; }
+  // The queue before the flags: the ISR may pop the last segment and set lineActive between the two reads, and
+  // reading lineActive first would then see neither the segment queued nor active
+  bool isSegmentBusy() const { return !queue.empty() || lineActive || lineStopping; }
+  uint32_t queuedSegments() const { return queue.size(); }
+  float rate(uint8_t axis) const;  // current speed, steps/s
+
+  // Called from the step timer ISR once per tick. Returns a bit mask (1 << axis) of the STEP lines that rise on
+  // this tick. An axis never steps on the tick its direction changes, so DIR always gets a full tick of setup time.
+  uint8_t tick();
+
+  // Levels for the DIR lines (bit set = forward), valid after tick()
+  uint8_t dirMask() const { return dirBits; }
+
+private:
+  enum Mode
+  {
+    MODE_IDLE,
+    MODE_RUN,       // uncounted, manual alignment
+    MODE_VELOCITY,
+    MODE_POSITION
+  };
+
+  struct Axis
+  {
+    volatile uint8_t mode;
+    volatile bool forward;  // requested direction in MODE_RUN
+    volatile long position;
+    volatile long target;
+    volatile long approachTarget;  // final target in MODE_POSITION, after an approach overshoot
+    StepRamp ramp;
+    float startRate;
+    float accel;  // mean
+    float maxRate;
+    float bandLow[STEP_RESONANCE_BANDS];
+    float bandHigh[STEP_RESONANCE_BANDS];
+
+    // Backlash
+    volatile uint16_t backlash;
+    volatile uint8_t approach;  // BacklashPolicy
+    int8_t loadDir;             // which way the gears last drove: 1 forward, -1 reverse, 0 unknown
+    uint16_t takeup;            // uncounted steps left to cross the play
+    uint32_t takeupPhase;
+  };
+
+  Axis axes[AXIS_COUNT];
+  SegmentQueue<StepSegment, STEP_QUEUE_SIZE> queue;
+  long planned[AXIS_COUNT];  // end position of the last queued segment (main loop only)
+
+  // Segment being executed (ISR only, apart from the flags)
+  LineMove line;
+  StepRamp lineRamp;
+  uint32_t lineExitInc;
+  uint32_t lineDecelAfter;
+  uint32_t lineTicksLeft;
+  volatile bool lineActive;
+  volatile bool lineStopping;  // set by the main loop, cleared by the ISR once stopped and flushed
+
+  uint8_t dirBits;
+  MotionLock lock;
+
+  static uint32_t rateToPhaseInc(float stepsPerSec);
+  static uint32_t accelToPhaseInc(float accel);
+  static uint32_t minStartInc(uint32_t startInc, uint32_t accelInc);
+  static float peakRate(unsigned long steps, float entry, float exit, float accel);
+  static uint32_t decelPoint(unsigned long steps, float entry, float cruise, float exit, float accel);
+  bool beginQueue(long azTarget, long elTarget, StepSegment& seg);
+  void requestSegmentStop();
+  bool pushLine(long azTarget, long elTarget, float entryRate, float exitRate);
+  bool pushTimed(long azTarget, long elTarget, unsigned long durationUs);
+  float legTime(const long from[AXIS_COUNT], const long to[AXIS_COUNT]) const;
+  float takeupTime(const long from[AXIS_COUNT], const long to[AXIS_COUNT], int8_t loadDir[AXIS_COUNT]) const;
+  long approachOvershoot(uint8_t axis, long distance) const;
+  bool startSegment();
+  void beginTakeup(uint8_t i, bool forward);
+  uint8_t tickTakeup(uint8_t i);
+  uint8_t tickLine();
+  uint8_t tickAxis(uint8_t i);
+};
+
+#endif  //STEPENGINE_H
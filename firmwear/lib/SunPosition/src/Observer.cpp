@@ -0,0 +1,93 @@
+#include "Observer.h"
+#include <math.h>
+#include <SolarCalculator.h>
+
+#define DEG_TO_RAD_D (M_PI / 180)
+#define RAD_TO_DEG_D (180 / M_PI)
+
+// Sine and cosine of one angle side by side, which GCC turns into a single sincos call where the C library has one
+template <typename Real>
+static inline void sinCos(Real x, Real& s, Real& c)
+{
+  s = sin(x);
+  c = cos(x);
+}
+
+// Horizontal coordinates from the sines and cosines of the sun's ecliptic longitude L, the obliquity eps and the
+// local sidereal angle theta: the equatorial vector of the sun, rotated by theta, gives cos(dec) cos(H) and
+// cos(dec) sin(H) directly
+template <typename Real>
+static void sinesToHorizontal(Real sinL, Real cosL, Real sinEps, Real cosEps, Real sinTh, Real cosTh, Real sinLat,
+                              Real cosLat, Real& azimuth, Real& elevation)
+{
+  Real sinDec = sinEps * sinL;
+  Real cosHcosDec = cosTh * cosL + sinTh * cosEps * sinL;
+  Real sinHcosDec = sinTh * cosL - cosTh * cosEps * sinL;
+
+  Real xhor = cosHcosDec * sinLat - sinDec * cosLat;
+  Real zhor = cosHcosDec * cosLat + sinDec * sinLat;
+  azimuth = atan2(sinHcosDec, xhor) * (Real)RAD_TO_DEG_D + 180;  // measured from the North
+  elevation = atan2(zhor, sqrt(xhor * xhor + sinHcosDec * sinHcosDec)) * (Real)RAD_TO_DEG_D;
+}
+
+// The same from the angles, radians
+template <typename Real>
+static void anglesToHorizontal(Real L, Real eps, Real theta, Real sinLat, Real cosLat, Real& azimuth,
+                               Real& elevation)
+{
+  Real sinL, cosL, sinEps, cosEps, sinTh, cosTh;
+  sinCos(L, sinL, cosL);
+  sinCos(eps, sinEps, cosEps);
+  sinCos(theta, sinTh, cosTh);
+  sinesToHorizontal(sinL, cosL, sinEps, cosEps, sinTh, cosTh, sinLat, cosLat, azimuth, elevation);
+}
+
+Observer::Observer(double latitude, double longitude) : lat(latitude), lon(longitude)
+{
+  sinCos(latitude * DEG_TO_RAD_D, sinLat, cosLat);
+  lonF = (float)longitude;
+  sinLatF = (float)sinLat;
+  cosLatF = (float)cosLat;
+}
+
+void Observer::horizontal(double H, double dec, double& az, double& el) const
+{
+  double sinH, cosH, sinDec, cosDec;
+  sinCos(H * DEG_TO_RAD_D, sinH, cosH);
+  sinCos(dec * DEG_TO_RAD_D, sinDec, cosDec);
+  double xhor = cosH * cosDec * sinLat - sinDec * cosLat;
+  double yhor = sinH * cosDec;
+  double zhor = cosH * cosDec * cosLat + sinDec * sinLat;
+
+  az = atan2(yhor, xhor) * RAD_TO_DEG_D;
+  el = atan2(zhor, sqrt(xhor * xhor + yhor * yhor)) * RAD_TO_DEG_D;
+}
+
+void Observer::eclipticToHorizontal(float sinL, float cosL, float sinEps, float cosEps, float sinTheta, float cosTheta,
+                                    float& azimuth, float& elevation) const
+{
+  sinesToHorizontal(sinL, cosL, sinEps, cosEps, sinTheta, cosTheta, sinLatF, cosLatF, azimuth, elevation);
+}
+
+void Observer::sunPosition(unsigned long utc, double& azimuth, double& elevation) const
+{
+  JulianDay jd(utc);
+  double T = calcJulianCent(jd);
+  double L = calcGeomMeanLongSun(T) + calcSunEqOfCenter(T) - 0.00569;  // corrected for aberration
+  double eps = calcMeanObliquityOfEcliptic(T);
+  double theta = calcGrMeanSiderealTime(jd) + lon;
+
+  anglesToHorizontal(L * DEG_TO_RAD_D, eps * DEG_TO_RAD_D, theta * DEG_TO_RAD_D, sinLat, cosLat, azimuth, elevation);
+  elevation += calcRefraction(elevation);
+}
+
+void Observer::sunPosition(const SolarEpochF& epoch, unsigned long utc, float& azimuth, float& elevation) const
+{
+  float L, eps;
+  calcEclipticCoordinatesF(epoch, utc, L, eps);
+  float theta = wrapTo180F(calcGrMeanSiderealTimeF(epoch, utc) + lonF);
+
+  const float toRad = (float)DEG_TO_RAD_D;
+  anglesToHorizontal(L * toRad, eps * toRad, theta * toRad, sinLatF, cosLatF, azimuth, elevation);
+  elevation += calcRefractionF(elevation);
+}
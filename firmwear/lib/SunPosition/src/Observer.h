@@ -0,0 +1,54 @@
+//======================================================================================================================
+// Observer
+//
+// The tracker's site, with its trigonometry worked out once. calcHorizontalCoordinates() takes the site on every
+// call and equatorial2horizontal() takes the sine and cosine of the latitude twice each, on top of separate sines
+// and cosines of one angle and an atan2/asin round trip through right ascension and declination.
+//
+// Observer keeps sin/cos of the latitude and gets each remaining angle's sine and cosine side by side (one sincos
+// where the C library has it). Its sun position goes from the ecliptic longitude straight to the horizontal vector,
+// so right ascension and declination are never formed. Per position that leaves the equation of centre's two
+// sines, three sine/cosine pairs, two atan2 and the refraction tangent, where calcHorizontalCoordinates() makes 24
+// trigonometric calls.
+//======================================================================================================================
+
+#ifndef OBSERVER_H
+#define OBSERVER_H
+
+#include "SolarCalculatorF.h"
+
+class Observer
+{
+public:
+  Observer(double latitude = 0, double longitude = 0);
+
+  double latitude() const { return lat; }
+  double longitude() const { return lon; }
+  double sinLatitude() const { return sinLat; }
+  double cosLatitude() const { return cosLat; }
+
+  // equatorial2horizontal() at this site: hour angle and declination to azimuth (from the South) and elevation,
+  // degrees, before refraction
+  void horizontal(double H, double dec, double& az, double& el) const;
+
+  // Sun's azimuth (from the North) and elevation before refraction, degrees, from the sines and cosines of its
+  // ecliptic longitude, the obliquity of the ecliptic and the local sidereal angle
+  void eclipticToHorizontal(float sinL, float cosL, float sinEps, float cosEps, float sinTheta, float cosTheta,
+                            float& azimuth, float& elevation) const;
+
+  // Sun's horizontal coordinates at utc as calcHorizontalCoordinates() and calcHorizontalCoordinatesF() give them:
+  // azimuth from the North, elevation corrected for refraction, degrees
+  void sunPosition(unsigned long utc, double& azimuth, double& elevation) const;
+  void sunPosition(const SolarEpochF& epoch, unsigned long utc, float& azimuth, float& elevation) const;
+
+private:
+  double lat;
+  double lon;
+  double sinLat;
+  double cosLat;
+  float lonF;
+  float sinLatF;
+  float cosLatF;
+};
+
+#endif  //OBSERVER_H
@@ -0,0 +1,112 @@
+#include "SolarCalculatorF.h"
+#include <math.h>
+#include <SolarCalculator.h>
+
+#define SECONDS_PER_DAY 86400UL
+#define DEG_TO_RAD_F ((float)(M_PI / 180))
+#define RAD_TO_DEG_F ((float)(180 / M_PI))
+
+// Degrees per day of the terms that grow with time, SolarCalculator's coefficients per century divided out
+#define LONG_PER_DAY (float)(36000.76983 / 36525)
+#define ANOMALY_PER_DAY (float)(35999.05029 / 36525)
+#define SIDEREAL_PER_DAY (float)0.98564736629  // beyond whole turns
+#define SIDEREAL_PER_SECOND (float)(360.985647 / SECONDS_PER_DAY)
+
+SolarEpochF::SolarEpochF(unsigned long t)
+{
+  utc = t - t % SECONDS_PER_DAY;
+  JulianDay jd(utc);
+  double TD = calcJulianCent(jd);
+  T = (float)TD;
+  meanLong = (float)calcGeomMeanLongSun(TD);
+  meanAnomaly = (float)calcGeomMeanAnomalySun(TD);
+  sidereal = (float)calcGrMeanSiderealTime(jd);
+}
+
+bool SolarEpochF::covers(unsigned long t) const
+{
+  return t >= utc && (t - utc) / SECONDS_PER_DAY < SOLAR_F_EPOCH_DAYS;
+}
+
+float wrapTo360F(float angle)
+{
+  return angle - 360 * floorf(angle / 360);  // [0, 360)
+}
+
+float wrapTo180F(float angle)
+{
+  return wrapTo360F(angle + 180) - 180;  // [-180, 180)
+}
+
+// Whole days and the fraction of a day since the epoch; each stays exact in float
+static void sinceEpoch(const SolarEpochF& epoch, unsigned long utc, float& days, float& seconds)
+{
+  unsigned long dt = utc - epoch.utc;
+  days = (float)(dt / SECONDS_PER_DAY);
+  seconds = (float)(dt % SECONDS_PER_DAY);
+}
+
+void calcEclipticCoordinatesF(const SolarEpochF& epoch, unsigned long utc, float& longitude, float& obliquity)
+{
+  float days, seconds;
+  sinceEpoch(epoch, utc, days, seconds);
+  float elapsed = days + seconds / SECONDS_PER_DAY;
+  float T = epoch.T + elapsed / 36525;  // only for the slow terms, where float's ~1e-8 centuries do not show
+
+  float L0 = wrapTo360F(epoch.meanLong + LONG_PER_DAY * days + LONG_PER_DAY / SECONDS_PER_DAY * seconds);
+  float M = wrapTo360F(epoch.meanAnomaly + ANOMALY_PER_DAY * days + ANOMALY_PER_DAY / SECONDS_PER_DAY * seconds);
+  float C = sinf(M * DEG_TO_RAD_F) * (1.914602f - 0.004817f * T) + sinf(2 * M * DEG_TO_RAD_F) * 0.019993f;
+  longitude = L0 + C - 0.00569f;  // corrected for aberration
+  obliquity = 23.4392911f - T * 0.0130042f;
+}
+
+void calcSolarCoordinatesF(const SolarEpochF& epoch, unsigned long utc, float& ra, float& dec)
+{
+  float L, eps;
+  calcEclipticCoordinatesF(epoch, utc, L, eps);
+  L *= DEG_TO_RAD_F;
+  eps *= DEG_TO_RAD_F;
+  float sinL = sinf(L);
+  ra = atan2f(cosf(eps) * sinL, cosf(L)) * RAD_TO_DEG_F;  // [-180, 180)
+  dec = asinf(sinf(eps) * sinL) * RAD_TO_DEG_F;
+}
+
+float calcGrMeanSiderealTimeF(const SolarEpochF& epoch, unsigned long utc)
+{
+  float days, seconds;
+  sinceEpoch(epoch, utc, days, seconds);
+  float GMST0 = wrapTo360F(epoch.sidereal + SIDEREAL_PER_DAY * days);
+  return wrapTo360F(GMST0 + SIDEREAL_PER_SECOND * seconds);  // in degrees
+}
+
+void equatorial2horizontalF(float H, float dec, float lat, float& az, float& el)
+{
+  float cosH = cosf(H * DEG_TO_RAD_F), sinH = sinf(H * DEG_TO_RAD_F);
+  float cosDec = cosf(dec * DEG_TO_RAD_F), sinDec = sinf(dec * DEG_TO_RAD_F);
+  float cosLat = cosf(lat * DEG_TO_RAD_F), sinLat = sinf(lat * DEG_TO_RAD_F);
+  float xhor = cosH * cosDec * sinLat - sinDec * cosLat;
+  float yhor = sinH * cosDec;
+  float zhor = cosH * cosDec * cosLat + sinDec * sinLat;
+
+  az = atan2f(yhor, xhor) * RAD_TO_DEG_F;
+  el = atan2f(zhor, sqrtf(xhor * xhor + yhor * yhor)) * RAD_TO_DEG_F;
+}
+
+float calcRefractionF(float el)
+{
+  if (el < -0.575f)
+    return -20.774f / 3600 / tanf(el * DEG_TO_RAD_F);  // Zimmerman (1981)
+  return 1.02f / 60 / tanf((el + 10.3f / (el + 5.11f)) * DEG_TO_RAD_F);  // Saemundsson (1986)
+}
+
+void calcHorizontalCoordinatesF(const SolarEpochF& epoch, unsigned long utc, float latitude, float longitude,
+                                float& azimuth, float& elevation)
+{
+  float ra, dec;
+  calcSolarCoordinatesF(epoch, utc, ra, dec);
+  float H = wrapTo180F(calcGrMeanSiderealTimeF(epoch, utc) + longitude - ra);
+  equatorial2horizontalF(H, dec, latitude, azimuth, elevation);
+
+  azimuth += 180;  // measured from the North
+  elevation += calcRefractionF(elevation);
+}
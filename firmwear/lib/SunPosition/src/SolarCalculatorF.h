@@ -0,0 +1,54 @@
+//======================================================================================================================
+// SolarCalculatorF
+//
+// SolarCalculator's sun position chain in single precision, for the ESP32-S3 whose FPU has no double: the same
+// formulae, with every sin, atan2 and wrap in float.
+//
+// Float cannot carry a Julian date, nor the thousands of turns the mean longitude and sidereal time have made since
+// J2000, so time is counted from an epoch. SolarEpochF reduces those terms to one turn at 0h UT of a day (once, in
+// double); a position up to SOLAR_F_EPOCH_DAYS later advances them by its whole days and its seconds into the day,
+// two products small enough for float.
+//
+// Tested bound: tools/solar_float_bench.cpp compares calcHorizontalCoordinatesF() with calcHorizontalCoordinates()
+// at latitudes 66 S to 66 N, every longitude and 2020 to 2060, each with an epoch up to SOLAR_F_EPOCH_DAYS old. With
+// the sun up, both the direction and the elevation stay within SOLAR_F_MAX_ERROR_DEG. Below the horizon refraction
+// switches formula at -0.575 degrees and float may land on the other side of the switch, which costs up to 0.001
+// degrees.
+//======================================================================================================================
+
+#ifndef SOLARCALCULATORF_H
+#define SOLARCALCULATORF_H
+
+#define SOLAR_F_EPOCH_DAYS 400       // longest an epoch serves
+#define SOLAR_F_MAX_ERROR_DEG 3e-4f  // against the double calculation, sun above the horizon
+
+struct SolarEpochF
+{
+  explicit SolarEpochF(unsigned long utc = 0);  // at 0h UT of utc's day
+
+  // True if utc is within SOLAR_F_EPOCH_DAYS after the epoch
+  bool covers(unsigned long utc) const;
+
+  unsigned long utc;  // Unix time of the epoch
+  float T;            // Julian centuries since J2000.0
+  float meanLong;     // degrees, [0, 360)
+  float meanAnomaly;  // degrees, [0, 360)
+  float sidereal;     // Greenwich mean sidereal time, degrees, [0, 360)
+};
+
+float wrapTo360F(float angle);
+float wrapTo180F(float angle);
+
+// Sun's apparent longitude and the obliquity of the ecliptic, degrees, at utc; utc within the epoch
+void calcEclipticCoordinatesF(const SolarEpochF& epoch, unsigned long utc, float& longitude, float& obliquity);
+// Apparent right ascension and declination, degrees, at utc; utc within the epoch
+void calcSolarCoordinatesF(const SolarEpochF& epoch, unsigned long utc, float& ra, float& dec);
+float calcGrMeanSiderealTimeF(const SolarEpochF& epoch, unsigned long utc);
+void equatorial2horizontalF(float H, float dec, float lat, float& az, float& el);
+float calcRefractionF(float el);
+
+// Sun's topocentric horizontal coordinates, degrees, as calcHorizontalCoordinates() gives them; utc within the epoch
+void calcHorizontalCoordinatesF(const SolarEpochF& epoch, unsigned long utc, float latitude, float longitude,
+                                float& azimuth, float& elevation);
+
+#endif  //SOLARCALCULATORF_H
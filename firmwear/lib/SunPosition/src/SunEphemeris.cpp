@@ -0,0 +1,99 @@
+#include "SunEphemeris.h"
+#include <math.h>
+#include <SolarCalculator.h>
+#include "SolarCalculatorF.h"
+
+#define NODES (SUN_EPHEMERIS_DEGREE + 1)
+#define SOLAR_DAY_RATE (360.0 / 86400)  // deg/s, the hour angle's rate give or take the equation of time
+
+// Sum of a Chebyshev series at x in [-1, 1] (Clenshaw), with the constant term stored halved
+static float chebyshev(const float c[], float x)
+{
+  float b1 = 0, b2 = 0;
+  for (int j = SUN_EPHEMERIS_DEGREE; j >= 1; j--)
+  {
+    float b = 2 * x * b1 - b2 + c[j];
+    b2 = b1;
+    b1 = b;
+  }
+  return x * b1 - b2 + c[0];
+}
+
+// Greenwich hour angle and declination of the sun, degrees, at utc plus a fraction of a second
+static void hourAngleDeclination(unsigned long utc, double fraction, double& H, double& dec)
+{
+  JulianDay jd(utc);
+  jd.m += fraction / 86400;
+  double ra;
+  calcSolarCoordinates(calcJulianCent(jd), ra, dec);
+  H = calcGrMeanSiderealTime(jd) - ra;
+}
+
+SunEphemeris::SunEphemeris() : valid(false), t0(0), length(0), scale(0), sinLat(0), cosLat(1)
+{
+}
+
+void SunEphemeris::fit(unsigned long start, const Observer& site, unsigned long span)
+{
+  double H0, dec;
+  hourAngleDeclination(start, 0, H0, dec);
+  H0 += site.longitude();
+
+  double h[NODES], s[NODES], c[NODES];
+  for (int k = 0; k < NODES; k++)
+  {
+    // Chebyshev nodes, at fractional seconds: rounding them would skew the hour angle by up to 1/240 degree
+    double at = (cos(M_PI * (k + 0.5) / NODES) + 1) / 2 * span;
+    double H;
+    hourAngleDeclination(start + (unsigned long)at, at - floor(at), H, dec);
+    double expected = H0 + SOLAR_DAY_RATE * at;
+    h[k] = (expected + wrapTo180(H + site.longitude() - expected)) * M_PI / 180;
+    s[k] = sin(dec * M_PI / 180);
+    c[k] = cos(dec * M_PI / 180);
+  }
+
+  for (int j = 0; j < NODES; j++)
+  {
+    double sumH = 0, sumS = 0, sumC = 0;
+    for (int k = 0; k < NODES; k++)
+    {
+      double T = cos(M_PI * j * (k + 0.5) / NODES);
+      sumH += h[k] * T;
+      sumS += s[k] * T;
+      sumC += c[k] * T;
+    }
+    double norm = (j == 0 ? 1.0 : 2.0) / NODES;
+    hourAngle[j] = (float)(sumH * norm);
+    sinDec[j] = (float)(sumS * norm);
+    cosDec[j] = (float)(sumC * norm);
+  }
+
+  sinLat = (float)site.sinLatitude();
+  cosLat = (float)site.cosLatitude();
+  t0 = start;
+  length = span;
+  scale = 2.0f / span;
+  valid = true;
+}
+
+void SunEphemeris::clear()
+{
+  valid = false;
+}
+
+void SunEphemeris::position(unsigned long utc, float& azimuth, float& elevation) const
+{
+  float x = (float)(utc - t0) * scale - 1;
+  float H = chebyshev(hourAngle, x);
+  float sd = chebyshev(sinDec, x);
+  float cd = chebyshev(cosDec, x);
+
+  // equatorial2horizontal() with the declination's sine and cosine at hand
+  float cosH = cosf(H), sinH = sinf(H);
+  float xhor = cosH * cd * sinLat - sd * cosLat;
+  float yhor = sinH * cd;
+  float zhor = cosH * cd * cosLat + sd * sinLat;
+  azimuth = atan2f(yhor, xhor) * (float)(180 / M_PI) + 180;
+  elevation = atan2f(zhor, sqrtf(xhor * xhor + yhor * yhor)) * (float)(180 / M_PI);
+  elevation += calcRefractionF(elevation);
+}
@@ -0,0 +1,52 @@
+//======================================================================================================================
+// SunEphemeris
+//
+// The sun's path over a day as Chebyshev series, fitted once from the full calculation. On the ESP32 every
+// calcHorizontalCoordinates() call runs the NOAA/Meeus chain in software-emulated double; between fits, a position
+// costs three short float series, one sine/cosine pair, two atan2 and the refraction term.
+//
+// The series are site-bound but kept smooth: the local hour angle (unwrapped, so it just grows through the day) and
+// the sine and cosine of the declination. Azimuth and elevation themselves are not fitted, since both have kinks -
+// the azimuth swing of a near-zenith pass, refraction at the horizon - that a low-order series would smear.
+//======================================================================================================================
+
+#ifndef SUNEPHEMERIS_H
+#define SUNEPHEMERIS_H
+
+#include "Observer.h"
+
+#define SUN_EPHEMERIS_DEGREE 4       // highest Chebyshev order; 2 already reaches float resolution over a day
+#define SUN_EPHEMERIS_SPAN_S 90000UL // one fit: a day, plus an hour to look ahead across the refit
+
+class SunEphemeris
+{
+public:
+  SunEphemeris();
+
+  // Fit the sun's path as seen from site over span seconds from start (Unix time). Runs the full calculation
+  // SUN_EPHEMERIS_DEGREE + 1 times.
+  void fit(unsigned long start, const Observer& site, unsigned long span = SUN_EPHEMERIS_SPAN_S);
+  void clear();
+
+  bool fitted() const { return valid; }
+  bool covers(unsigned long utc) const { return valid && utc >= t0 && utc - t0 <= length; }
+  unsigned long startTime() const { return t0; }
+  unsigned long endTime() const { return t0 + length; }
+
+  // Sun's horizontal coordinates at utc, within the fitted span, in degrees as calcHorizontalCoordinates() gives
+  // them: azimuth from the North, elevation corrected for refraction
+  void position(unsigned long utc, float& azimuth, float& elevation) const;
+
+private:
+  bool valid;
+  unsigned long t0;
+  unsigned long length;
+  float scale;  // 2 / span, seconds since t0 to the series argument
+  float sinLat;
+  float cosLat;
+  float hourAngle[SUN_EPHEMERIS_DEGREE + 1];  // radians
+  float sinDec[SUN_EPHEMERIS_DEGREE + 1];
+  float cosDec[SUN_EPHEMERIS_DEGREE + 1];
+};
+
+#endif  //SUNEPHEMERIS_H
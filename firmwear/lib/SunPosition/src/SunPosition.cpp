@@ -0,0 +1,121 @@
+#include "SunPosition.h"
+#include <math.h>
+
+#define SECONDS_PER_DAY 86400UL
+#define J2000_UNIX_DAY 10957  // 2000 January 1 in days since 1970; J2000.0 is noon of that day
+
+// Degrees per second of the terms that grow with time, the same coefficients as SolarCalculator uses per century
+#define LONG_RATE (36000.76983 / 36525 / SECONDS_PER_DAY)
+#define ANOMALY_RATE (35999.05029 / 36525 / SECONDS_PER_DAY)
+#define SIDEREAL_RATE (360.985647 / SECONDS_PER_DAY)
+
+static double reduce360(double angle)
+{
+  angle = fmod(angle, 360);
+  return angle < 0 ? angle + 360 : angle;
+}
+
+// The time-dependent terms at 0h UT of a day, reduced to one turn
+struct DayTerms
+{
+  long day;
+  double T;  // Julian centuries since J2000.0
+  double meanLong;
+  double meanAnomaly;
+  double sidereal;
+  double sinObliquity;
+  double cosObliquity;
+
+  void set(long unixDay)
+  {
+    double d = unixDay - J2000_UNIX_DAY - 0.5;
+    day = unixDay;
+    T = d / 36525;
+    meanLong = reduce360(280.46646 + T * 36000.76983);
+    meanAnomaly = reduce360(357.52911 + T * 35999.05029);
+    sidereal = reduce360(100.46061837 + 0.98564736629 * d);
+    // The obliquity drifts by a few milliarcseconds a day, so once a day is plenty
+    double eps = (23.4392911 - T * 0.0130042) * M_PI / 180;
+    sinObliquity = sin(eps);
+    cosObliquity = cos(eps);
+  }
+};
+
+template <typename Real>
+static void batch(const unsigned long utc[], size_t count, Real latitude, Real longitude, Real azimuth[],
+                  Real elevation[])
+{
+  const Real toRad = (Real)(M_PI / 180);
+  const Real toDeg = (Real)(180 / M_PI);
+  const Real sinLat = sin(latitude * toRad), cosLat = cos(latitude * toRad);
+
+  DayTerms day;
+  day.set((long)(utc[0] / SECONDS_PER_DAY));
+  Real T[SUN_BATCH_BLOCK], meanLong[SUN_BATCH_BLOCK], anomaly[SUN_BATCH_BLOCK], theta[SUN_BATCH_BLOCK];
+  Real sinEps[SUN_BATCH_BLOCK], cosEps[SUN_BATCH_BLOCK];
+
+  for (size_t base = 0; base < count; base += SUN_BATCH_BLOCK)
+  {
+    size_t n = count - base < SUN_BATCH_BLOCK ? count - base : SUN_BATCH_BLOCK;
+
+    // Per-day terms in double, advanced to the second in Real
+    for (size_t k = 0; k < n; k++)
+    {
+      unsigned long t = utc[base + k];
+      long d = (long)(t / SECONDS_PER_DAY);
+      if (d != day.day) day.set(d);
+      Real s = (Real)(t % SECONDS_PER_DAY);
+      T[k] = (Real)day.T + s * (Real)(1.0 / 36525 / SECONDS_PER_DAY);
+      meanLong[k] = (Real)day.meanLong + s * (Real)LONG_RATE;
+      anomaly[k] = (Real)day.meanAnomaly + s * (Real)ANOMALY_RATE;
+      theta[k] = (Real)day.sidereal + s * (Real)SIDEREAL_RATE + longitude;
+      sinEps[k] = (Real)day.sinObliquity;
+      cosEps[k] = (Real)day.cosObliquity;
+    }
+
+    // Cosines are taken as sin(x + 90): GCC fuses a sin and cos of the same angle into sincos, and that call keeps
+    // the loop from vectorizing
+    Real* az = azimuth + base;
+    Real* el = elevation + base;
+    for (size_t k = 0; k < n; k++)
+    {
+      // Equation of centre and apparent longitude
+      Real sinM = sin(anomaly[k] * toRad), cosM = sin((anomaly[k] + 90) * toRad);
+      Real C = sinM * ((Real)1.914602 - (Real)0.004817 * T[k]) + 2 * sinM * cosM * (Real)0.019993;
+      Real L = meanLong[k] + C - (Real)0.00569;
+      Real sinL = sin(L * toRad), cosL = sin((L + 90) * toRad);
+
+      // cos(dec) cos(H) and cos(dec) sin(H), with H the local sidereal angle less the right ascension
+      Real sinDec = sinEps[k] * sinL;
+      Real sinRaCosDec = cosEps[k] * sinL;
+      Real sinTh = sin(theta[k] * toRad), cosTh = sin((theta[k] + 90) * toRad);
+      Real cosH = cosTh * cosL + sinTh * sinRaCosDec;
+      Real sinH = sinTh * cosL - cosTh * sinRaCosDec;
+
+      Real x = cosH * sinLat - sinDec * cosLat;
+      Real z = cosH * cosLat + sinDec * sinLat;
+      az[k] = atan2(sinH, x) * toDeg + 180;
+      Real e = atan2(z, sqrt(x * x + sinH * sinH)) * toDeg;
+
+      // calcRefraction(), with both branches kept finite so the select vectorizes
+      bool low = e < (Real)-0.575;
+      Real eLow = low ? e : (Real)-0.575;
+      Real eHigh = low ? (Real)-0.575 : e;
+      Real rLow = (Real)(-20.774 / 3600) / tan(eLow * toRad);
+      Real rHigh = (Real)(1.02 / 60) / tan((eHigh + (Real)10.3 / (eHigh + (Real)5.11)) * toRad);
+      el[k] = e + (low ? rLow : rHigh);
+    }
+  }
+}
+
+void calcHorizontalCoordinatesBatch(const unsigned long utc[], size_t count, double latitude, double longitude,
+                                    double azimuth[], double elevation[])
+{
+  if (count > 0) batch<double>(utc, count, latitude, longitude, azimuth, elevation);
+}
+
+void calcHorizontalCoordinatesBatch(const unsigned long utc[], size_t count, float latitude, float longitude,
+                                    float azimuth[], float elevation[])
+{
+  if (count > 0) batch<float>(utc, count, latitude, longitude, azimuth, elevation);
+}
@@ -0,0 +1,32 @@
+//======================================================================================================================
+// SunPosition
+//
+// Sun position computations for the tracker, on top of SolarCalculator (which stays as the library ships it).
+//
+// Batch: the sun's horizontal coordinates for an array of timestamps, structure-of-arrays in and out. It computes
+// the same NOAA/Meeus chain as calcHorizontalCoordinates(), rearranged for throughput:
+//  - the terms that grow with time (mean longitude, mean anomaly, sidereal time) are reduced to one turn in double
+//    once per calendar day in the batch; within the day they advance by seconds times a rate, which stays accurate
+//    in float
+//  - right ascension, declination and hour angle are never formed: the horizontal vector comes straight from the
+//    sines and cosines of the longitude and the local sidereal angle, leaving two atan2 per position
+//  - the refraction branch is a select, and the inner loop over a block has no calls other than math functions, so
+//    GCC vectorizes it on x86 (-O3 -ffast-math, glibc's vector math) and the float version runs on the ESP32-S3's
+//    single-precision FPU
+//======================================================================================================================
+
+#ifndef SUNPOSITION_H
+#define SUNPOSITION_H
+
+#include <stddef.h>
+
+#define SUN_BATCH_BLOCK 64  // timestamps handled per inner loop
+
+// Sun's horizontal coordinates at count instants (Unix time), in degrees as calcHorizontalCoordinates() gives them:
+// azimuth from the North, elevation corrected for refraction. The output arrays must not overlap the input.
+void calcHorizontalCoordinatesBatch(const unsigned long utc[], size_t count, double latitude, double longitude,
+                                    double azimuth[], double elevation[]);
+void calcHorizontalCoordinatesBatch(const unsigned long utc[], size_t count, float latitude, float longitude,
+                                    float azimuth[], float elevation[]);
+
+#endif  //SUNPOSITION_H
@@ -0,0 +1,116 @@
+#include "SunPropagator.h"
+#include <math.h>
+#include <SolarCalculator.h>
+
+#define DEG_TO_RAD_D (M_PI / 180)
+
+// Radians per second, SolarCalculator's rates
+#define LONG_RATE (float)(36000.76983 / 36525 / 86400 * DEG_TO_RAD_D)
+#define ANOMALY_RATE (float)(35999.05029 / 36525 / 86400 * DEG_TO_RAD_D)
+#define SIDEREAL_RATE (float)(360.985647 / 86400 * DEG_TO_RAD_D)
+
+// Sine and cosine - 1 of a small angle (radians, below about 0.1) from their series. cos - 1 is kept apart from the
+// 1, which float would round it into.
+static void smallAngle(float angle, float& sinA, float& cosA1)
+{
+  float a2 = angle * angle;
+  sinA = angle * (1 - a2 / 6 * (1 - a2 / 20 * (1 - a2 / 42)));
+  cosA1 = -a2 / 2 * (1 - a2 / 12 * (1 - a2 / 30));
+}
+
+// sum + increment, with the part float rounds off kept in low for the next step (Kahan)
+static void addCompensated(float& sum, float& low, float increment)
+{
+  float y = increment + low;
+  float t = sum + y;
+  low = y - (t - sum);
+  sum = t;
+}
+
+void SunPropagator::Turning::set(double angle)
+{
+  s = (float)sin(angle);
+  c = (float)cos(angle);
+  sLow = (float)(sin(angle) - s);
+  cLow = (float)(cos(angle) - c);
+}
+
+void SunPropagator::Turning::rotate(float angle)
+{
+  float sinA, cosA1;
+  smallAngle(angle, sinA, cosA1);
+  float ds = s * cosA1 + c * sinA;
+  float dc = c * cosA1 - s * sinA;
+  addCompensated(s, sLow, ds);
+  addCompensated(c, cLow, dc);
+}
+
+SunPropagator::SunPropagator()
+    : valid(false), t0(0), now(0), interval(SUN_PROPAGATOR_ANCHOR_S), anchorCount(0), centre(0), sinEps(0), cosEps(1)
+{
+  meanLong.set(0);
+  meanAnomaly.set(0);
+  sidereal.set(0);
+}
+
+void SunPropagator::anchor(unsigned long utc, const Observer& observer)
+{
+  site = observer;
+  reanchor(utc);
+}
+
+void SunPropagator::reanchor(unsigned long utc)
+{
+  JulianDay jd(utc);
+  double T = calcJulianCent(jd);
+  double L0 = calcGeomMeanLongSun(T) * DEG_TO_RAD_D;
+  double M = calcGeomMeanAnomalySun(T) * DEG_TO_RAD_D;
+  double theta = (calcGrMeanSiderealTime(jd) + site.longitude()) * DEG_TO_RAD_D;
+  double eps = calcMeanObliquityOfEcliptic(T) * DEG_TO_RAD_D;
+
+  meanLong.set(L0);
+  meanAnomaly.set(M);
+  sidereal.set(theta);
+  sinEps = (float)sin(eps);
+  cosEps = (float)cos(eps);
+  centre = (float)(1.914602 - 0.004817 * T);
+
+  t0 = now = utc;
+  anchorCount++;
+  valid = true;
+}
+
+void SunPropagator::clear()
+{
+  valid = false;
+}
+
+void SunPropagator::update(unsigned long utc)
+{
+  long step = (long)(utc - now);
+  unsigned long age = utc >= t0 ? utc - t0 : t0 - utc;
+  if (!valid || age > interval || step > SUN_PROPAGATOR_MAX_STEP_S || step < -SUN_PROPAGATOR_MAX_STEP_S)
+  {
+    reanchor(utc);
+    return;
+  }
+  float dt = (float)step;
+  meanLong.rotate(LONG_RATE * dt);
+  meanAnomaly.rotate(ANOMALY_RATE * dt);
+  sidereal.rotate(SIDEREAL_RATE * dt);
+  now = utc;
+}
+
+void SunPropagator::position(float& azimuth, float& elevation) const
+{
+  // Apparent longitude: the mean longitude turned by the equation of centre less aberration, at most two degrees
+  float sinM = meanAnomaly.s, cosM = meanAnomaly.c;
+  float C = sinM * centre + 2 * sinM * cosM * 0.019993f;
+  float sinA, cosA1;
+  smallAngle((C - 0.00569f) * (float)DEG_TO_RAD_D, sinA, cosA1);
+  float sinL = meanLong.s + (meanLong.s * cosA1 + meanLong.c * sinA);
+  float cosL = meanLong.c + (meanLong.c * cosA1 - meanLong.s * sinA);
+
+  site.eclipticToHorizontal(sinL, cosL, sinEps, cosEps, sidereal.s, sidereal.c, azimuth, elevation);
+  elevation += calcRefractionF(elevation);
+}
@@ -0,0 +1,78 @@
+//======================================================================================================================
+// SunPropagator
+//
+// Sun position for a caller that steps through time a few seconds or minutes at a time. Every calculation from
+// scratch rebuilds the Julian century, reduces thousands of turns of mean longitude and sidereal time and takes
+// their sines; between two updates those angles only turn a little, at rates that are constant for all practical
+// purposes.
+//
+// SunPropagator anchors the sines and cosines of the mean longitude, the mean anomaly and the local sidereal angle to
+// the exact (double) calculation and then rotates each by the step, with the small rotation's sine and cosine from
+// their series. A position needs no trigonometry beyond the two atan2 and refraction. Each sine and cosine carries
+// the remainder float rounded off its last increment, since an increment a few ulp wide would otherwise be rounded
+// the same way step after step; what is left drifts slowly, and the state is re-anchored every
+// SUN_PROPAGATOR_ANCHOR_S, and on any step longer than SUN_PROPAGATOR_MAX_STEP_S.
+//======================================================================================================================
+
+#ifndef SUNPROPAGATOR_H
+#define SUNPROPAGATOR_H
+
+#include "Observer.h"
+
+#define SUN_PROPAGATOR_ANCHOR_S 3600UL  // longest between anchors
+#define SUN_PROPAGATOR_MAX_STEP_S 900L  // longer steps, either way, re-anchor instead
+
+class SunPropagator
+{
+public:
+  SunPropagator();
+
+  // Start from the exact calculation at utc (Unix time), seen from site
+  void anchor(unsigned long utc, const Observer& site);
+  void clear();
+
+  // Move on (or back) to utc from the last update, re-anchoring when due
+  void update(unsigned long utc);
+
+  // Longest between anchors, seconds; SUN_PROPAGATOR_ANCHOR_S unless set
+  void setAnchorInterval(unsigned long seconds) { interval = seconds; }
+
+  bool anchored() const { return valid; }
+  unsigned long time() const { return now; }
+  unsigned long anchorTime() const { return t0; }
+  unsigned long anchors() const { return anchorCount; }
+
+  // Sun's horizontal coordinates at time(), degrees, as calcHorizontalCoordinates() gives them: azimuth from the
+  // North, elevation corrected for refraction
+  void position(float& azimuth, float& elevation) const;
+
+private:
+  // Sine and cosine of an angle that turns with time, with the rounding remainders of their running sums
+  struct Turning
+  {
+    float s;
+    float c;
+    float sLow;
+    float cLow;
+
+    void set(double angle);
+    void rotate(float angle);
+  };
+
+  void reanchor(unsigned long utc);
+
+  Observer site;
+  bool valid;
+  unsigned long t0;
+  unsigned long now;
+  unsigned long interval;
+  unsigned long anchorCount;
+  Turning meanLong;
+  Turning meanAnomaly;
+  Turning sidereal;  // local sidereal angle
+  float centre;  // equation of centre: sin(M) coefficient, degrees, held at the anchor's value
+  float sinEps;  // obliquity of the ecliptic, held likewise
+  float cosEps;
+};
+
+#endif  //SUNPROPAGATOR_H
@@ -0,0 +1,61 @@
+#include "SunSource.h"
+#include <math.h>
+#include <SolarCalculator.h>
+
+SunSource::SunSource(const Observer& site) : observer(site), lookupCount(0)
+{
+}
+
+void SunSource::setSite(const Observer& site)
+{
+  observer = site;
+  ephemeris.clear();
+  propagator.clear();
+}
+
+void SunSource::refit(unsigned long utc)
+{
+  if (!ephemeris.covers(utc + SUN_EPHEMERIS_AHEAD_S)) ephemeris.fit(utc, observer);
+}
+
+void SunSource::positionNow(unsigned long utc, double& azimuth, double& elevation)
+{
+  if (!propagator.anchored()) propagator.anchor(utc, observer);
+  propagator.update(utc);
+  float az, el;
+  propagator.position(az, el);
+  azimuth = az;
+  elevation = el;
+  lookupCount++;
+}
+
+void SunSource::positionAt(unsigned long utc, double& azimuth, double& elevation)
+{
+  float az, el;
+  if (ephemeris.covers(utc))
+  {
+    ephemeris.position(utc, az, el);
+  }
+  else
+  {
+    if (!epoch.covers(utc)) epoch = SolarEpochF(utc);
+    observer.sunPosition(epoch, utc, az, el);
+  }
+  azimuth = az;
+  elevation = el;
+  lookupCount++;
+}
+
+unsigned long SunSource::nextSunrise(unsigned long utc) const
+{
+  unsigned long day = utc - utc % 86400UL;
+  for (int i = 0; i < 2; i++, day += 86400UL)
+  {
+    double transit, rise, set;
+    calcSunriseSunset(day, observer.latitude(), observer.longitude(), transit, rise, set, SUNRISE_ALTITUDE);
+    if (isnan(rise)) return 0;
+    unsigned long t = day + (long)(rise * 3600);
+    if (t > utc) return t;
+  }
+  return 0;
+}
@@ -0,0 +1,55 @@
+//======================================================================================================================
+// SunSource
+//
+// The sun as tracking sees it from the configured site. Two kinds of read:
+//  - now: the current position, read seconds to minutes apart by tracking updates, the status and the log, so it
+//    is stepped along from read to read by a SunPropagator
+//  - at: any other time - the next update, the points checked against the extrapolation, a zenith pass, sunrise -
+//    from the day's SunEphemeris, or from the single-precision chain outside the fit, timed from an epoch re-centred
+//    when it runs out
+// The ephemeris is refitted from the current time once less than SUN_EPHEMERIS_AHEAD_S of it is left.
+//======================================================================================================================
+
+#ifndef SUNSOURCE_H
+#define SUNSOURCE_H
+
+#include "Observer.h"
+#include "SolarCalculatorF.h"
+#include "SunEphemeris.h"
+#include "SunPropagator.h"
+
+#define SUN_EPHEMERIS_AHEAD_S (SUN_EPHEMERIS_SPAN_S - 86400)
+#define SUNRISE_ALTITUDE -0.5667  // geometric altitude at which the refracted sun reaches elevation 0
+
+class SunSource
+{
+public:
+  explicit SunSource(const Observer& site = Observer());
+
+  // Move to another site; the fit and the propagator made for the old one are dropped
+  void setSite(const Observer& site);
+  const Observer& site() const { return observer; }
+
+  // Refit the ephemeris from utc if less than SUN_EPHEMERIS_AHEAD_S of the current fit is left
+  void refit(unsigned long utc);
+
+  // Sun's horizontal coordinates, degrees, as calcHorizontalCoordinates() gives them: azimuth from the North,
+  // elevation corrected for refraction. positionNow() steps the propagator to utc; positionAt() takes any time.
+  void positionNow(unsigned long utc, double& azimuth, double& elevation);
+  void positionAt(unsigned long utc, double& azimuth, double& elevation);
+
+  // Next time after utc the sun reaches elevation 0; 0 if it does not rise (polar night or day)
+  unsigned long nextSunrise(unsigned long utc) const;
+
+  // Positions read so far, now and at other times
+  unsigned long lookups() const { return lookupCount; }
+
+private:
+  Observer observer;
+  SunEphemeris ephemeris;
+  SolarEpochF epoch;
+  SunPropagator propagator;
+  unsigned long lookupCount;
+};
+
+#endif  //SUNSOURCE_H
@@ -0,0 +1,273 @@
+#include "SunTracker.h"
+#include <math.h>
+#include <stdlib.h>
+#include <SolarCalculator.h>
+
+SunTracker::SunTracker(StepEngine& stepEngine, SunSource& sunSource, UtcClock utcClock, const GearRatio& azGear,
+                       const GearRatio& elGear, const CableWrap& wrap)
+  : engine(stepEngine), sun(sunSource), clock(utcClock), gearAz(azGear), gearEl(elGear), cableWrap(wrap),
+    velocity(true), deadbandMrad(DEFAULT_DEADBAND_MRAD), nightParking(true), keyholeRate(KEYHOLE_MAX_AZ_RATE),
+    sunDue(true), sunRead(false), lastSunUpdate(0), sunUpdateUtc(0), sunUpdateMs(SUN_UPDATE_INTERVAL_MS),
+    targetSunAz(0), targetSunEl(0), sunAzRate(0), sunElRate(0), keyholeCheckUtc(0), trackLocked(false),
+    acquiring(false), acquireStartMs(0), timeToLockMs(-1), trackPlanMs(0), parkState(PARK_NONE), sunriseUtc(0),
+    sunriseAz(0), sunriseEl(0)
+{
+}
+
+void SunTracker::start(unsigned long now)
+{
+  sunDue = true;
+  sunRead = false;
+  sunUpdateMs = SUN_UPDATE_INTERVAL_MS;
+  pass.clear();
+  keyholeCheckUtc = 0;
+  parkState = PARK_NONE;
+  resetAcquisition(now);
+}
+
+// Mechanical azimuth (degrees) for a bearing, reached from where the queued motion ends
+double SunTracker::mechanicalAz(double bearing, long fromSteps) const
+{
+  Angle current = angleSaturate(gearAz.toAngle(fromSteps));
+  return angleToDegrees(cableWrap.nearest(current, angleFromDegrees(bearing)));
+}
+
+long SunTracker::targetAzSteps(unsigned long now) const
+{
+  double t = (now - lastSunUpdate) / 1000.0;
+  if (pass.covers(sunUpdateUtc + (unsigned long)t)) return gearAz.degreesToSteps(pass.azimuth(sunUpdateUtc + t));
+  return gearAz.degreesToSteps(targetSunAz + sunAzRate * t);
+}
+
+long SunTracker::targetElSteps(unsigned long now) const
+{
+  return gearEl.degreesToSteps(targetSunEl + sunElRate * (now - lastSunUpdate) / 1000.0);
+}
+
+bool SunTracker::followsLine(unsigned long utc, unsigned long dtSec, double az, double el, double az2, double el2)
+{
+  unsigned long prev = 0;
+  for (uint8_t q = 1; q < SUN_LINE_PARTS; q++)
+  {
+    unsigned long at = dtSec * q / SUN_LINE_PARTS;
+    if (at == prev) continue;
+    prev = at;
+    double azAt, elAt;
+    sun.positionAt(utc + at, azAt, elAt);
+    double azOff = wrapTo180(azAt - az) - wrapTo180(az2 - az) * at / dtSec;
+    double elOff = elAt - el - (el2 - el) * at / dtSec;
+    if (fabs(azOff) * gearAz.stepsPerDegree() > SUN_LINE_MAX_STEPS ||
+        fabs(elOff) * gearEl.stepsPerDegree() > SUN_LINE_MAX_STEPS)
+      return false;
+  }
+  return true;
+}
+
+unsigned long SunTracker::sunMotion(unsigned long utc, unsigned long maxSec, double& azimuth, double& elevation,
+                                    double& azRate, double& elRate)
+{
+  double az2, el2;
+  unsigned long dtSec = maxSec;
+  sun.refit(utc);
+  sun.positionNow(utc, azimuth, elevation);
+  while (true)
+  {
+    sun.positionAt(utc + dtSec, az2, el2);
+    if (dtSec <= 1 || followsLine(utc, dtSec, azimuth, elevation, az2, el2)) break;
+    dtSec /= 2;
+  }
+  azRate = wrapTo180(az2 - azimuth) / dtSec;
+  elRate = (el2 - elevation) / dtSec;
+  return dtSec;
+}
+
+// Longest the next sun update may wait; sunMotion() shortens it to keep the extrapolation on the sun
+unsigned long SunTracker::sunUpdateLimit() const
+{
+  if (parkState == PARK_READY) return SUNRISE_UPDATE_INTERVAL_MS;
+  unsigned long ms = sunUpdateMs * 2 < SUN_UPDATE_MAX_MS ? sunUpdateMs * 2 : SUN_UPDATE_MAX_MS;
+  // While the sun is high, planKeyhole() looks ahead once a minute
+  if (targetSunEl >= KEYHOLE_WATCH_EL_DEG && ms > SUN_UPDATE_INTERVAL_MS) ms = SUN_UPDATE_INTERVAL_MS;
+  return ms;
+}
+
+// Search the next KEYHOLE_LOOKAHEAD_S for a near-zenith pass, at most once per sun update interval. A pass is
+// committed to once it is fully in view and followed unchanged until it has ended.
+void SunTracker::planKeyhole(unsigned long utc)
+{
+  if (pass.planned() && utc <= pass.endTime()) return;
+  pass.clear();
+  if (keyholeRate <= 0 || targetSunEl < KEYHOLE_WATCH_EL_DEG || utc - keyholeCheckUtc < SUN_UPDATE_INTERVAL_MS / 1000)
+    return;
+  keyholeCheckUtc = utc;
+
+  // From the same source as the tracking rate, so the ramp starts and ends where tracking meets it
+  double az[KEYHOLE_SAMPLES], el[KEYHOLE_SAMPLES];
+  for (uint8_t k = 0; k < KEYHOLE_SAMPLES; k++)
+    sun.positionAt(utc + k * KEYHOLE_SAMPLE_S, az[k], el[k]);
+  if (!pass.plan(utc, KEYHOLE_SAMPLE_S, az, el, KEYHOLE_SAMPLES, keyholeRate)) return;
+
+  // Put the ramp on the turn the axis reaches its start from. A swing into the cable wrap is left to normal
+  // tracking, which unwinds the long way round.
+  double start = mechanicalAz(pass.startAzimuth(), engine.plannedPosition(AXIS_AZ));
+  pass.shift(start - pass.startAzimuth());
+  Angle end = angleFromDegrees(pass.endAzimuth());
+  if (end < cableWrap.minAngle() || end > cableWrap.maxAngle()) pass.clear();
+}
+
+void SunTracker::resetAcquisition(unsigned long now)
+{
+  trackLocked = false;
+  acquiring = false;
+  acquireStartMs = now;
+  timeToLockMs = -1;
+}
+
+// Slew to the sun on a coordinated line when it is far off, then hand over to fine tracking. Returns true while the
+// slew is under way.
+bool SunTracker::acquireTarget(unsigned long now)
+{
+  if (acquiring)
+  {
+    if (engine.isSegmentBusy()) return true;
+    acquiring = false;
+  }
+  if (targetSunEl < 0) return false;
+
+  long azErr = targetAzSteps(now) - engine.position(AXIS_AZ);
+  long elErr = targetElSteps(now) - engine.position(AXIS_EL);
+
+  if (labs(azErr) > gearAz.degreesToSteps(ACQUIRE_THRESHOLD_DEG) ||
+      labs(elErr) > gearEl.degreesToSteps(ACQUIRE_THRESHOLD_DEG))
+  {
+    if (trackLocked)
+    {
+      trackLocked = false;
+      acquireStartMs = now;
+    }
+    // Drop queued tracking motion first; the slew is queued on a later update once the axes have stopped
+    if (engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL))
+    {
+      engine.stop(AXIS_AZ);
+      engine.stop(AXIS_EL);
+      return true;
+    }
+    acquiring = engine.queueLine(targetAzSteps(now), targetElSteps(now));
+    return true;
+  }
+
+  if (!trackLocked && labs(azErr) <= LOCK_THRESHOLD_STEPS && labs(elErr) <= LOCK_THRESHOLD_STEPS)
+  {
+    trackLocked = true;
+    timeToLockMs = now - acquireStartMs;
+  }
+  return false;
+}
+
+// Queue constant-rate segments that each end exactly on the extrapolated sun position; position error is absorbed
+// by the next segment
+void SunTracker::trackVelocity(unsigned long now)
+{
+  if (targetSunEl < 0) return;  // stop queuing; the queue runs dry
+
+  if (!engine.isSegmentBusy()) trackPlanMs = now;  // first segment, or the queue ran dry
+  while (engine.queuedSegments() < TRACK_QUEUE_AHEAD)
+  {
+    unsigned long end = trackPlanMs + TRACK_SEGMENT_MS;
+    if (!engine.queueTimed(targetAzSteps(end), targetElSteps(end), TRACK_SEGMENT_MS * 1000UL)) break;
+    trackPlanMs = end;
+  }
+}
+
+// The mirror turns half the angle the reflection does, and on the sky an azimuth error shrinks with the cosine of
+// the elevation (bounded near the zenith)
+void SunTracker::deadbandSteps(double elevation, float& azBand, float& elBand) const
+{
+  double mirrorDeg = deadbandMrad / 2000.0 * 180 / M_PI;
+  double c = cos(elevation * M_PI / 180);
+  azBand = mirrorDeg / (c < 0.1 ? 0.1 : c) * gearAz.stepsPerDegree();
+  elBand = mirrorDeg * gearEl.stepsPerDegree();
+}
+
+// One second on can round to no movement at all, hence the minute
+long SunTracker::leadSteps(long target, long minuteOn, float band)
+{
+  if (minuteOn == target) return 0;
+  return minuteOn > target ? (long)band : -(long)band;
+}
+
+// Wake the motors only once an axis is outside its deadband. Then correct every axis past half its band in the same
+// coordinated line, and lead the sun by a band, so the error swings across the whole band before the next correction.
+void SunTracker::trackSteps(unsigned long now)
+{
+  long azPos = engine.position(AXIS_AZ), elPos = engine.position(AXIS_EL);
+  long azTarget = targetAzSteps(now), elTarget = targetElSteps(now);
+  long diffAz = azTarget - azPos, diffEl = elTarget - elPos;
+
+  float azBand, elBand;
+  deadbandSteps(targetSunEl, azBand, elBand);
+  if (engine.isSegmentBusy() || (labs(diffAz) <= azBand && labs(diffEl) <= elBand)) return;
+
+  long azTo = azPos, elTo = elPos;
+  if (labs(diffAz) > azBand / 2) azTo = azTarget + leadSteps(azTarget, targetAzSteps(now + 60000), azBand);
+  if (labs(diffEl) > elBand / 2) elTo = elTarget + leadSteps(elTarget, targetElSteps(now + 60000), elBand);
+  engine.queueLine(azTo, elTo);
+}
+
+// Stow and pre-position between sunset and sunrise. Returns true while it owns the axes, i.e. at night.
+bool SunTracker::parkNight(unsigned long now)
+{
+  if (targetSunEl >= 0)
+  {
+    if (parkState != PARK_NONE)
+    {
+      parkState = PARK_NONE;
+      resetAcquisition(now);  // time to lock counts from sunrise
+    }
+    return false;
+  }
+  // Let queued tracking run out, or the last park move finish
+  if (engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL)) return true;
+  if (parkState == PARK_READY) return true;
+
+  unsigned long utc = sunUpdateUtc + (now - lastSunUpdate) / 1000;
+  if (parkState == PARK_NONE)
+  {
+    sunriseUtc = sun.nextSunrise(utc);
+    if (sunriseUtc == 0) return true;
+    sun.positionAt(sunriseUtc, sunriseAz, sunriseEl);
+  }
+  else if (utc < sunriseUtc - PREPOSITION_LEAD_S) return true;
+
+  long azSteps = gearAz.degreesToSteps(mechanicalAz(sunriseAz, engine.position(AXIS_AZ)));
+  if (utc >= sunriseUtc - PREPOSITION_LEAD_S)
+  {
+    if (engine.queueLine(azSteps, gearEl.degreesToSteps(sunriseEl))) parkState = PARK_READY;
+  }
+  else if (engine.queueLine(azSteps, gearEl.degreesToSteps(STOW_EL_DEG))) parkState = PARK_STOWED;
+  return true;
+}
+
+void SunTracker::update(unsigned long now)
+{
+  if (sunDue || now - lastSunUpdate >= sunUpdateMs)
+  {
+    sunDue = false;
+    lastSunUpdate = now;
+    unsigned long utc = clock();
+    if (utc == 0) return;
+    sunRead = true;
+    sunUpdateUtc = utc;
+    sunUpdateMs = sunMotion(utc, sunUpdateLimit() / 1000, targetSunAz, targetSunEl, sunAzRate, sunElRate) * 1000;
+    planKeyhole(utc);
+    // Within a pass the axis runs on the ramp; resolve against its end, where the sun meets it again
+    long wrapFrom = pass.covers(utc) ? gearAz.degreesToSteps(pass.endAzimuth()) : engine.plannedPosition(AXIS_AZ);
+    targetSunAz = mechanicalAz(targetSunAz, wrapFrom);
+  }
+  if (!sunRead) return;
+  if (nightParking && parkNight(now)) return;
+  if (acquireTarget(now)) return;
+
+  if (velocity) trackVelocity(now);
+  else trackSteps(now);
+}
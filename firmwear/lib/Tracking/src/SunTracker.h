@@ -0,0 +1,173 @@
+//======================================================================================================================
+// SunTracker
+//
+// The tracking policy: what the mount does with the sun, on the step engine, pass by pass. Each update() runs on the
+// caller's clock (milliseconds) and reads the time of day through a UtcClock only when the sun is due.
+//
+//  - Sun updates: the sun's position and angular rate are read from the SunSource and extrapolated in between. The
+//    next update is scheduled as late as the sun stays within SUN_LINE_MAX_STEPS of the extrapolation allows.
+//  - Acquisition: further than ACQUIRE_THRESHOLD_DEG from the sun (tracking start, a manual move), the mirror slews
+//    there on a coordinated line at full speed; lock is declared once both axes are within LOCK_THRESHOLD_STEPS.
+//  - Velocity tracking: constant-rate segments that each end exactly on the extrapolated sun position, kept
+//    TRACK_QUEUE_AHEAD deep, so the mirror moves at the sun's rate and a stalled loop does not interrupt it.
+//  - Step mode: periodic corrective moves, made only once an axis has drifted out of a deadband given as pointing
+//    error of the reflected beam.
+//  - Zenith passes: while the sun is high the trajectory is searched ahead for a pass and the azimuth swing replaced
+//    by a KeyholePass ramp.
+//  - Night parking: after sunset the mirror stows face up, turned to the azimuth the sun rises at, and moves to where
+//    it will appear PREPOSITION_LEAD_S before sunrise.
+//
+// Azimuths are mechanical angles within the cable wrap, reached from where the queued motion ends.
+//======================================================================================================================
+
+#ifndef SUNTRACKER_H
+#define SUNTRACKER_H
+
+#include "StepEngine.h"
+#include "GearRatio.h"
+#include "CableWrap.h"
+#include "Keyhole.h"
+#include "SunSource.h"
+
+#define SUN_UPDATE_INTERVAL_MS 60000   // before the first sun update; later intervals adapt to the sun's motion
+#define SUN_UPDATE_MAX_MS 300000
+#define SUN_LINE_PARTS 5               // the extrapolation is checked where it divides into this many parts
+#define SUN_LINE_MAX_STEPS 0.45        // microsteps the sun may stray off it there
+#define TRACK_UPDATE_INTERVAL_MS 5000  // update() cadence in step mode
+#define TRACK_VELOCITY_INTERVAL_MS 1000
+#define TRACK_SEGMENT_MS 1000          // duration of one queued velocity-tracking segment
+#define TRACK_QUEUE_AHEAD 3            // segments kept queued, i.e. how long a stalled loop is bridged
+
+// Near-zenith passes: the sun's azimuth rate grows without bound as it passes overhead
+#define KEYHOLE_WATCH_EL_DEG 80.0      // look for a pass while the sun is this high
+#define KEYHOLE_LOOKAHEAD_S 600
+#define KEYHOLE_SAMPLE_S 10
+#define KEYHOLE_SAMPLES (KEYHOLE_LOOKAHEAD_S / KEYHOLE_SAMPLE_S + 1)
+#define KEYHOLE_MAX_AZ_RATE 2.0f       // deg/s; constant-rate tracking segments stay well under the start rate
+
+#define ACQUIRE_THRESHOLD_DEG 1.0f     // slew instead of track when further than this from the sun
+#define LOCK_THRESHOLD_STEPS 3         // locked once both axes are within this many microsteps
+
+// Pointing error step-mode tracking lets build up before it moves, in mrad of the reflected beam at the target
+#define DEFAULT_DEADBAND_MRAD 2.0f
+
+#define STOW_EL_DEG 90.0
+#define PREPOSITION_LEAD_S 600
+#define SUNRISE_UPDATE_INTERVAL_MS 1000  // sun updates and update() cadence while waiting for sunrise, in either mode
+
+enum ParkState { PARK_NONE, PARK_STOWED, PARK_READY };
+
+// Unix time now, 0 while it is not known
+typedef unsigned long (*UtcClock)();
+
+class SunTracker
+{
+public:
+  // The gear ratios and the cable wrap are read on every update, so they can be recalibrated while tracking
+  SunTracker(StepEngine& stepEngine, SunSource& sunSource, UtcClock utcClock, const GearRatio& azGear,
+             const GearRatio& elGear, const CableWrap& wrap);
+
+  // Start tracking at now (ms): the sun is read on the first update, the time to lock counts from now
+  void start(unsigned long now);
+
+  // One tracking pass at now (ms)
+  void update(unsigned long now);
+
+  // Velocity tracking, or periodic corrective moves only
+  void setVelocityMode(bool on) { velocity = on; }
+  bool velocityMode() const { return velocity; }
+
+  // Azimuth rate limit through a near-zenith pass, deg/s; 0 leaves passes to normal tracking
+  void setKeyholeRate(float degPerSec) { keyholeRate = degPerSec; }
+
+  // Step-mode deadband, mrad of the reflected beam
+  void setDeadband(float mrad) { deadbandMrad = mrad; }
+  float deadband() const { return deadbandMrad; }
+
+  // Stow and pre-position between sunset and sunrise; off, the mirror stays where it stopped at dusk
+  void setNightParking(bool on) { nightParking = on; }
+
+  // How often update() wants to run: every second while pre-positioned for sunrise, so tracking starts as it rises
+  unsigned long updateInterval() const
+  {
+    if (parkState == PARK_READY) return SUNRISE_UPDATE_INTERVAL_MS;
+    return velocity ? TRACK_VELOCITY_INTERVAL_MS : TRACK_UPDATE_INTERVAL_MS;
+  }
+
+  bool locked() const { return trackLocked; }
+  long timeToLock() const { return timeToLockMs; }  // ms from start or sunrise until lock, -1 until then
+  ParkState park() const { return parkState; }
+  unsigned long sunUpdateInterval() const { return sunUpdateMs; }
+  const KeyholePass& keyhole() const { return pass; }
+
+  // Target position in microsteps at now (ms), extrapolated from the last sun update at the sun's angular rate, or
+  // on the azimuth ramp through a near-zenith pass
+  long targetAzSteps(unsigned long now) const;
+  long targetElSteps(unsigned long now) const;
+
+  // Sun position at utc (the current time, from the propagator) plus its angular rate (deg/s), as the secant to its
+  // position at the next update. That is scheduled as late as maxSec allows while the sun stays close enough to the
+  // secant (see followsLine), halving until it does. Returns the seconds until the next update.
+  unsigned long sunMotion(unsigned long utc, unsigned long maxSec, double& azimuth, double& elevation, double& azRate,
+                          double& elRate);
+
+  // True if the sun stays within SUN_LINE_MAX_STEPS of the straight line from (az, el) at utc to (az2, el2) dtSec
+  // later, on both axes. Checked at the points that divide it into SUN_LINE_PARTS: near the horizon refraction bends
+  // the elevation too sharply for the midpoint. Under half a microstep, so that with the rounding to whole microsteps
+  // the target is never further off than a fixed one-minute interval leaves it (see tools/sun_update_bench.cpp).
+  bool followsLine(unsigned long utc, unsigned long dtSec, double az, double el, double az2, double el2);
+
+  // Deadband in microsteps on each axis at an elevation (degrees)
+  void deadbandSteps(double elevation, float& azBand, float& elBand) const;
+
+  // Whole microsteps to lead the target by, in the direction it moves over the next minute
+  static long leadSteps(long target, long minuteOn, float band);
+
+private:
+  StepEngine& engine;
+  SunSource& sun;
+  UtcClock clock;
+  const GearRatio& gearAz;
+  const GearRatio& gearEl;
+  const CableWrap& cableWrap;
+  bool velocity;
+  float deadbandMrad;
+  bool nightParking;
+  float keyholeRate;
+
+  // Sun updates
+  bool sunDue;                  // read the sun on the next update
+  bool sunRead;                 // read since start()
+  unsigned long lastSunUpdate;  // ms
+  unsigned long sunUpdateUtc;
+  unsigned long sunUpdateMs;
+  double targetSunAz;           // degrees, mechanical
+  double targetSunEl;
+  double sunAzRate;             // deg/s, at lastSunUpdate
+  double sunElRate;
+
+  KeyholePass pass;
+  unsigned long keyholeCheckUtc;
+
+  bool trackLocked;
+  bool acquiring;
+  unsigned long acquireStartMs;
+  long timeToLockMs;
+  unsigned long trackPlanMs;    // time at which the last queued tracking segment ends
+
+  ParkState parkState;
+  unsigned long sunriseUtc;
+  double sunriseAz;
+  double sunriseEl;
+
+  double mechanicalAz(double bearing, long fromSteps) const;
+  unsigned long sunUpdateLimit() const;
+  void planKeyhole(unsigned long utc);
+  void resetAcquisition(unsigned long now);
+  bool acquireTarget(unsigned long now);
+  void trackVelocity(unsigned long now);
+  void trackSteps(unsigned long now);
+  bool parkNight(unsigned long now);
+};
+
+#endif  //SUNTRACKER_H
@@ -5,24 +5,52 @@
 #include <time.h>
 #include <Preferences.h>
 #include <SolarCalculator.h>
+#include <StepEngine.h>
+#include <MotionPlanner.h>
+#include <GearRatio.h>
+#include <CableWrap.h>
+#include <Observer.h>
+#include <SunSource.h>
+#include <SunTracker.h>
+#include <StepDriver.h>
+#include "MountConfig.h"
 
 /* ========= WIFI ========= */
 const char* ssid = "wifi";
 const char* password = "pass";
 
-/* ========= STEPPER PINS ========= */
-#define STEP_X 13
-#define DIR_X  12
-#define STEP_Y 18
-#define DIR_Y  17
-#define SLEEP_RESET_STEP_PIN  6
-
 /* ========= GEAR CALIBRATION (microsteps per degree) ========= */
-// Defaults: Azimuth 17:144, Elevation 21:64. Adjust via Preferences for backlash.
-#define DEFAULT_MICROSTEPS_PER_DEG_AZ  (3200.0 * 144.0 / 17.0 / 360.0)
-#define DEFAULT_MICROSTEPS_PER_DEG_EL  (3200.0 * 64.0 / 21.0 / 360.0)
-float microstepsPerDegAz = DEFAULT_MICROSTEPS_PER_DEG_AZ;
-float microstepsPerDegEl = DEFAULT_MICROSTEPS_PER_DEG_EL;
+// Defaults in MountConfig.h, adjustable via Preferences as numerator/denominator; backlash is separate (below).
+GearRatio gearAz = DEFAULT_GEAR_AZ;
+GearRatio gearEl = DEFAULT_GEAR_EL;
+
+/* ========= BACKLASH (from Preferences) ========= */
+// Play in each gear train, in motor microsteps. Taken up with uncounted steps whenever an axis reverses.
+uint16_t backlashAz = 0;
+uint16_t backlashEl = 0;
+uint8_t backlashPolicy = BACKLASH_TAKEUP;   // or approach every stop from one side, see BacklashPolicy
+
+/* ========= CABLE WRAP (from Preferences) ========= */
+// Mechanical azimuth range the cables allow, degrees from the aligned (north) position. Bearings are reached the
+// short way round unless that leaves this range.
+CableWrap cableWrap(angleFromDegrees(DEFAULT_WRAP_MIN_DEG), angleFromDegrees(DEFAULT_WRAP_MAX_DEG));
+
+// Mechanical azimuth (degrees) for a bearing, reached from fromSteps
+double mechanicalAz(double bearing, long fromSteps) {
+  Angle current = angleSaturate(gearAz.toAngle(fromSteps));
+  return angleToDegrees(cableWrap.nearest(current, angleFromDegrees(bearing)));
+}
+
+/* ========= ELEVATION LIMITS ========= */
+// Goto and path targets outside EL_MIN_DEG..EL_MAX_DEG are refused
+bool elevationInRange(float elDeg) {
+  return elDeg >= EL_MIN_DEG && elDeg <= EL_MAX_DEG;
+}
+
+/* ========= RESONANCE BANDS (from Preferences) ========= */
+// Step rates (steps/s) where an axis's motor and gear train resonate; moves ramp through them but never cruise
+// inside. low == high marks an unused band.
+float resonanceBands[AXIS_COUNT][STEP_RESONANCE_BANDS][2];
 
 /* ========= SERVERS ========= */
 WebServer server(80);
@@ -32,43 +60,32 @@ Preferences prefs;
 /* ========= CONFIG (from Preferences) ========= */
 float configLat = 48.21;
 float configLon = 16.37;
+SunSource sun(Observer(configLat, configLon));   // the sun seen from configLat/configLon, kept in step by the config
 int configGmtOffsetSec = 3600;   // UTC+1
 int configDstOffsetSec = 3600;   // DST
 bool configSetupDone = false;
 
 /* ========= STEPPER STATE ========= */
-bool motorX_Running = false;
-bool motorY_Running = false;
-unsigned long lastStepX = 0;
-unsigned long lastStepY = 0;
-unsigned long stepInterval = 1000;
+StepEngine stepper;
+#define USE_RMT_STEPPING 1   // 0: bit-bang STEP/DIR from a timer ISR instead of the RMT peripheral
+#if USE_RMT_STEPPING
+RmtStepDriver stepDriver;
+#else
+TimerStepDriver stepDriver;
+#endif
+MotionPlanner planner(stepper);
+unsigned long stepInterval = 250;    // Jog cruise step period (us)
 
 /* ========= TRACKING STATE ========= */
 bool trackingActive = false;
-float currentAzDeg = 0;   // Current mirror azimuth (degrees)
-float currentElDeg = 0;   // Current mirror elevation (degrees)
-long currentAzMicrosteps = 0;
-long currentElMicrosteps = 0;
 unsigned long lastTrackUpdate = 0;
-#define TRACK_UPDATE_INTERVAL_MS 5000
 
 /* ========= STEPPER FUNCTIONS ========= */
-void stepMotor(int pin) {
-  digitalWrite(pin, HIGH);
-  delayMicroseconds(2);
-  digitalWrite(pin, LOW);
-}
+const uint8_t stepPins[AXIS_COUNT] = { STEP_X, STEP_Y };
+const uint8_t dirPins[AXIS_COUNT] = { DIR_X, DIR_Y };
 
-void updateSteppers() {
-  unsigned long now = micros();
-  if (motorX_Running && (now - lastStepX >= stepInterval)) {
-    lastStepX = now;
-    stepMotor(STEP_X);
-  }
-  if (motorY_Running && (now - lastStepY >= stepInterval)) {
-    lastStepY = now;
-    stepMotor(STEP_Y);
-  }
+float jogRate() {
+  return 1000000.0f / stepInterval;
 }
 
 /* ========= NTP & TIME ========= */
@@ -88,66 +105,121 @@ time_t getUtcTime() {
 }
 
 /* ========= SUN POSITION ========= */
+// The current sun position (status, log, tracking updates) is stepped along from read to read; look-ahead comes from
+// the day's fit, see SunSource
 bool getSunPosition(double& azimuth, double& elevation) {
   time_t utc = getUtcTime();
   if (utc == 0) return false;
-  calcHorizontalCoordinates((unsigned long)utc, configLat, configLon, azimuth, elevation);
+  sun.positionNow((unsigned long)utc, azimuth, elevation);
   return true;
 }
 
 /* ========= TRACKING ========= */
-unsigned long lastSunUpdate = 0;
-unsigned long lastTrackStep = 0;
-double targetSunAz = 0, targetSunEl = 0;
-#define SUN_UPDATE_INTERVAL_MS 60000
-#define TRACK_STEP_INTERVAL_US 2000
+// Sun updates, acquisition, velocity or step-mode tracking, zenith passes and night parking: see SunTracker. It reads
+// the time of day only when the sun is due.
+unsigned long trackingUtc() {
+  return (unsigned long)getUtcTime();
+}
+
+SunTracker tracker(stepper, sun, trackingUtc, gearAz, gearEl, cableWrap);
+unsigned long loggedKeyholeUtc = 0;
 
 void updateTracking() {
   if (!trackingActive || !configSetupDone) return;
 
-  unsigned long now = millis();
-  if (now - lastSunUpdate >= SUN_UPDATE_INTERVAL_MS) {
-    lastSunUpdate = now;
-    if (!getSunPosition(targetSunAz, targetSunEl)) return;
-    if (targetSunEl < 0) return;
+  tracker.update(millis());
+
+  const KeyholePass& pass = tracker.keyhole();
+  if (pass.planned() && pass.startTime() != loggedKeyholeUtc) {
+    loggedKeyholeUtc = pass.startTime();
+    Serial.printf("Keyhole pass: sun az rate %.2f deg/s, ramp %.1f -> %.1f deg, error %.3f deg\n", pass.peakRate(),
+                  pass.startAzimuth(), pass.endAzimuth(), pass.maxError());
   }
+}
 
-  unsigned long nowUs = micros();
-  if (nowUs - lastTrackStep < TRACK_STEP_INTERVAL_US) return;
-  lastTrackStep = nowUs;
+/* ========= LOAD / SAVE CONFIG ========= */
+void saveDeadband(float mrad) {
+  prefs.begin("heliostat", false);
+  prefs.putFloat("deadband", mrad);
+  prefs.end();
+  tracker.setDeadband(mrad);
+}
 
-  long targetAzMicrosteps = (long)(targetSunAz * microstepsPerDegAz);
-  long targetElMicrosteps = (long)(targetSunEl * microstepsPerDegEl);
+void applyBacklash() {
+  stepper.setBacklash(AXIS_AZ, backlashAz, (BacklashPolicy)backlashPolicy);
+  stepper.setBacklash(AXIS_EL, backlashEl, (BacklashPolicy)backlashPolicy);
+}
 
-  long diffAz = targetAzMicrosteps - currentAzMicrosteps;
-  long diffEl = targetElMicrosteps - currentElMicrosteps;
+void saveBacklash(uint16_t az, uint16_t el, uint8_t policy) {
+  prefs.begin("heliostat", false);
+  prefs.putUShort("blAz", az);
+  prefs.putUShort("blEl", el);
+  prefs.putUChar("blPolicy", policy);
+  prefs.end();
+  backlashAz = az;
+  backlashEl = el;
+  backlashPolicy = policy;
+  applyBacklash();
+}
 
-  if (abs(diffAz) > 2) {
-    digitalWrite(DIR_X, diffAz > 0 ? HIGH : LOW);
-    stepMotor(STEP_X);
-    currentAzMicrosteps += (diffAz > 0 ? 1 : -1);
-  }
-  if (abs(diffEl) > 2) {
-    digitalWrite(DIR_Y, diffEl > 0 ? HIGH : LOW);
-    stepMotor(STEP_Y);
-    currentElMicrosteps += (diffEl > 0 ? 1 : -1);
+void applyResonanceBands() {
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    for (uint8_t b = 0; b < STEP_RESONANCE_BANDS; b++)
+      stepper.setResonanceBand(i, b, resonanceBands[i][b][0], resonanceBands[i][b][1]);
+}
+
+void saveResonanceBands(uint8_t axis, const float bands[STEP_RESONANCE_BANDS][2]) {
+  for (uint8_t b = 0; b < STEP_RESONANCE_BANDS; b++) {
+    resonanceBands[axis][b][0] = bands[b][0];
+    resonanceBands[axis][b][1] = bands[b][1];
   }
+  prefs.begin("heliostat", false);
+  prefs.putBytes("resBands", resonanceBands, sizeof(resonanceBands));
+  prefs.end();
+  applyResonanceBands();
+}
 
-  currentAzDeg = (float)currentAzMicrosteps / microstepsPerDegAz;
-  currentElDeg = (float)currentElMicrosteps / microstepsPerDegEl;
+void saveCableWrap(float minDeg, float maxDeg) {
+  prefs.begin("heliostat", false);
+  prefs.putFloat("wrapMin", minDeg);
+  prefs.putFloat("wrapMax", maxDeg);
+  prefs.end();
+  cableWrap = CableWrap(angleFromDegrees(minDeg), angleFromDegrees(maxDeg));
+}
+
+// Gear ratio from Preferences: the exact fraction, or else the float microsteps per degree (calAz/calEl) kept before
+// there was one. A zero numerator or denominator is corrupt and gives the default.
+GearRatio loadGearRatio(const char* numKey, const char* denKey, const char* legacyKey, const GearRatio& fallback) {
+  if (prefs.isKey(numKey)) {
+    uint32_t num = prefs.getUInt(numKey, 0);
+    uint32_t den = prefs.getUInt(denKey, 0);
+    return num > 0 && den > 0 ? GearRatio(num, den) : fallback;
+  }
+  float legacy = prefs.getFloat(legacyKey, 0);
+  return legacy > 0 ? GearRatio::fromStepsPerDegree(legacy) : fallback;
 }
 
-/* ========= LOAD / SAVE CONFIG ========= */
 void loadConfig() {
   prefs.begin("heliostat", true);
   configSetupDone = prefs.getBool("setup", false);
   configLat = prefs.getFloat("lat", 48.21);
   configLon = prefs.getFloat("lon", 16.37);
+  sun.setSite(Observer(configLat, configLon));
   configGmtOffsetSec = prefs.getInt("gmt", 3600);
   configDstOffsetSec = prefs.getInt("dst", 3600);
-  microstepsPerDegAz = prefs.getFloat("calAz", DEFAULT_MICROSTEPS_PER_DEG_AZ);
-  microstepsPerDegEl = prefs.getFloat("calEl", DEFAULT_MICROSTEPS_PER_DEG_EL);
+  gearAz = loadGearRatio("gearAzN", "gearAzD", "calAz", DEFAULT_GEAR_AZ);
+  gearEl = loadGearRatio("gearElN", "gearElD", "calEl", DEFAULT_GEAR_EL);
+  backlashAz = prefs.getUShort("blAz", 0);
+  backlashEl = prefs.getUShort("blEl", 0);
+  backlashPolicy = prefs.getUChar("blPolicy", BACKLASH_TAKEUP);
+  cableWrap = CableWrap(angleFromDegrees(prefs.getFloat("wrapMin", DEFAULT_WRAP_MIN_DEG)),
+                        angleFromDegrees(prefs.getFloat("wrapMax", DEFAULT_WRAP_MAX_DEG)));
+  tracker.setDeadband(prefs.getFloat("deadband", DEFAULT_DEADBAND_MRAD));
+  if (prefs.getBytes("resBands", resonanceBands, sizeof(resonanceBands)) != sizeof(resonanceBands))
+    memset(resonanceBands, 0, sizeof(resonanceBands));
   prefs.end();
+  applyBacklash();
+  applyResonanceBands();
 }
 
 void saveConfig(float lat, float lon, int gmtSec, int dstSec) {
@@ -157,11 +229,14 @@ void saveConfig(float lat, float lon, int gmtSec, int dstSec) {
   prefs.putFloat("lon", lon);
   prefs.putInt("gmt", gmtSec);
   prefs.putInt("dst", dstSec);
-  prefs.putFloat("calAz", microstepsPerDegAz);
-  prefs.putFloat("calEl", microstepsPerDegEl);
+  prefs.putUInt("gearAzN", gearAz.num());
+  prefs.putUInt("gearAzD", gearAz.den());
+  prefs.putUInt("gearElN", gearEl.num());
+  prefs.putUInt("gearElD", gearEl.den());
   prefs.end();
   configLat = lat;
   configLon = lon;
+  sun.setSite(Observer(configLat, configLon));   // drops the fit made for the old site
   configGmtOffsetSec = gmtSec;
   configDstOffsetSec = dstSec;
   configSetupDone = true;
@@ -187,38 +262,199 @@ void sendStatus(uint8_t num) {
 
   String json = "{\"status\":{";
   json += "\"tracking\":" + String(trackingActive ? "true" : "false") + ",";
+  json += "\"trackMode\":\"" + String(tracker.velocityMode() ? "velocity" : "step") + "\",";
   json += "\"setupDone\":" + String(configSetupDone ? "true" : "false") + ",";
   json += "\"sunAz\":" + String(sunAz, 2) + ",";
   json += "\"sunEl\":" + String(sunEl, 2) + ",";
-  json += "\"mirrorAz\":" + String(currentAzDeg, 2) + ",";
-  json += "\"mirrorEl\":" + String(currentElDeg, 2) + ",";
+  json += "\"mirrorAz\":" + String(gearAz.stepsToDegrees(stepper.position(AXIS_AZ)), 2) + ",";
+  json += "\"mirrorEl\":" + String(gearEl.stepsToDegrees(stepper.position(AXIS_EL)), 2) + ",";
+  json += "\"locked\":" + String(tracker.locked() ? "true" : "false") + ",";
+  json += "\"timeToLock\":" + String(tracker.timeToLock() < 0 ? -1.0f : tracker.timeToLock() / 1000.0f, 1) + ",";
+  json += "\"backlashAz\":" + String(backlashAz) + ",";
+  json += "\"backlashEl\":" + String(backlashEl) + ",";
+  json += "\"backlashPolicy\":" + String(backlashPolicy) + ",";
+  json += "\"wrapMin\":" + String(angleToDegrees(cableWrap.minAngle()), 1) + ",";
+  json += "\"wrapMax\":" + String(angleToDegrees(cableWrap.maxAngle()), 1) + ",";
+  json += "\"deadband\":" + String(tracker.deadband(), 2) + ",";
+  json += "\"resonance\":{";
+  for (uint8_t i = 0; i < AXIS_COUNT; i++) {
+    json += String(i == AXIS_AZ ? "\"az\":[" : ",\"el\":[");
+    bool first = true;
+    for (uint8_t b = 0; b < STEP_RESONANCE_BANDS; b++) {
+      if (resonanceBands[i][b][0] >= resonanceBands[i][b][1]) continue;
+      json += String(first ? "" : ",") + "[" + String(resonanceBands[i][b][0], 0) + "," + String(resonanceBands[i][b][1], 0) + "]";
+      first = false;
+    }
+    json += "]";
+  }
+  json += "},";
+  json += "\"sunUpdate\":" + String(tracker.sunUpdateInterval() / 1000) + ",";
+  json += "\"park\":\"" + String(tracker.park() == PARK_STOWED ? "stowed" : tracker.park() == PARK_READY ? "ready" : "none") + "\",";
+  json += "\"keyhole\":" + String(tracker.keyhole().planned() ? "true" : "false") + ",";
+  json += "\"keyholeErr\":" + String(tracker.keyhole().maxError(), 3) + ",";
+  json += "\"stepFaults\":" + String(stepDriver.faults()) + ",";
   json += "\"time\":\"" + String(timeStr) + "\"";
   json += "}}";
   webSocket.sendTXT(num, json);
 }
 
+/* ========= PATH MOVES ========= */
+// "az,el;az,el;..." in degrees. The waypoints are blended through their corners by the look-ahead planner.
+// Returns the number of waypoints queued, or -1 if the path was rejected.
+int queuePath(const String& points) {
+  if (trackingActive || stepper.isRunning(AXIS_AZ) || stepper.isRunning(AXIS_EL)) return -1;
+
+  planner.clear();
+  long azSteps = stepper.position(AXIS_AZ);
+  int start = 0;
+  while (start < (int)points.length()) {
+    int end = points.indexOf(';', start);
+    if (end < 0) end = points.length();
+    int sep = points.indexOf(',', start);
+    if (sep < 0 || sep > end) return -1;
+    float az = points.substring(start, sep).toFloat();
+    float el = points.substring(sep + 1, end).toFloat();
+    if (!elevationInRange(el)) return -1;
+    azSteps = gearAz.degreesToSteps(mechanicalAz(az, azSteps));
+    if (!planner.addWaypoint(azSteps, gearEl.degreesToSteps(el))) return -1;
+    start = end + 1;
+  }
+  int count = planner.pending();
+  return planner.execute() ? count : -1;
+}
+
+/* ========= GOTO ========= */
+// Absolute pointing (parking, known bearings) along one coordinated line, as fast as both axes allow. Tracking
+// stops; the move is queued as soon as the axes are idle. The client gets the ETA when the move starts and a
+// completion message when it ends (ok = arrived, not interrupted by a jog or another command). A target the mount
+// cannot reach is refused straight away: ok = 0 in the binary reply, an error in the text one.
+// Binary frames are little-endian: [opcode][payload].
+#define BIN_GOTO        0x01   // float az, float el (degrees)
+#define BIN_GOTO_REPLY  0x81   // uint8 ok, uint32 eta (ms)
+#define BIN_GOTO_DONE   0x82   // uint8 ok
+
+bool gotoPending = false;
+bool gotoActive = false;
+double gotoAzBearing = 0;   // resolved to a mechanical angle once the axes are idle
+long gotoAzSteps = 0;
+long gotoElSteps = 0;
+uint8_t gotoClient = 0;
+bool gotoBinary = false;
+
+void sendGotoReply(bool ok, float etaSec, const char* error = NULL) {
+  if (gotoBinary) {
+    uint32_t etaMs = ok ? (uint32_t)(etaSec * 1000.0f) : 0;
+    uint8_t frame[6] = { BIN_GOTO_REPLY, ok, (uint8_t)etaMs, (uint8_t)(etaMs >> 8), (uint8_t)(etaMs >> 16), (uint8_t)(etaMs >> 24) };
+    webSocket.sendBIN(gotoClient, frame, sizeof(frame));
+    return;
+  }
+  String json = "{\"goto\":{\"ok\":" + String(ok ? "true" : "false");
+  json += ",\"eta\":" + String(ok ? etaSec : 0.0f, 1);
+  if (error) json += ",\"error\":\"" + String(error) + "\"";
+  json += "}}";
+  webSocket.sendTXT(gotoClient, json);
+}
+
+void sendGotoDone(bool ok) {
+  if (gotoBinary) {
+    uint8_t frame[2] = { BIN_GOTO_DONE, ok };
+    webSocket.sendBIN(gotoClient, frame, sizeof(frame));
+    return;
+  }
+  String json = "{\"goto\":{\"done\":" + String(ok ? "true" : "false") + "}}";
+  webSocket.sendTXT(gotoClient, json);
+}
+
+void cancelGoto() {
+  if (gotoActive || gotoPending) sendGotoDone(false);
+  gotoActive = false;
+  gotoPending = false;
+}
+
+void updateGoto() {
+  bool idle = !stepper.isRunning(AXIS_AZ) && !stepper.isRunning(AXIS_EL);
+  if (gotoPending && idle) {
+    gotoPending = false;
+    gotoAzSteps = gearAz.degreesToSteps(mechanicalAz(gotoAzBearing, stepper.position(AXIS_AZ)));
+    float eta = stepper.lineTime(gotoAzSteps, gotoElSteps);
+    gotoActive = stepper.queueLine(gotoAzSteps, gotoElSteps);
+    sendGotoReply(gotoActive, eta);
+  }
+  else if (gotoActive && idle) {
+    gotoActive = false;
+    sendGotoDone(stepper.position(AXIS_AZ) == gotoAzSteps && stepper.position(AXIS_EL) == gotoElSteps);
+  }
+}
+
+void requestGoto(uint8_t num, float azDeg, float elDeg, bool binary) {
+  cancelGoto();
+  gotoClient = num;
+  gotoBinary = binary;
+  if (isnan(azDeg) || isnan(elDeg)) {
+    sendGotoReply(false, 0, "bad az/el");
+    return;
+  }
+  if (!elevationInRange(elDeg)) {
+    sendGotoReply(false, 0, "elevation out of range");
+    return;
+  }
+  trackingActive = false;
+  stepper.stop(AXIS_AZ);
+  stepper.stop(AXIS_EL);
+  gotoAzBearing = azDeg;
+  gotoElSteps = gearEl.degreesToSteps(elDeg);
+  gotoPending = true;
+  updateGoto();
+}
+
 void onWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t length) {
-  if (type == WStype_TEXT) {
+  if (type == WStype_BIN) {
+    if (length >= 9 && payload[0] == BIN_GOTO) {
+      float az, el;
+      memcpy(&az, payload + 1, sizeof(az));
+      memcpy(&el, payload + 5, sizeof(el));
+      requestGoto(num, az, el, true);
+    }
+  }
+  else if (type == WStype_TEXT) {
     String msg = (char*)payload;
 
-    if (msg == "X_fwd") { digitalWrite(DIR_X, HIGH); motorX_Running = true; }
-    else if (msg == "X_rev") { digitalWrite(DIR_X, LOW); motorX_Running = true; }
-    else if (msg == "X_stop") { motorX_Running = false; }
-    else if (msg == "Y_fwd") { digitalWrite(DIR_Y, HIGH); motorY_Running = true; }
-    else if (msg == "Y_rev") { digitalWrite(DIR_Y, LOW); motorY_Running = true; }
-    else if (msg == "Y_stop") { motorY_Running = false; }
+    if (msg == "X_fwd") { stepper.run(AXIS_AZ, true, jogRate()); }
+    else if (msg == "X_rev") { stepper.run(AXIS_AZ, false, jogRate()); }
+    else if (msg == "X_stop") { stepper.stop(AXIS_AZ); }
+    else if (msg == "Y_fwd") { stepper.run(AXIS_EL, true, jogRate()); }
+    else if (msg == "Y_rev") { stepper.run(AXIS_EL, false, jogRate()); }
+    else if (msg == "Y_stop") { stepper.stop(AXIS_EL); }
 
     else if (msg == "get_status") { sendStatus(num); }
 
     else if (msg == "start_track") {
+      cancelGoto();
       trackingActive = true;
-      lastSunUpdate = 0;
+      tracker.start(millis());
+      sendStatus(num);
+    }
+    else if (msg == "track_mode:velocity" || msg == "track_mode:step") {
+      tracker.setVelocityMode(msg == "track_mode:velocity");
+      stepper.stop(AXIS_AZ);
+      stepper.stop(AXIS_EL);
       sendStatus(num);
     }
+    else if (msg.startsWith("goto:")) {
+      int sep = msg.indexOf(',', 5);
+      if (sep > 0) requestGoto(num, msg.substring(5, sep).toFloat(), msg.substring(sep + 1).toFloat(), false);
+      else requestGoto(num, NAN, NAN, false);
+    }
+    else if (msg.startsWith("path:")) {
+      int count = queuePath(msg.substring(5));
+      String json = "{\"path\":{\"ok\":" + String(count >= 0 ? "true" : "false");
+      json += ",\"waypoints\":" + String(count < 0 ? 0 : count) + "}}";
+      webSocket.sendTXT(num, json);
+    }
     else if (msg == "stop_track") {
       trackingActive = false;
-      motorX_Running = false;
-      motorY_Running = false;
+      stepper.stop(AXIS_AZ);
+      stepper.stop(AXIS_EL);
       sendStatus(num);
     }
 
@@ -237,11 +473,66 @@ void onWebSocketEvent(uint8_t num, WStype_t type, uint8_t* payload, size_t lengt
       }
     }
 
+    // backlash:<az>,<el>,<policy>  microsteps; policy 0 = take up only, 1/2 = approach forward/reverse
+    else if (msg.startsWith("backlash:")) {
+      int sep1 = msg.indexOf(',', 9);
+      int sep2 = msg.indexOf(',', sep1 + 1);
+      if (sep1 > 0 && sep2 > 0) {
+        long az = msg.substring(9, sep1).toInt();
+        long el = msg.substring(sep1 + 1, sep2).toInt();
+        long policy = msg.substring(sep2 + 1).toInt();
+        if (az >= 0 && az <= 0xFFFF && el >= 0 && el <= 0xFFFF && policy >= 0 && policy <= BACKLASH_APPROACH_REVERSE) {
+          saveBacklash(az, el, policy);
+        }
+      }
+      sendStatus(num);
+    }
+
+    // cable_wrap:<min>,<max>  mechanical azimuth range in degrees
+    else if (msg.startsWith("cable_wrap:")) {
+      int sep = msg.indexOf(',', 11);
+      if (sep > 0) {
+        float minDeg = msg.substring(11, sep).toFloat();
+        float maxDeg = msg.substring(sep + 1).toFloat();
+        if (minDeg < maxDeg) saveCableWrap(minDeg, maxDeg);
+      }
+      sendStatus(num);
+    }
+
+    // resonance:<az|el>[,<low>,<high>...]  forbidden cruise step rates (steps/s) of an axis; no bands clears them
+    else if (msg.startsWith("resonance:")) {
+      String args = msg.substring(10);
+      int sep = args.indexOf(',');
+      String axisName = sep < 0 ? args : args.substring(0, sep);
+      if (axisName == "az" || axisName == "el") {
+        float bands[STEP_RESONANCE_BANDS][2] = {};
+        bool ok = true;
+        for (uint8_t b = 0; b < STEP_RESONANCE_BANDS && sep >= 0; b++) {
+          int sep2 = args.indexOf(',', sep + 1);
+          if (sep2 < 0) { ok = false; break; }
+          int sep3 = args.indexOf(',', sep2 + 1);
+          bands[b][0] = args.substring(sep + 1, sep2).toFloat();
+          bands[b][1] = (sep3 < 0 ? args.substring(sep2 + 1) : args.substring(sep2 + 1, sep3)).toFloat();
+          if (bands[b][0] < 0 || bands[b][0] >= bands[b][1]) ok = false;
+          sep = sep3;
+        }
+        if (ok && sep < 0) saveResonanceBands(axisName == "az" ? AXIS_AZ : AXIS_EL, bands);
+      }
+      sendStatus(num);
+    }
+
+    // deadband:<mrad>  step-mode tracking error budget at the target
+    else if (msg.startsWith("deadband:")) {
+      float mrad = msg.substring(9).toFloat();
+      if (mrad > 0 && mrad <= 50) saveDeadband(mrad);
+      sendStatus(num);
+    }
+
     else if (msg == "reset_setup") {
       resetSetup();
       trackingActive = false;
-      motorX_Running = false;
-      motorY_Running = false;
+      stepper.stop(AXIS_AZ);
+      stepper.stop(AXIS_EL);
       sendStatus(num);
     }
   }
@@ -352,6 +643,11 @@ const char* htmlPage = R"rawliteral(
         <button id="down" style="font-size: 24px;">&darr;</button>
         <button id="downRight" style="font-size: 20px;">&searr;</button>
       </div>
+      <label>Go to azimuth / elevation (degrees)</label>
+      <input type="number" id="gotoAz" step="0.01" placeholder="Azimuth">
+      <input type="number" id="gotoEl" step="0.01" min="0" max="90" placeholder="Elevation">
+      <button class="primary" id="btnGoto">Go</button>
+      <p id="gotoMsg" style="font-size: 13px; margin-top: 8px; color: #4ade80;"></p>
     </div>
 
     <div id="panelTrack" class="panel">
@@ -361,6 +657,7 @@ const char* htmlPage = R"rawliteral(
         <div class="status-row">Sun Elevation: <span id="sunEl">-</span></div>
         <div class="status-row">Mirror Az: <span id="mirrorAz">-</span></div>
         <div class="status-row">Mirror El: <span id="mirrorEl">-</span></div>
+        <div class="status-row">Time to Lock: <span id="timeToLock">-</span></div>
         <div class="status-row">Time: <span id="time">-</span></div>
       </div>
       <div class="grid">
@@ -476,6 +773,17 @@ document.getElementById("btnFinishSetup").onclick = function() {
 document.getElementById("btnStartTrack").onclick = () => send("start_track");
 document.getElementById("btnStopTrack").onclick = () => send("stop_track");
 
+document.getElementById("btnGoto").onclick = function() {
+  const az = parseFloat(document.getElementById("gotoAz").value);
+  const el = parseFloat(document.getElementById("gotoEl").value);
+  if (isNaN(az) || isNaN(el)) {
+    document.getElementById("gotoMsg").textContent = "Please enter valid az/el.";
+    return;
+  }
+  send("goto:" + az + "," + el);
+  document.getElementById("gotoMsg").textContent = "Moving...";
+};
+
 let statusInterval;
 ws.onopen = function() {
   send("get_status");
@@ -485,12 +793,18 @@ ws.onopen = function() {
 ws.onmessage = function(e) {
   try {
     const msg = JSON.parse(e.data);
+    if (msg.goto) {
+      const g = msg.goto;
+      const text = g.done != null ? (g.done ? "Arrived." : "Interrupted.") : (g.ok ? "Moving, ETA " + g.eta.toFixed(1) + " s" : "Go to rejected" + (g.error ? ": " + g.error : "") + ".");
+      document.getElementById("gotoMsg").textContent = text;
+    }
     if (msg.status) {
       const s = msg.status;
       document.getElementById("sunAz").textContent = (s.sunAz != null ? s.sunAz : 0).toFixed(2) + "°";
       document.getElementById("sunEl").textContent = (s.sunEl != null ? s.sunEl : 0).toFixed(2) + "°";
       document.getElementById("mirrorAz").textContent = (s.mirrorAz != null ? s.mirrorAz : 0).toFixed(2) + "°";
       document.getElementById("mirrorEl").textContent = (s.mirrorEl != null ? s.mirrorEl : 0).toFixed(2) + "°";
+      document.getElementById("timeToLock").textContent = s.locked ? s.timeToLock.toFixed(1) + " s" : (s.tracking ? "acquiring" : "-");
       document.getElementById("time").textContent = s.time || "-";
     }
   } catch (_) {}
@@ -511,10 +825,15 @@ void setup() {
   pinMode(DIR_Y, OUTPUT);
   pinMode(SLEEP_RESET_STEP_PIN, OUTPUT);
   digitalWrite(SLEEP_RESET_STEP_PIN, HIGH);
+  digitalWrite(DIR_X, LOW);
+  digitalWrite(DIR_Y, LOW);
+  stepper.setProfile(AXIS_AZ, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_AZ);
+  stepper.setProfile(AXIS_EL, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_EL);
 
   Serial.begin(115200);
   delay(2000);
   Serial.println("Heliostat starting...");
+  if (!stepDriver.begin(stepper, stepPins, dirPins)) Serial.println("Step driver init failed");
 
   WiFi.begin(ssid, password);
   while (WiFi.status() != WL_CONNECTED) {
@@ -552,10 +871,10 @@ void setup() {
 void loop() {
   server.handleClient();
   webSocket.loop();
-  updateSteppers();
 
-  if (trackingActive && (millis() - lastTrackUpdate >= TRACK_UPDATE_INTERVAL_MS)) {
+  if (trackingActive && (millis() - lastTrackUpdate >= tracker.updateInterval())) {
     lastTrackUpdate = millis();
     updateTracking();
   }
+  if (gotoPending || gotoActive) updateGoto();
 }
@@ -0,0 +1,211 @@
+//======================================================================================================================
+// backlash_sim
+//
+// Host simulation of backlash compensation against a gear-train model. Each axis is a motor driving the output through
+// a dead zone: the motor turns by every STEP edge the engine emits, takeup steps included, and the output only moves
+// when the motor pushes it from one flank or the other, so it always lies within the play behind the motor.
+//
+// A random sequence of moveTo jogs, coordinated lines and reversing timed segments (tracking going back and forth) is
+// run through the engine tick by tick, for several plays and every policy. The output must follow position() exactly
+// - its offset from it never changes, takeup or not - and under an approach policy every move that ends at rest must
+// end on the target with the gears loaded against the policy's flank. For comparison the same sequence runs without
+// compensation, where every reversal leaves the output up to the full play behind.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -o backlash_sim tools/backlash_sim.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./backlash_sim [moves]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "StepEngine.h"
+#include "MountConfig.h"
+
+#define MOVE_RANGE 4000    // steps either side of home
+#define TIMED_STEP 40      // largest move of one timed segment
+#define TIMED_MS 100
+#define MAX_TICKS (120 * (unsigned long)STEP_TICK_HZ)
+
+static const uint16_t plays[] = { 1, 12, 75 };  // microsteps; about 1 deg in azimuth for the last
+#define PLAY_COUNT (sizeof(plays) / sizeof(plays[0]))
+static const BacklashPolicy policies[] = { BACKLASH_TAKEUP, BACKLASH_APPROACH_FORWARD, BACKLASH_APPROACH_REVERSE };
+static const char* const policyNames[] = { "takeup", "forward", "reverse" };
+#define POLICY_COUNT (sizeof(policies) / sizeof(policies[0]))
+
+// Deterministic pseudo-random numbers, so a failure reproduces
+static uint32_t seed = 12345;
+
+static uint32_t random(uint32_t below)
+{
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) % below;
+}
+
+static long randomTarget()
+{
+  return (long)random(2 * MOVE_RANGE + 1) - MOVE_RANGE;
+}
+
+// Motor and output of one axis, in motor microsteps. Driving forward the output lags play behind the motor; driving
+// in reverse the motor pushes it from the other flank, level with it.
+struct GearTrain
+{
+  long motor;
+  long output;
+  long play;
+
+  void step(bool forward)
+  {
+    motor += forward ? 1 : -1;
+    if (output > motor) output = motor;
+    if (output < motor - play) output = motor - play;
+  }
+
+  bool loadedForward() const { return output == motor - play; }
+  bool loadedReverse() const { return output == motor; }
+};
+
+struct Result
+{
+  long maxError;       // largest change in output - position(), steps
+  unsigned long stops;  // moves ending at rest under an approach policy
+  unsigned long wrongFlank;
+  unsigned long offTarget;
+};
+
+class Sim
+{
+public:
+  Sim(uint16_t play, BacklashPolicy policy, bool compensate) : policy(policy)
+  {
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      engine.setProfile(i, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SCURVE);
+      if (compensate) engine.setBacklash(i, play, policy);
+      gears[i].motor = gears[i].output = 0;
+      gears[i].play = play;
+      offset[i] = 0;
+    }
+    // The engine does not know which flank the gears rest on until they have driven one way: load them forward
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      engine.moveTo(i, play + 10, STEP_START_RATE);
+    runToRest();
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      offset[i] = gears[i].output - engine.position(i);
+    result.maxError = 0;
+    result.stops = result.wrongFlank = result.offTarget = 0;
+  }
+
+  void moveTo(long az, long el)
+  {
+    engine.moveTo(AXIS_AZ, az, SLEW_RATE);
+    engine.moveTo(AXIS_EL, el, SLEW_RATE);
+    runToRest();
+    checkStop(az, el);
+  }
+
+  void line(long az, long el)
+  {
+    engine.queueLine(az, el);
+    runToRest();
+    checkStop(az, el);
+  }
+
+  // Tracking-like: short constant-rate segments that change direction now and then
+  void timed(unsigned segments)
+  {
+    long az = engine.position(AXIS_AZ), el = engine.position(AXIS_EL);
+    for (unsigned k = 0; k < segments; k++)
+    {
+      az += (long)random(2 * TIMED_STEP + 1) - TIMED_STEP;
+      el += (long)random(2 * TIMED_STEP + 1) - TIMED_STEP;
+      while (!engine.queueTimed(az, el, TIMED_MS * 1000UL))
+        tick();
+    }
+    runToRest();
+  }
+
+  const Result& results() const { return result; }
+
+private:
+  StepEngine engine;
+  BacklashPolicy policy;
+  GearTrain gears[AXIS_COUNT];
+  long offset[AXIS_COUNT];
+  Result result;
+
+  void tick()
+  {
+    uint8_t stepBits = engine.tick();
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      if (stepBits & (1 << i)) gears[i].step((engine.dirMask() & (1 << i)) != 0);
+      long error = labs(gears[i].output - engine.position(i) - offset[i]);
+      if (error > result.maxError) result.maxError = error;
+    }
+  }
+
+  void runToRest()
+  {
+    for (unsigned long t = 0; t < MAX_TICKS && (engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL)); t++)
+      tick();
+  }
+
+  void checkStop(long az, long el)
+  {
+    if (policy == BACKLASH_TAKEUP) return;
+    long target[AXIS_COUNT] = { az, el };
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      result.stops++;
+      if (engine.position(i) != target[i]) result.offTarget++;
+      bool flank = policy == BACKLASH_APPROACH_FORWARD ? gears[i].loadedForward() : gears[i].loadedReverse();
+      if (!flank) result.wrongFlank++;
+    }
+  }
+};
+
+static Result run(uint16_t play, BacklashPolicy policy, bool compensate, unsigned moves, uint32_t sequence)
+{
+  seed = sequence;
+  Sim sim(play, policy, compensate);
+  for (unsigned k = 0; k < moves; k++)
+  {
+    switch (random(3))
+    {
+    case 0:
+      sim.moveTo(randomTarget(), randomTarget());
+      break;
+    case 1:
+      sim.line(randomTarget(), randomTarget());
+      break;
+    default:
+      sim.timed(5 + random(20));
+      break;
+    }
+  }
+  return sim.results();
+}
+
+int main(int argc, char** argv)
+{
+  unsigned moves = argc > 1 ? atoi(argv[1]) : 200;
+
+  printf("%u random moves: moveTo jogs, lines and reversing timed segments\n", moves);
+  printf("                    compensated                               uncompensated\n");
+  printf("play  policy    max error steps  stops  wrong flank  off target   max error steps\n");
+  int failures = 0;
+  for (unsigned p = 0; p < PLAY_COUNT; p++)
+    for (unsigned k = 0; k < POLICY_COUNT; k++)
+    {
+      Result on = run(plays[p], policies[k], true, moves, 1000 + p);
+      Result off = run(plays[p], policies[k], false, moves, 1000 + p);
+      bool fail = on.maxError != 0 || on.wrongFlank != 0 || on.offTarget != 0;
+      printf("%4u  %-8s  %15ld  %5lu  %11lu  %10lu   %15ld%s\n", plays[p], policyNames[k], on.maxError, on.stops,
+             on.wrongFlank, on.offTarget, off.maxError, fail ? "  <- FAIL" : "");
+      if (fail) failures++;
+    }
+  if (failures) printf("FAIL: the output strayed from position() or a stop missed its flank\n");
+  else printf("PASS: the output follows position() exactly and every approach ends on its flank\n");
+  return failures ? 1 : 0;
+}
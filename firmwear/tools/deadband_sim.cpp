@@ -0,0 +1,191 @@
+//======================================================================================================================
+// deadband_sim
+//
+// Host simulation of step-mode tracking. Follows the sun through the daylight hours of one day a week for a year with
+// the firmware's SunTracker in step mode - a check every TRACK_UPDATE_INTERVAL_MS, a corrective move when an axis has
+// drifted out of its deadband - on the step engine, with the sun from a SunSource, and reports the moves (motor
+// wakeups) per hour against the pointing error of the reflected beam for several deadband budgets and for the legacy
+// fixed 2-microstep threshold. The engine only runs while a move is under way; at tracking rates that is
+// milliseconds. Where the sun's path runs past the end of the cable wrap, the seconds off the sun while the azimuth
+// unwinds are left out of the error, as in tracking_sim.
+//
+// Fails unless DEFAULT_DEADBAND_MRAD wakes the motors less often than the legacy threshold and keeps the beam within
+// DEADBAND_MAX_ERROR budgets: each axis may use the whole budget, so the beam can be off by up to 1.4 budgets, plus
+// what the sun moves between two checks.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -Ilib/SunPosition/src -Ilib/Tracking/src
+//       -I.pio/libdeps/esp32dev/SolarCalculator/src -o deadband_sim tools/deadband_sim.cpp
+//       $(ls lib/Motion/src/*.cpp | grep -v StepDriver) lib/SunPosition/src/*.cpp lib/Tracking/src/*.cpp
+//       .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./deadband_sim [lat] [lon] [year]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SunTracker.h"
+#include "MountConfig.h"
+#include <SolarCalculator.h>
+
+#define LEGACY_THRESHOLD_STEPS 2
+#define DEADBAND_MAX_ERROR 2.0  // beam error allowed with the default budget, in budgets
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const CableWrap cableWrap(angleFromDegrees(DEFAULT_WRAP_MIN_DEG), angleFromDegrees(DEFAULT_WRAP_MAX_DEG));
+
+struct Stats
+{
+  unsigned long moves;
+  double seconds;
+  double sumSquares;  // beam error, mrad
+  double maxError;
+  unsigned long samples;
+};
+
+static unsigned long simUtc;
+
+static unsigned long simClock()
+{
+  return simUtc;
+}
+
+// Angle between two directions, degrees
+static double separation(double az1, double el1, double az2, double el2)
+{
+  const double r = M_PI / 180;
+  double dEl = sin((el2 - el1) * r / 2), dAz = sin((az2 - az1) * r / 2);
+  double h = dEl * dEl + cos(el1 * r) * cos(el2 * r) * dAz * dAz;
+  return 2 * asin(sqrt(h > 1 ? 1 : h)) / r;
+}
+
+// The reflection turns twice as far as the mirror
+static void record(double az, double el, double sunAz, double sunEl, Stats& st)
+{
+  double error = 2 * separation(az, el, sunAz, sunEl) * M_PI / 180 * 1000;
+  if (error > st.maxError) st.maxError = error;
+  st.sumSquares += error * error;
+  st.samples++;
+}
+
+// SunTracker in step mode with a deadband of mrad, from `from` to `to`
+static void track(double lat, double lon, unsigned long from, unsigned long to, float mrad, Stats& st)
+{
+  StepEngine engine;
+  engine.setProfile(AXIS_AZ, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_AZ);
+  engine.setProfile(AXIS_EL, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_EL);
+  SunSource sun(Observer(lat, lon));
+  SunTracker tracker(engine, sun, simClock, gearAz, gearEl, cableWrap);
+  tracker.setVelocityMode(false);
+  tracker.setDeadband(mrad);
+  tracker.setNightParking(false);  // the refracted sun sets a little before `to`
+
+  double az, el;
+  calcHorizontalCoordinates(from, lat, lon, az, el);
+  engine.setPosition(AXIS_AZ, gearAz.degreesToSteps(angleToDegrees(cableWrap.nearest(0, angleFromDegrees(az)))));
+  engine.setPosition(AXIS_EL, gearEl.degreesToSteps(el));
+  tracker.start(0);
+  for (unsigned long t = from; t < to; t++)
+  {
+    unsigned long ms = (t - from) * 1000;
+    simUtc = t;
+    if (ms % tracker.updateInterval() == 0)
+    {
+      bool idle = !engine.isSegmentBusy();
+      tracker.update(ms);
+      if (idle && engine.isSegmentBusy()) st.moves++;
+    }
+    for (unsigned long k = 0; k < 1000000UL / STEP_TICK_US && engine.isSegmentBusy(); k++)
+      engine.tick();
+
+    if (!tracker.locked()) continue;
+    calcHorizontalCoordinates(t + 1, lat, lon, az, el);
+    record(gearAz.stepsToDegrees(engine.position(AXIS_AZ)), gearEl.stepsToDegrees(engine.position(AXIS_EL)), az, el,
+           st);
+  }
+  st.seconds += to - from;
+}
+
+// The legacy threshold: every axis more than LEGACY_THRESHOLD_STEPS off the sun moves onto it, moves instantaneous
+static void trackLegacy(double lat, double lon, unsigned long from, unsigned long to, Stats& st)
+{
+  double az, el;
+  calcHorizontalCoordinates(from, lat, lon, az, el);
+  long azPos = gearAz.degreesToSteps(az), elPos = gearEl.degreesToSteps(el);
+  double prevAz = az;
+
+  for (unsigned long t = from; t < to; t++)
+  {
+    calcHorizontalCoordinates(t, lat, lon, az, el);
+    az = prevAz + wrapTo180(az - prevAz);
+    prevAz = az;
+
+    if ((t - from) % (TRACK_UPDATE_INTERVAL_MS / 1000) == 0)
+    {
+      long diffAz = gearAz.degreesToSteps(az) - azPos, diffEl = gearEl.degreesToSteps(el) - elPos;
+      if (labs(diffAz) > LEGACY_THRESHOLD_STEPS || labs(diffEl) > LEGACY_THRESHOLD_STEPS)
+      {
+        if (labs(diffAz) > LEGACY_THRESHOLD_STEPS) azPos += diffAz;
+        if (labs(diffEl) > LEGACY_THRESHOLD_STEPS) elPos += diffEl;
+        st.moves++;
+      }
+    }
+    record(gearAz.stepsToDegrees(azPos), gearEl.stepsToDegrees(elPos), az, el, st);
+  }
+  st.seconds += to - from;
+}
+
+int main(int argc, char** argv)
+{
+  double lat = argc > 1 ? atof(argv[1]) : 48.21;
+  double lon = argc > 2 ? atof(argv[2]) : 16.37;
+  int year = argc > 3 ? atoi(argv[3]) : 2026;
+  const float budgets[] = { 0, 0.5f, 1, DEFAULT_DEADBAND_MRAD, 4, 8 };  // 0 for the legacy threshold
+
+  printf("lat %.2f lon %.2f, one day a week of %d, daylight only; errors of the reflected beam\n", lat, lon, year);
+  printf("deadband           moves/hour  rms err mrad  max err mrad\n");
+  double legacyMoves = 0, defaultMoves = 0, defaultError = 0;
+  for (unsigned r = 0; r < sizeof(budgets) / sizeof(budgets[0]); r++)
+  {
+    Stats st = { 0, 0, 0, 0, 0 };
+    for (int day = 0; day < 365; day += 7)
+    {
+      struct tm date = {};
+      date.tm_year = year - 1900;
+      date.tm_mday = 1 + day;
+      unsigned long midnight = (unsigned long)timegm(&date);
+      double transit, rise, set;
+      calcSunriseSunset(midnight, lat, lon, transit, rise, set);
+      if (isnan(rise) || isnan(set)) continue;
+      unsigned long from = midnight + (unsigned long)(rise * 3600) + 60;
+      unsigned long to = midnight + (unsigned long)(set * 3600) - 60;
+      if (budgets[r] == 0) trackLegacy(lat, lon, from, to, st);
+      else track(lat, lon, from, to, budgets[r], st);
+    }
+    double moves = st.moves * 3600.0 / st.seconds;
+    char name[24];
+    if (budgets[r] == 0) snprintf(name, sizeof(name), "%d microsteps", LEGACY_THRESHOLD_STEPS);
+    else
+      snprintf(name, sizeof(name), "%.1f mrad%s", budgets[r],
+               budgets[r] == DEFAULT_DEADBAND_MRAD ? ", default" : "");
+    printf("%-17s  %10.1f  %12.3f  %12.3f\n", name, moves, sqrt(st.sumSquares / st.samples), st.maxError);
+    if (budgets[r] == 0) legacyMoves = moves;
+    if (budgets[r] == DEFAULT_DEADBAND_MRAD)
+    {
+      defaultMoves = moves;
+      defaultError = st.maxError;
+    }
+  }
+
+  bool fail = defaultMoves >= legacyMoves || defaultError > DEADBAND_MAX_ERROR * DEFAULT_DEADBAND_MRAD;
+  if (fail)
+    printf("FAIL: %.1f mrad moves more often than %d microsteps, or lets the beam stray more than %.1f mrad\n",
+           DEFAULT_DEADBAND_MRAD, LEGACY_THRESHOLD_STEPS, DEADBAND_MAX_ERROR * DEFAULT_DEADBAND_MRAD);
+  else
+    printf("PASS: %.1f mrad moves %.1fx less often than %d microsteps, with the beam within %.1f mrad\n",
+           DEFAULT_DEADBAND_MRAD, legacyMoves / defaultMoves, LEGACY_THRESHOLD_STEPS,
+           DEADBAND_MAX_ERROR * DEFAULT_DEADBAND_MRAD);
+  return fail ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+//======================================================================================================================
+// gear_drift_check
+//
+// Host property tests of GearRatio over millions of steps:
+//  - every step count converts to the exactly rounded microdegree (checked against 128-bit arithmetic), step -> angle
+//    -> step is the identity, and angles increase with steps, over +-STEP_RANGE microsteps and at random counts up
+//    to the limits of long, for the default ratios and ones with large terms
+//  - following back-and-forth targets step by step for millions of steps, the position always lands exactly on
+//    the target's microstep and reads back within half a microstep of it: no drift, however long it runs. The
+//    original arithmetic (a float microsteps per degree, angles kept by adding float increments per step, targets
+//    truncated) is run alongside for comparison
+//  - a float calibration from older firmware converts back to the fraction it was made from: always for the old
+//    defaults; for other drives whenever the float can tell the fraction from a simpler one, and never further from it
+//    than the float itself was
+//  - a zero numerator or denominator does not make a ratio that divides by zero
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -o gear_drift_check tools/gear_drift_check.cpp lib/Motion/src/GearRatio.cpp
+//   ./gear_drift_check [steps followed, millions]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <float.h>
+#include "GearRatio.h"
+#include "MountConfig.h"
+
+#define STEP_RANGE 3000000L
+#define RANDOM_COUNTS 2000000
+#define SWEEP_DEG 270  // back and forth across the cable wrap
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+
+struct Ratio
+{
+  const char* name;
+  GearRatio gear;
+};
+
+static const Ratio ratios[] = {
+  { "az 17:144", gearAz },
+  { "el 21:64", gearEl },
+  { "0.9 deg, 1/64 step, 13:100", GearRatio::fromTeeth(25600, 100, 13) },
+  { "large terms", GearRatio(4294967291u, 57042133u) },
+  { "coarse", GearRatio(7, 12) },
+};
+#define RATIO_COUNT (sizeof(ratios) / sizeof(ratios[0]))
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, const char* name)
+{
+  printf("%-64s %-28s %s\n", what, name, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+// Deterministic pseudo-random numbers, so a failure reproduces
+static uint64_t seed = 12345;
+
+static uint64_t random64()
+{
+  seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+  return seed;
+}
+
+// Reference: steps * den * ANGLE_PER_DEG / num, rounded half away from zero, in 128 bits
+static int64_t exactAngle(const GearRatio& g, long steps)
+{
+  __int128 p = (__int128)steps * g.den() * ANGLE_PER_DEG;
+  __int128 n = g.num();
+  __int128 q = p >= 0 ? (p + n / 2) / n : -((-p + n / 2) / n);
+  return (int64_t)q;
+}
+
+static void testConversions(const Ratio& r)
+{
+  const GearRatio& g = r.gear;
+  bool exact = true, monotonic = true, roundTrip = true;
+  // Finer than a microdegree per step, every step has its own angle to come back from
+  bool distinct = (double)g.num() / g.den() < ANGLE_PER_DEG;
+  int64_t last = g.toAngle(-STEP_RANGE - 1);
+  for (long s = -STEP_RANGE; s <= STEP_RANGE; s++)
+  {
+    int64_t a = g.toAngle(s);
+    if (a != exactAngle(g, s)) exact = false;
+    if (a <= last) monotonic = false;
+    last = a;
+    if (distinct && a >= -(int64_t)(ANGLE_MAX_DEG * ANGLE_PER_DEG) && a <= (int64_t)(ANGLE_MAX_DEG * ANGLE_PER_DEG) &&
+        g.toSteps((Angle)a) != s)
+      roundTrip = false;
+  }
+  check(exact, "toAngle() exactly rounded over +-3M microsteps", r.name);
+  check(monotonic, "angles increase with steps", r.name);
+  check(roundTrip, "step -> angle -> step is the identity", r.name);
+
+  // Up to what long holds on the ESP32, where the intermediate product would not fit 64 bits
+  bool wide = true;
+  for (int k = 0; k < RANDOM_COUNTS; k++)
+  {
+    long s = (long)(int32_t)random64();
+    if (g.toAngle(s) != exactAngle(g, s)) wide = false;
+  }
+  check(wide, "toAngle() exact at random counts across 32 bits", r.name);
+}
+
+struct Drift
+{
+  unsigned long steps;
+  long maxMissed;      // target microstep minus where the position ended, in microsteps
+  double maxReadBack;  // |angle of the position - target|, microsteps
+};
+
+// Half a microstep, plus the microdegree the angle is rounded to
+static double readBackLimit(const GearRatio& g)
+{
+  return 0.5 + (double)g.num() / g.den() / ANGLE_PER_DEG;
+}
+
+// Step by step towards back-and-forth targets, as tracking and slews do
+static Drift follow(const GearRatio& g, unsigned long totalSteps, bool legacy)
+{
+  Drift d = { 0, 0, 0 };
+  float spd = (float)g.num() / g.den();  // the original float microsteps per degree
+  long pos = 0;
+  float posDeg = 0;  // the original kept the angle by adding float increments per step
+  Angle target = 0;
+  int sweep = 1;
+  while (d.steps < totalSteps)
+  {
+    // The next target: a few degrees on, turning round at the ends of the sweep
+    target += sweep * (Angle)(1 + random64() % (3 * ANGLE_PER_DEG));
+    if (target > SWEEP_DEG * ANGLE_PER_DEG || target < -SWEEP_DEG * ANGLE_PER_DEG) sweep = -sweep;
+    long want = legacy ? pos + (long)((angleToDegrees(target) - posDeg) * spd) : g.toSteps(target);
+    while (pos != want)
+    {
+      int dir = want > pos ? 1 : -1;
+      pos += dir;
+      posDeg += dir / spd;
+      d.steps++;
+    }
+    long missed = labs(g.toSteps(target) - pos);
+    if (missed > d.maxMissed) d.maxMissed = missed;
+    double back = legacy ? posDeg : g.stepsToDegrees(pos);
+    double readBack = fabs(back - angleToDegrees(target)) * g.num() / g.den();
+    if (readBack > d.maxReadBack) d.maxReadBack = readBack;
+  }
+  return d;
+}
+
+static void testDrift(unsigned long totalSteps)
+{
+  printf("\nfollowing back-and-forth targets over +-%d deg\n", SWEEP_DEG);
+  printf("ratio                          steps      exact: missed  read back   original: missed  read back\n");
+  for (unsigned k = 0; k < 2; k++)
+  {
+    seed = 777;
+    Drift exact = follow(ratios[k].gear, totalSteps, false);
+    seed = 777;
+    Drift old = follow(ratios[k].gear, totalSteps, true);
+    bool fail = exact.maxMissed != 0 || exact.maxReadBack > readBackLimit(ratios[k].gear);
+    printf("%-26s  %10lu  %15ld  %9.3f  %17ld  %9.3f%s\n", ratios[k].name, exact.steps, exact.maxMissed,
+           exact.maxReadBack, old.maxMissed, old.maxReadBack, fail ? "  <- FAIL" : "");
+    if (fail) failures++;
+  }
+}
+
+static void testMigration()
+{
+  // What older firmware stored: its defaults, as floats
+  float calAz = (float)(3200.0 * 144.0 / 17.0 / 360.0), calEl = (float)(3200.0 * 64.0 / 21.0 / 360.0);
+  GearRatio az = GearRatio::fromStepsPerDegree(calAz), el = GearRatio::fromStepsPerDegree(calEl);
+  check(az.num() == gearAz.num() && az.den() == gearAz.den() && el.num() == gearEl.num() && el.den() == gearEl.den(),
+        "calAz/calEl defaults migrate to 1280/17 and 5120/189", "");
+
+  // Drives built from these parts, stored as a float. A float holds 24 bits: past that, a fraction with a large
+  // denominator and a simpler one nearby store the same, and the simpler one is what comes back.
+  static const uint32_t motors[] = { 400, 800, 1600, 3200, 6400, 12800, 25600 };
+  unsigned tried = 0, recovered = 0;
+  double worst = 0;
+  for (unsigned m = 0; m < sizeof(motors) / sizeof(motors[0]); m++)
+    for (uint32_t out = 10; out <= 200; out++)
+      for (uint32_t in = 8; in <= 40; in++)
+      {
+        GearRatio g = GearRatio::fromTeeth(motors[m], out, in);
+        GearRatio back = GearRatio::fromStepsPerDegree((float)g.num() / g.den());
+        tried++;
+        if (back.num() == g.num() && back.den() == g.den()) recovered++;
+        double off = fabs((double)back.num() / back.den() * g.den() / g.num() - 1);
+        if (off > worst) worst = off;
+      }
+  printf("  %u of %u tooth combinations recovered exactly, the rest within %.2g relative\n", recovered, tried, worst);
+  // The float's own rounding plus the tolerance fromStepsPerDegree() accepts
+  check(worst <= FLT_EPSILON / 2 + 1.2e-7, "every migrated ratio within the float calibration's precision", "");
+
+  GearRatio zeroNum(0, 5), zeroDen(5, 0);
+  check(zeroNum.num() > 0 && zeroDen.den() > 0 && zeroNum.toSteps(ANGLE_PER_DEG) >= 0 && zeroDen.toAngle(10) >= 0,
+        "a zero numerator or denominator does not divide by zero", "");
+}
+
+int main(int argc, char** argv)
+{
+  unsigned long totalSteps = (argc > 1 ? atol(argv[1]) : 20) * 1000000UL;
+
+  for (unsigned k = 0; k < RATIO_COUNT; k++)
+    testConversions(ratios[k]);
+  testMigration();
+  testDrift(totalSteps);
+
+  if (failures) printf("FAIL: %d gear ratio properties do not hold\n", failures);
+  else printf("PASS: exact conversions, no drift over %lu steps\n", totalSteps);
+  return failures ? 1 : 0;
+}
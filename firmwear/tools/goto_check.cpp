@@ -0,0 +1,201 @@
+//======================================================================================================================
+// goto_check
+//
+// Host test of the goto command's planning and benchmark of its cost. Runs random gotos - bearing and elevation in
+// degrees, from wherever the previous one ended - the way updateGoto() plans them: the bearing resolved on the cable
+// wrap from the current position, the ETA from lineTime(), the move as one coordinated line. Each is run through the
+// step engine and checked:
+//  - it arrives on exactly the microsteps the gear ratios give for the target
+//  - the move takes the ETA reported to the client, to within GOTO_ETA_TOLERANCE
+//  - it is time-optimal: no slower than the axis with the furthest to go would take on its own
+// on the main.cpp settings, without backlash, with takeup and with an approach policy (the ETA covers the takeup
+// and the overshoot).
+//
+// The benchmark times the planning updateGoto() does before the move starts, in microseconds per goto on the host.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -o goto_check tools/goto_check.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./goto_check [gotos]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "StepEngine.h"
+#include "GearRatio.h"
+#include "CableWrap.h"
+#include "MountConfig.h"
+
+#define GOTO_ETA_TOLERANCE 0.02     // relative
+#define GOTO_ETA_SLACK_S 0.01
+#define GOTO_OPTIMAL_TOLERANCE 0.01  // relative, over the slower axis on its own
+#define TIMED_GOTOS 200000
+#define MAX_TICKS (600 * (unsigned long)STEP_TICK_HZ)
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const CableWrap cableWrap(angleFromDegrees(DEFAULT_WRAP_MIN_DEG), angleFromDegrees(DEFAULT_WRAP_MAX_DEG));
+
+// Deterministic pseudo-random numbers, so a failure reproduces
+static uint32_t seed = 12345;
+
+static uint32_t random(uint32_t below)
+{
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) % below;
+}
+
+// Degrees in [lo, hi], to a hundredth as the web page sends them
+static float randomDegrees(float lo, float hi)
+{
+  return lo + random((uint32_t)((hi - lo) * 100) + 1) / 100.0f;
+}
+
+static void setProfiles(StepEngine& engine)
+{
+  engine.setProfile(AXIS_AZ, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_AZ);
+  engine.setProfile(AXIS_EL, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_EL);
+}
+
+// mechanicalAz() from main.cpp
+static double mechanicalAz(double bearing, long fromSteps)
+{
+  Angle current = angleSaturate(gearAz.toAngle(fromSteps));
+  return angleToDegrees(cableWrap.nearest(current, angleFromDegrees(bearing)));
+}
+
+static unsigned long runToRest(StepEngine& engine)
+{
+  unsigned long t = 0;
+  while ((engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL)) && t < MAX_TICKS)
+  {
+    engine.tick();
+    t++;
+  }
+  return t;
+}
+
+// Time for one axis to cover the distance on its own, from rest to rest
+static double alone(uint8_t axis, long from, long to)
+{
+  StepEngine engine;
+  setProfiles(engine);
+  engine.setPosition(axis, from);
+  engine.moveTo(axis, to, SLEW_RATE);
+  return runToRest(engine) / (double)STEP_TICK_HZ;
+}
+
+struct Result
+{
+  unsigned gotos;
+  unsigned missed;      // did not end on the target
+  unsigned late;        // outside the ETA tolerance
+  unsigned slow;        // slower than the slower axis alone
+  double maxEtaError;   // s
+  double maxOverOptimal;  // relative
+};
+
+static Result check(unsigned gotos, uint16_t backlash, BacklashPolicy policy)
+{
+  Result r = {};
+  StepEngine engine;
+  setProfiles(engine);
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    engine.setBacklash(i, backlash, policy);
+  for (unsigned k = 0; k < gotos; k++)
+  {
+    float az = randomDegrees(0, 359.99f), el = randomDegrees(EL_MIN_DEG, EL_MAX_DEG);
+    long fromAz = engine.position(AXIS_AZ), fromEl = engine.position(AXIS_EL);
+    long azSteps = gearAz.degreesToSteps(mechanicalAz(az, fromAz)), elSteps = gearEl.degreesToSteps(el);
+    float eta = engine.lineTime(azSteps, elSteps);
+    if (!engine.queueLine(azSteps, elSteps)) continue;
+    double seconds = runToRest(engine) / (double)STEP_TICK_HZ;
+    r.gotos++;
+
+    if (engine.position(AXIS_AZ) != azSteps || engine.position(AXIS_EL) != elSteps) r.missed++;
+    double etaError = fabs(seconds - eta);
+    if (etaError > r.maxEtaError) r.maxEtaError = etaError;
+    if (etaError > seconds * GOTO_ETA_TOLERANCE + GOTO_ETA_SLACK_S) r.late++;
+    // The approach overshoot is extra distance by design; optimality is checked without it
+    if (policy == BACKLASH_TAKEUP && backlash == 0)
+    {
+      double a = alone(AXIS_AZ, fromAz, azSteps), e = alone(AXIS_EL, fromEl, elSteps);
+      double best = a > e ? a : e;
+      double over = best > 0 ? seconds / best - 1 : 0;
+      if (over > r.maxOverOptimal) r.maxOverOptimal = over;
+      if (over > GOTO_OPTIMAL_TOLERANCE) r.slow++;
+    }
+  }
+  return r;
+}
+
+static double now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Microseconds of planning per goto: resolving the bearing, the ETA and queueing the line
+static double planningCost()
+{
+  StepEngine engine;
+  setProfiles(engine);
+  double spent = 0;
+  unsigned long planned = 0;
+  for (unsigned k = 0; k < TIMED_GOTOS; k++)
+  {
+    float az = randomDegrees(0, 359.99f), el = randomDegrees(EL_MIN_DEG, EL_MAX_DEG);
+    engine.setPosition(AXIS_AZ, gearAz.degreesToSteps(randomDegrees(DEFAULT_WRAP_MIN_DEG, DEFAULT_WRAP_MAX_DEG)));
+    double start = now();
+    long azSteps = gearAz.degreesToSteps(mechanicalAz(az, engine.position(AXIS_AZ)));
+    long elSteps = gearEl.degreesToSteps(el);
+    volatile float eta = engine.lineTime(azSteps, elSteps);
+    (void)eta;
+    bool queued = engine.queueLine(azSteps, elSteps);
+    spent += now() - start;
+    if (queued) planned++;
+    engine.stop(AXIS_AZ);
+    engine.tick();
+  }
+  return spent / planned * 1e6;
+}
+
+int main(int argc, char** argv)
+{
+  unsigned gotos = argc > 1 ? atoi(argv[1]) : 300;
+
+  struct Case
+  {
+    const char* name;
+    uint16_t backlash;
+    BacklashPolicy policy;
+  };
+  static const Case cases[] = {
+    { "no backlash", 0, BACKLASH_TAKEUP },
+    { "takeup 20", 20, BACKLASH_TAKEUP },
+    { "approach fwd 20", 20, BACKLASH_APPROACH_FORWARD },
+  };
+
+  printf("%u random gotos from where the last one ended\n", gotos);
+  printf("backlash          gotos  missed  eta off  max eta err s  slower than optimal  max over optimal\n");
+  int failures = 0;
+  for (unsigned k = 0; k < sizeof(cases) / sizeof(cases[0]); k++)
+  {
+    seed = 12345;
+    Result r = check(gotos, cases[k].backlash, cases[k].policy);
+    bool fail = r.gotos != gotos || r.missed || r.late || r.slow;
+    char optimal[48] = "                    -                -";
+    if (cases[k].backlash == 0) snprintf(optimal, sizeof(optimal), "%19u  %15.2f%%", r.slow, r.maxOverOptimal * 100);
+    printf("%-15s  %6u  %6u  %7u  %13.3f  %s%s\n", cases[k].name, r.gotos, r.missed, r.late, r.maxEtaError, optimal,
+           fail ? "  <- FAIL" : "");
+    if (fail) failures++;
+  }
+
+  printf("\nplanning a goto on the host: %.2f us\n", planningCost());
+
+  if (failures) printf("FAIL: a goto missed its target, its ETA, or was slower than the slower axis alone\n");
+  else printf("PASS: every goto on target, within its ETA and as fast as the slower axis alone\n");
+  return failures ? 1 : 0;
+}
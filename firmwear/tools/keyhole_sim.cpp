@@ -0,0 +1,146 @@
+//======================================================================================================================
+// keyhole_sim
+//
+// Host simulation of tracking through near-zenith passes. For each latitude it follows the sun through every solar
+// noon of a year with the firmware's SunTracker and a SunSource, on a simulated clock - sun updates extrapolated at
+// the sun's rate, at least once a minute while the sun is high, and the KeyholePass ramp through a pass - and
+// compares the azimuth rate tracking asks for and the pointing error of the resulting microstep targets with the
+// keyhole handling and without it (setKeyholeRate(0)). The axes are put on the target every second instead of
+// simulated (step mode, so nothing is queued).
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -Ilib/SunPosition/src -Ilib/Tracking/src
+//       -I.pio/libdeps/esp32dev/SolarCalculator/src -o keyhole_sim tools/keyhole_sim.cpp
+//       $(ls lib/Motion/src/*.cpp | grep -v StepDriver) lib/SunPosition/src/*.cpp lib/Tracking/src/*.cpp
+//       .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./keyhole_sim [maxAzRate] [year]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SunTracker.h"
+#include "MountConfig.h"
+#include <SolarCalculator.h>
+
+#define TRACK_SEGMENT_S 1
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const CableWrap cableWrap(angleFromDegrees(DEFAULT_WRAP_MIN_DEG), angleFromDegrees(DEFAULT_WRAP_MAX_DEG));
+
+struct Result
+{
+  double peakSunRate;   // deg/s, largest sun azimuth rate at a segment
+  double peakAxisRate;  // deg/s, largest azimuth rate of a tracking segment
+  double maxError;      // deg, largest angle between the sun and the microstep position tracking commands
+  double passError;     // deg, largest maxError() a pass reported
+  bool pass;
+};
+
+static unsigned long simUtc;
+
+static unsigned long simClock()
+{
+  return simUtc;
+}
+
+// Angle between two directions, degrees
+static double separation(double az1, double el1, double az2, double el2)
+{
+  const double r = M_PI / 180;
+  double dEl = sin((el2 - el1) * r / 2), dAz = sin((az2 - az1) * r / 2);
+  double h = dEl * dEl + cos(el1 * r) * cos(el2 * r) * dAz * dAz;
+  return 2 * asin(sqrt(h > 1 ? 1 : h)) / r;
+}
+
+// Track from an hour before to an hour after transit, one tracking segment per second
+static Result simulate(double lat, unsigned long transit, float maxRate)
+{
+  Result res = { 0, 0, 0, 0, false };
+  unsigned long from = transit - 3600;
+  StepEngine engine;
+  SunSource sun(Observer(lat, 0.0));
+  SunTracker tracker(engine, sun, simClock, gearAz, gearEl, cableWrap);
+  tracker.setVelocityMode(false);
+  tracker.setKeyholeRate(maxRate);
+
+  double sunAz, sunEl, prevCommand = 0, prevSun = 0;
+  calcHorizontalCoordinates(from, lat, 0.0, sunAz, sunEl);
+  engine.setPosition(AXIS_AZ, gearAz.degreesToSteps(angleToDegrees(cableWrap.nearest(0, angleFromDegrees(sunAz)))));
+  engine.setPosition(AXIS_EL, gearEl.degreesToSteps(sunEl));
+  tracker.start(0);
+  for (unsigned long t = from; t <= transit + 3600; t += TRACK_SEGMENT_S)
+  {
+    unsigned long ms = (t - from) * 1000;
+    simUtc = t;
+    if (t > from)
+    {
+      engine.setPosition(AXIS_AZ, tracker.targetAzSteps(ms));
+      engine.setPosition(AXIS_EL, tracker.targetElSteps(ms));
+    }
+    tracker.update(ms);
+    const KeyholePass& pass = tracker.keyhole();
+    if (pass.planned())
+    {
+      res.pass = true;
+      if (pass.maxError() > res.passError) res.passError = pass.maxError();
+    }
+
+    // Segment end position, as trackVelocity() queues it
+    double command = gearAz.stepsToDegrees(tracker.targetAzSteps(ms));
+    double elevation = gearEl.stepsToDegrees(tracker.targetElSteps(ms));
+    calcHorizontalCoordinates(t, lat, 0.0, sunAz, sunEl);
+    if (t > from)
+    {
+      double axisRate = fabs(wrapTo180(command - prevCommand)) / TRACK_SEGMENT_S;  // an unwind is not a rate
+      double sunRate = fabs(wrapTo180(sunAz - prevSun)) / TRACK_SEGMENT_S;
+      if (axisRate > res.peakAxisRate) res.peakAxisRate = axisRate;
+      if (sunRate > res.peakSunRate) res.peakSunRate = sunRate;
+    }
+    double error = separation(command, elevation, sunAz, sunEl);
+    if (error > res.maxError) res.maxError = error;
+    prevCommand = command;
+    prevSun = sunAz;
+  }
+  return res;
+}
+
+int main(int argc, char** argv)
+{
+  float maxRate = argc > 1 ? atof(argv[1]) : 2.0f;
+  int year = argc > 2 ? atoi(argv[2]) : 2026;
+
+  printf("max azimuth rate %.2f deg/s, %d\n", maxRate, year);
+  printf("lat  passes  sun peak   without keyhole          with keyhole             pass error\n");
+  printf("               deg/s    axis deg/s  error deg    axis deg/s  error deg    deg\n");
+  for (int lat = 0; lat <= 25; lat += 5)
+  {
+    Result off = { 0, 0, 0, 0, false }, on = off;
+    int passes = 0;
+    for (int day = 0; day < 365; day++)
+    {
+      struct tm date = {};
+      date.tm_year = year - 1900;
+      date.tm_mday = 1 + day;
+      time_t midnight = timegm(&date);
+      double transit, rise, set;
+      calcSunriseSunset(JulianDay((unsigned long)midnight), lat, 0.0, transit, rise, set);
+      unsigned long noon = (unsigned long)midnight + (unsigned long)(transit * 3600);
+
+      Result a = simulate(lat, noon, 0);
+      Result b = simulate(lat, noon, maxRate);
+      if (b.pass) passes++;
+      if (a.peakSunRate > off.peakSunRate) off.peakSunRate = a.peakSunRate;
+      if (a.peakAxisRate > off.peakAxisRate) off.peakAxisRate = a.peakAxisRate;
+      if (a.maxError > off.maxError) off.maxError = a.maxError;
+      if (b.peakAxisRate > on.peakAxisRate) on.peakAxisRate = b.peakAxisRate;
+      if (b.maxError > on.maxError) on.maxError = b.maxError;
+      if (b.passError > on.passError) on.passError = b.passError;
+    }
+    printf("%3d  %6d  %8.2f   %10.2f  %9.4f    %10.2f  %9.4f    %.4f\n", lat, passes, off.peakSunRate,
+           off.peakAxisRate, off.maxError, on.peakAxisRate, on.maxError, on.passError);
+  }
+  return 0;
+}
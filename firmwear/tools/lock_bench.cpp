@@ -0,0 +1,153 @@
+//======================================================================================================================
+// lock_bench
+//
+// Host benchmark of acquisition. Starts tracking with the mirror some way off the sun - at home after reset_setup,
+// stowed, turned away, just past and just inside ACQUIRE_THRESHOLD_DEG - and runs the firmware's SunTracker through
+// the step engine, on a simulated clock with the sun from a SunSource, until it declares lock. Reports
+// timeToLock() as the status shows it (updated once per loop interval, so to the second) and how long the original
+// tracker (one microstep per axis every 5 s) would take to get within LOCK_THRESHOLD_STEPS; it cannot catch up at
+// all while the sun outruns it.
+//
+// Fails if any start takes longer than LOCK_TIME_LIMIT_S to lock, or does not end within the lock threshold.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -Ilib/SunPosition/src -Ilib/Tracking/src
+//       -I.pio/libdeps/esp32dev/SolarCalculator/src -o lock_bench tools/lock_bench.cpp
+//       $(ls lib/Motion/src/*.cpp | grep -v StepDriver) lib/SunPosition/src/*.cpp lib/Tracking/src/*.cpp
+//       .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./lock_bench [lat] [lon] [unix time]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "SunTracker.h"
+#include "MountConfig.h"
+#include <SolarCalculator.h>
+
+#define LEGACY_STEP_INTERVAL_S 5
+#define LEGACY_SUN_UPDATE_S 60
+
+#define LOCK_TIME_LIMIT_S 30
+#define LEGACY_LIMIT_S (12 * 3600UL)
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const CableWrap cableWrap(angleFromDegrees(DEFAULT_WRAP_MIN_DEG), angleFromDegrees(DEFAULT_WRAP_MAX_DEG));
+
+struct Start
+{
+  const char* name;
+  bool absolute;  // az/el are where the mirror is, otherwise how far off the sun
+  double az;
+  double el;
+};
+
+static const Start starts[] = {
+  { "home (reset_setup)", true, 0, 0 },
+  { "stowed", true, 0, 90 },
+  { "turned away", false, 180, 0 },
+  { "10 deg off", false, 10, -10 },
+  { "1.5 deg off", false, 1.5, 1.5 },
+  { "0.5 deg off", false, 0.5, -0.5 },
+  { "on the sun", false, 0, 0 },
+};
+#define START_COUNT (sizeof(starts) / sizeof(starts[0]))
+
+struct Lock
+{
+  double seconds;  // timeToLockMs as reported, -1 if not locked
+  long azErr;      // steps off the sun at lock
+  long elErr;
+};
+
+static unsigned long simUtc;
+
+static unsigned long simClock()
+{
+  return simUtc;
+}
+
+// SunTracker from start() until lock, on a simulated clock
+static Lock acquire(double lat, double lon, unsigned long utc, long azSteps, long elSteps)
+{
+  StepEngine engine;
+  engine.setProfile(AXIS_AZ, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_AZ);
+  engine.setProfile(AXIS_EL, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_EL);
+  engine.setPosition(AXIS_AZ, azSteps);
+  engine.setPosition(AXIS_EL, elSteps);
+  SunSource sun(Observer(lat, lon));
+  SunTracker tracker(engine, sun, simClock, gearAz, gearEl, cableWrap);
+  tracker.start(0);
+
+  Lock res = { -1, 0, 0 };
+  for (unsigned long ms = 0; ms < 10 * 60 * 1000UL; ms += tracker.updateInterval())
+  {
+    simUtc = utc + ms / 1000;
+    tracker.update(ms);
+    if (tracker.locked())
+    {
+      // Against the exact sun, on the turn the axis is on
+      double az, el;
+      calcHorizontalCoordinates(simUtc, lat, lon, az, el);
+      double current = gearAz.stepsToDegrees(engine.position(AXIS_AZ));
+      res.seconds = tracker.timeToLock() / 1000.0;
+      res.azErr = gearAz.degreesToSteps(current + wrapTo180(az - current)) - engine.position(AXIS_AZ);
+      res.elErr = gearEl.degreesToSteps(el) - engine.position(AXIS_EL);
+      break;
+    }
+    for (unsigned long t = 0; t < tracker.updateInterval() * 1000UL / STEP_TICK_US; t++)
+      engine.tick();
+  }
+  return res;
+}
+
+// The original tracker from the same start: seconds until both axes are within the lock threshold, or 0 if not
+// within LEGACY_LIMIT_S
+static unsigned long legacyLock(double lat, double lon, unsigned long utc, long azPos, long elPos)
+{
+  double az, el;
+  for (unsigned long t = 0; t < LEGACY_LIMIT_S; t += LEGACY_STEP_INTERVAL_S)
+  {
+    calcHorizontalCoordinates(utc + t - t % LEGACY_SUN_UPDATE_S, lat, lon, az, el);
+    long diffAz = (long)(az * gearAz.stepsPerDegree()) - azPos;
+    long diffEl = (long)(el * gearEl.stepsPerDegree()) - elPos;
+    if (labs(diffAz) <= LOCK_THRESHOLD_STEPS && labs(diffEl) <= LOCK_THRESHOLD_STEPS) return t > 0 ? t : 1;
+    if (labs(diffAz) > 2) azPos += diffAz > 0 ? 1 : -1;
+    if (labs(diffEl) > 2) elPos += diffEl > 0 ? 1 : -1;
+  }
+  return 0;
+}
+
+int main(int argc, char** argv)
+{
+  double lat = argc > 1 ? atof(argv[1]) : 48.21;
+  double lon = argc > 2 ? atof(argv[2]) : 16.37;
+  unsigned long utc = argc > 3 ? strtoul(argv[3], NULL, 10) : 1774000800UL;  // 2026-03-20 10:00 UTC
+
+  double sunAz, sunEl;
+  calcHorizontalCoordinates(utc, lat, lon, sunAz, sunEl);
+  printf("lat %.2f lon %.2f, sun at az %.2f el %.2f\n", lat, lon, sunAz, sunEl);
+  printf("start                  off az deg  off el deg   time to lock s  az/el steps off   original tracker\n");
+  int failures = 0;
+  for (unsigned k = 0; k < START_COUNT; k++)
+  {
+    const Start& s = starts[k];
+    double az = s.absolute ? s.az : sunAz + s.az, el = s.absolute ? s.el : sunEl + s.el;
+    long azSteps = gearAz.degreesToSteps(az), elSteps = gearEl.degreesToSteps(el);
+
+    Lock lock = acquire(lat, lon, utc, azSteps, elSteps);
+    unsigned long old = legacyLock(lat, lon, utc, azSteps, elSteps);
+    bool fail = lock.seconds < 0 || lock.seconds > LOCK_TIME_LIMIT_S || labs(lock.azErr) > LOCK_THRESHOLD_STEPS ||
+                labs(lock.elErr) > LOCK_THRESHOLD_STEPS;
+    char oldText[32];
+    if (old) snprintf(oldText, sizeof(oldText), "%.0f min", old / 60.0);
+    else snprintf(oldText, sizeof(oldText), "not in %lu h", LEGACY_LIMIT_S / 3600);
+    printf("%-20s  %10.2f  %10.2f  %15.1f  %7ld %7ld   %16s%s\n", s.name, wrapTo180(az - sunAz), el - sunEl,
+           lock.seconds, lock.azErr, lock.elErr, oldText, fail ? "  <- FAIL" : "");
+    if (fail) failures++;
+  }
+  if (failures) printf("FAIL: a start did not lock within %d s\n", LOCK_TIME_LIMIT_S);
+  else printf("PASS: every start locked within %d s\n", LOCK_TIME_LIMIT_S);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+//======================================================================================================================
+// mount_sim
+//
+// Host benchmark of slew profiles against the physical mount model. Runs the step engine through a coordinated slew
+// out and back for a grid of accelerations and top speeds, plays the STEP/DIR edges it emits (recorded by the host
+// PinGroup, as the timer backend would write them) into MountModel, and reports the slew time against missed steps
+// (net at the end, and the most at any point: a stall out and back can lose the same each way and end on target),
+// the peak load angle of each motor (above 1 the motor is past its peak torque, at 2 it slips) and where the mirror
+// ends up. The profile main.cpp uses is marked.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -o mount_sim tools/mount_sim.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./mount_sim [scurve|trapezoid] [az deg] [el deg]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "StepEngine.h"
+#include "PinGroup.h"
+#include "MountModel.h"
+#include "MountConfig.h"
+
+// The 30x21 cm mirror on its frame, spur drives with a little play
+#define LOAD_INERTIA_AZ 0.012f  // kg m^2
+#define LOAD_INERTIA_EL 0.005f
+#define BACKLASH_DEG    0.1f
+#define FRICTION_AZ     0.3f    // N m at the output
+#define FRICTION_EL     0.2f
+
+#define FEED_TICKS 256  // well inside PINGROUP_MOCK_EDGES at the top step rate
+#define SETTLE_MS 300
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const uint8_t stepPins[AXIS_COUNT] = { STEP_X, STEP_Y };
+static const uint8_t dirPins[AXIS_COUNT] = { DIR_X, DIR_Y };
+
+static PinGroup pins;
+
+struct Result
+{
+  double seconds;
+  long missed[AXIS_COUNT];
+  long worst[AXIS_COUNT];    // most missed at any point: out and back can lose the same and end on target
+  uint32_t slips[AXIS_COUNT];
+  float peak[AXIS_COUNT];
+  double error[AXIS_COUNT];  // degrees at the output, after settling
+};
+
+static void run(StepEngine& engine, MountModel& model, unsigned long ticks)
+{
+  for (unsigned long k = 0; k < ticks; k++)
+  {
+    pins.write(engine.tick(), engine.dirMask());
+    if (k % FEED_TICKS == FEED_TICKS - 1) model.feed(pins);
+  }
+  model.feed(pins);
+}
+
+static Result slew(RampShape shape, float accel, float maxRate, long azSteps, long elSteps)
+{
+  StepEngine engine;
+  MountModel model;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    engine.setProfile(i, STEP_START_RATE, accel, maxRate, shape);
+  model.setAxis(AXIS_AZ, AxisPlant::nema17A4988(gearAz, LOAD_INERTIA_AZ, BACKLASH_DEG, FRICTION_AZ), stepPins[0], dirPins[0]);
+  model.setAxis(AXIS_EL, AxisPlant::nema17A4988(gearEl, LOAD_INERTIA_EL, BACKLASH_DEG, FRICTION_EL), stepPins[1], dirPins[1]);
+  pins.begin(stepPins, dirPins, engine.dirMask());
+  model.feed(pins);
+
+  engine.queueLine(azSteps, elSteps);
+  engine.queueLine(0, 0);
+  Result r;
+  r.worst[AXIS_AZ] = r.worst[AXIS_EL] = 0;
+  unsigned long ticks = 0;
+  while (engine.isSegmentBusy() && ticks < 600 * STEP_TICK_HZ)
+  {
+    run(engine, model, FEED_TICKS);
+    ticks += FEED_TICKS;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      if (labs(model.missedSteps(i)) > r.worst[i]) r.worst[i] = labs(model.missedSteps(i));
+  }
+  run(engine, model, SETTLE_MS * 1000UL / STEP_TICK_US);
+
+  r.seconds = ticks / (double)STEP_TICK_HZ;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    r.missed[i] = model.missedSteps(i);
+    r.slips[i] = model.slips(i);
+    r.peak[i] = model.peakLoadAngle(i);
+    r.error[i] = model.error(i);
+  }
+  return r;
+}
+
+int main(int argc, char** argv)
+{
+  RampShape shape = argc > 1 && strcmp(argv[1], "trapezoid") == 0 ? RAMP_TRAPEZOID : RAMP_SCURVE;
+  double azDeg = argc > 2 ? atof(argv[2]) : 90;
+  double elDeg = argc > 3 ? atof(argv[3]) : 45;
+  long azSteps = gearAz.degreesToSteps(azDeg), elSteps = gearEl.degreesToSteps(elDeg);
+  const float accels[] = { 3000, 12000, 48000, 192000 };
+  const float rates[] = { 4000, 8000, 12000, 16000, 20000 };
+
+  printf("%s slew to az %.1f el %.1f deg and back, start rate %.0f steps/s\n",
+         shape == RAMP_SCURVE ? "S-curve" : "trapezoid", azDeg, elDeg, STEP_START_RATE);
+  printf("                       net missed steps  most missed       slips      load angle      end error deg\n");
+  printf(" accel   rate  time s       az      el       az      el      az    el      az    el        az       el\n");
+  for (unsigned a = 0; a < sizeof(accels) / sizeof(accels[0]); a++)
+  {
+    for (unsigned v = 0; v < sizeof(rates) / sizeof(rates[0]); v++)
+    {
+      Result r = slew(shape, accels[a], rates[v], azSteps, elSteps);
+      printf("%6.0f  %5.0f  %6.2f  %7ld %7ld  %7ld %7ld  %6u %5u  %6.2f %5.2f  %8.3f %8.3f%s\n", accels[a], rates[v],
+             r.seconds, r.missed[0], r.missed[1], r.worst[0], r.worst[1], r.slips[0], r.slips[1], r.peak[0], r.peak[1],
+             r.error[0], r.error[1],
+             accels[a] == STEP_ACCEL && rates[v] == SLEW_RATE ? "  <- main.cpp" : "");
+    }
+  }
+  return 0;
+}
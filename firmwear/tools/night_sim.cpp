@@ -0,0 +1,140 @@
+//======================================================================================================================
+// night_sim
+//
+// Host simulation of night parking over several days. Runs the firmware's SunTracker in velocity mode on the step
+// engine, on a simulated clock with the sun from a SunSource - tracking into sunset, stowing, pre-positioning before
+// sunrise and tracking again - and reports how long after sunrise the mirror is on the sun, with parking and, for
+// comparison, with the mirror left where it stopped at dusk (setNightParking(false)). update() runs at the interval
+// SunTracker asks for, as main.cpp's loop does.
+//
+// Fails if on any night with parking the mirror is not on the sun within NIGHT_LOCK_LIMIT_S of sunrise.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -Ilib/SunPosition/src -Ilib/Tracking/src
+//       -I.pio/libdeps/esp32dev/SolarCalculator/src -o night_sim tools/night_sim.cpp
+//       $(ls lib/Motion/src/*.cpp | grep -v StepDriver) lib/SunPosition/src/*.cpp lib/Tracking/src/*.cpp
+//       .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./night_sim [days] [lat] [lon] [year-month-day]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SunTracker.h"
+#include "MountConfig.h"
+#include <SolarCalculator.h>
+
+#define NIGHT_LOCK_LIMIT_S 30
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const CableWrap cableWrap(angleFromDegrees(DEFAULT_WRAP_MIN_DEG), angleFromDegrees(DEFAULT_WRAP_MAX_DEG));
+
+struct Night
+{
+  double riseToLock;    // s from the sun reaching elevation 0 until the mirror is on it
+  double firmwareLock;  // s, timeToLock() as the firmware reports it
+  double parkMoves;     // s the axes spent on stow and pre-position moves
+};
+
+static unsigned long simUtc;
+
+static unsigned long simClock()
+{
+  return simUtc;
+}
+
+static double mechanicalAz(double bearing, long fromSteps)
+{
+  return angleToDegrees(cableWrap.nearest(angleSaturate(gearAz.toAngle(fromSteps)), angleFromDegrees(bearing)));
+}
+
+// Track from a little before sunset on the day of start to a while after the next sunrise
+static Night track(double lat, double lon, bool park, unsigned long start)
+{
+  Night res = { -1, -1, 0 };
+  double transit, rise, set;
+  calcSunriseSunset(start, lat, lon, transit, rise, set, SUNRISE_ALTITUDE);
+  unsigned long day = start - start % 86400UL;
+  unsigned long from = day + (unsigned long)(set * 3600) - 900;
+  calcSunriseSunset(day + 86400UL, lat, lon, transit, rise, set, SUNRISE_ALTITUDE);
+  unsigned long to = day + 86400UL + (unsigned long)(rise * 3600) + 900;
+
+  // Start on the sun, as if tracking all afternoon
+  StepEngine engine;
+  engine.setProfile(AXIS_AZ, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_AZ);
+  engine.setProfile(AXIS_EL, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_EL);
+  double az, el;
+  calcHorizontalCoordinates(from, lat, lon, az, el);
+  engine.setPosition(AXIS_AZ, gearAz.degreesToSteps(mechanicalAz(az, 0)));
+  engine.setPosition(AXIS_EL, gearEl.degreesToSteps(el));
+  SunSource sun(Observer(lat, lon));
+  SunTracker tracker(engine, sun, simClock, gearAz, gearEl, cableWrap);
+  tracker.setNightParking(park);
+  tracker.start(0);
+
+  bool night = false;
+  unsigned long risen = 0;
+  unsigned long interval;
+  for (unsigned long ms = 0; from + ms / 1000 < to; ms += interval)
+  {
+    simUtc = from + ms / 1000;
+    calcHorizontalCoordinates(simUtc, lat, lon, az, el);
+    if (el < 0) night = true;
+    else if (night && risen == 0) risen = simUtc;
+
+    tracker.update(ms);
+    interval = tracker.updateInterval();
+    if (!engine.isRunning(AXIS_AZ) && !engine.isRunning(AXIS_EL)) continue;
+    for (unsigned long t = 0; t < interval * 1000UL / STEP_TICK_US; t++)
+      engine.tick();
+    if (tracker.park() != PARK_NONE) res.parkMoves += interval / 1000.0;
+
+    // On the sun: both axes within the lock threshold of where it is at the end of this loop interval
+    if (risen == 0 || res.riseToLock >= 0) continue;
+    unsigned long end = simUtc + interval / 1000;
+    calcHorizontalCoordinates(end, lat, lon, az, el);
+    long azErr = gearAz.degreesToSteps(mechanicalAz(az, engine.position(AXIS_AZ))) - engine.position(AXIS_AZ);
+    long elErr = gearEl.degreesToSteps(el) - engine.position(AXIS_EL);
+    if (labs(azErr) <= LOCK_THRESHOLD_STEPS && labs(elErr) <= LOCK_THRESHOLD_STEPS) res.riseToLock = end - risen;
+  }
+  res.firmwareLock = tracker.timeToLock() < 0 ? -1 : tracker.timeToLock() / 1000.0;
+  return res;
+}
+
+int main(int argc, char** argv)
+{
+  int days = argc > 1 ? atoi(argv[1]) : 7;
+  double lat = argc > 2 ? atof(argv[2]) : 48.21;
+  double lon = argc > 3 ? atof(argv[3]) : 16.37;
+  struct tm date = {};
+  date.tm_year = 2026 - 1900;
+  date.tm_mon = 2;
+  date.tm_mday = 20;
+  if (argc > 4 && sscanf(argv[4], "%d-%d-%d", &date.tm_year, &date.tm_mon, &date.tm_mday) == 3)
+  {
+    date.tm_year -= 1900;
+    date.tm_mon -= 1;
+  }
+  unsigned long start = (unsigned long)timegm(&date) + 43200;
+
+  printf("lat %.2f lon %.2f, %d nights from %04d-%02d-%02d\n", lat, lon, days, date.tm_year + 1900, date.tm_mon + 1,
+         date.tm_mday);
+  printf("night   parked: rise->lock s  reported s  park moves s    left at dusk: rise->lock s  reported s\n");
+  double worstParked = 0, worstLeft = 0;
+  for (int d = 0; d < days; d++)
+  {
+    Night a = track(lat, lon, true, start + d * 86400UL);
+    Night b = track(lat, lon, false, start + d * 86400UL);
+    printf("%5d   %22.0f  %10.1f  %12.0f    %26.0f  %10.1f\n", d + 1, a.riseToLock, a.firmwareLock, a.parkMoves,
+           b.riseToLock, b.firmwareLock);
+    if (a.riseToLock < 0 || a.riseToLock > worstParked) worstParked = a.riseToLock < 0 ? 1e9 : a.riseToLock;
+    if (b.riseToLock < 0 || b.riseToLock > worstLeft) worstLeft = b.riseToLock < 0 ? 1e9 : b.riseToLock;
+  }
+  printf("worst rise->lock: parked %.0f s, left at dusk %.0f s\n", worstParked, worstLeft);
+  bool fail = worstParked > NIGHT_LOCK_LIMIT_S;
+  if (fail) printf("FAIL: parked, the mirror was not on the sun within %d s of sunrise\n", NIGHT_LOCK_LIMIT_S);
+  else printf("PASS: parked, the mirror was on the sun within %d s of every sunrise\n", NIGHT_LOCK_LIMIT_S);
+  return fail ? 1 : 0;
+}
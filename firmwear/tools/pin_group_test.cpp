@@ -0,0 +1,268 @@
+//======================================================================================================================
+// pin_group_test
+//
+// Host unit test of PinGroup's edge timing, on its mock backend. Replays the recorded edges into pin levels and checks:
+//  - begin() drives every STEP line low and every DIR line to its level, on pins in both GPIO banks
+//  - random ticks: after each write() every STEP line is at its bit and every DIR line at its level, each edge is a
+//    real change of level stamped with its tick, axes stepped together rise on the same timestamp, and writeDir()
+//    moves only DIR lines without advancing the clock
+//  - past PINGROUP_MOCK_EDGES edges the recording stops and reports overflow; clearEdges() empties it and recording
+//    carries on at the current time
+//  - a slew with reversals from the step engine, written the way TimerStepDriver::onTimer() writes it: counting the
+//    rising STEP edges by their DIR level gives the engine's position, every pulse is one tick high and at least one
+//    tick low, and DIR never changes within a tick of a rising edge
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -o pin_group_test tools/pin_group_test.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./pin_group_test
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "StepEngine.h"
+#include "PinGroup.h"
+#include "MountConfig.h"
+
+// The firmware's pins, and a set in the second GPIO bank
+static const uint8_t stepPinsLow[AXIS_COUNT] = { STEP_X, STEP_Y };
+static const uint8_t dirPinsLow[AXIS_COUNT] = { DIR_X, DIR_Y };
+static const uint8_t stepPinsHigh[AXIS_COUNT] = { 38, 47 };
+static const uint8_t dirPinsHigh[AXIS_COUNT] = { 39, 31 };
+
+#define FEED_TICKS 256  // ticks between reading out the edges, well inside PINGROUP_MOCK_EDGES
+#define MAX_TICKS (300 * (unsigned long)STEP_TICK_HZ)
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  printf("%-72s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+// Deterministic pseudo-random numbers, so a failure reproduces
+static uint32_t seed = 12345;
+
+static uint32_t random(uint32_t below)
+{
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) % below;
+}
+
+// Pin levels as the recorded edges leave them
+struct Levels
+{
+  int8_t level[64];  // -1 until the first edge
+  uint32_t read;     // edges replayed so far
+  bool redundant;    // an edge to the level the pin already had
+  bool misstamped;   // an edge not stamped with the expected time
+
+  void reset()
+  {
+    for (int p = 0; p < 64; p++)
+      level[p] = -1;
+    read = 0;
+    redundant = misstamped = false;
+  }
+
+  void replay(const PinGroup& pins, uint32_t timeUs)
+  {
+    for (; read < pins.edgeCount(); read++)
+    {
+      const PinEdge& e = pins.edge(read);
+      if (level[e.pin] == (int8_t)e.level) redundant = true;
+      if (e.timeUs != timeUs) misstamped = true;
+      level[e.pin] = e.level;
+    }
+  }
+};
+
+static void testBegin(const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT], const char* what)
+{
+  static PinGroup pins;
+  pins.clearEdges();
+  Levels levels;
+  levels.reset();
+  pins.begin(stepPins, dirPins, 1 << AXIS_EL);
+  levels.replay(pins, pins.timeUs());
+  bool ok = !pins.overflowed() && !levels.redundant && !levels.misstamped;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    ok = ok && levels.level[stepPins[i]] == 0 && levels.level[dirPins[i]] == (i == AXIS_EL);
+  check(ok, what);
+}
+
+static void testRandomTicks(const uint8_t stepPins[AXIS_COUNT], const uint8_t dirPins[AXIS_COUNT], const char* what)
+{
+  static PinGroup pins;
+  pins.clearEdges();
+  Levels levels;
+  levels.reset();
+  pins.begin(stepPins, dirPins, 0);
+  levels.replay(pins, pins.timeUs());
+  bool ok = true, together = true, clock = true;
+  uint8_t dirBits = 0;
+  for (int k = 0; k < 200000 && ok; k++)
+  {
+    if (pins.edgeCount() > PINGROUP_MOCK_EDGES - 8)
+    {
+      pins.clearEdges();
+      levels.read = 0;
+    }
+    uint8_t stepBits = random(4);
+    uint32_t before = pins.timeUs();
+    if (random(8) == 0)
+    {
+      dirBits = random(4);
+      pins.writeDir(dirBits);
+      clock = clock && pins.timeUs() == before;
+      stepBits = 0xff;  // STEP lines left alone
+    }
+    else
+    {
+      if (random(4) == 0) dirBits = random(4);
+      uint32_t first = pins.edgeCount();
+      pins.write(stepBits, dirBits);
+      clock = clock && pins.timeUs() == before + STEP_TICK_US;
+      // Both rising edges of a double step carry the same stamp by construction; check they are both there
+      if (stepBits == 3)
+      {
+        int rises = 0;
+        for (uint32_t e = first; e < pins.edgeCount(); e++)
+          if (pins.edge(e).level && (pins.edge(e).pin == stepPins[0] || pins.edge(e).pin == stepPins[1])) rises++;
+        together = together && rises == 2;
+      }
+    }
+    levels.replay(pins, before);
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      if (stepBits != 0xff && levels.level[stepPins[i]] != ((stepBits >> i) & 1)) ok = false;
+      if (levels.level[dirPins[i]] != ((dirBits >> i) & 1)) ok = false;
+    }
+    ok = ok && !levels.redundant && !levels.misstamped && !pins.overflowed();
+  }
+  check(ok, what);
+  check(together, "  axes stepped together rise on the same write");
+  check(clock, "  write() advances the clock one tick, writeDir() not at all");
+}
+
+static void testOverflow()
+{
+  static PinGroup pins;
+  pins.begin(stepPinsLow, dirPinsLow, 0);
+  pins.clearEdges();
+  // Two edges per axis per step: well past the buffer
+  for (int k = 0; k < PINGROUP_MOCK_EDGES; k++)
+    pins.write(k & 1 ? 0 : 3, 0);
+  check(pins.edgeCount() == PINGROUP_MOCK_EDGES && pins.overflowed(), "a full recording stops and reports overflow");
+
+  uint32_t now = pins.timeUs();
+  pins.clearEdges();
+  bool empty = pins.edgeCount() == 0 && !pins.overflowed();
+  pins.write(1, 0);
+  check(empty && pins.edgeCount() == 1 && pins.edge(0).timeUs == now && pins.edge(0).pin == stepPinsLow[0],
+        "clearEdges() empties it and recording carries on at the current time");
+}
+
+struct Timing
+{
+  long steps[AXIS_COUNT];    // counted from the rising edges and DIR
+  uint32_t minHigh, maxHigh;  // us
+  uint32_t minLow;            // us, between pulses of one axis
+  uint32_t minDirSetup;       // us from a DIR change to the next rising edge of its axis
+  uint32_t minDirHold;        // us from a rising edge to the next DIR change of its axis
+  unsigned long together;     // rising edges shared by both axes
+};
+
+static void testEngine()
+{
+  StepEngine engine;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    engine.setProfile(i, 800, 60000, STEP_MAX_RATE, RAMP_TRAPEZOID);
+  engine.queueLine(60000, -25000);
+  engine.queueLine(-10000, 30000);
+  engine.queueLine(5000, -3000);
+
+  static PinGroup pins;
+  pins.begin(stepPinsLow, dirPinsLow, engine.dirMask());
+  pins.clearEdges();
+
+  Timing t = { { 0, 0 }, ~0u, 0, ~0u, ~0u, ~0u, 0 };
+  bool dir[AXIS_COUNT], high[AXIS_COUNT] = { false, false };
+  uint32_t rose[AXIS_COUNT] = { 0, 0 }, fell[AXIS_COUNT] = { 0, 0 }, dirAt[AXIS_COUNT] = { 0, 0 };
+  bool pulsed[AXIS_COUNT] = { false, false }, dirSet[AXIS_COUNT] = { false, false };
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    dir[i] = (engine.dirMask() >> i) & 1;
+
+  unsigned long ticks = 0;
+  bool lost = false;
+  while ((engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL)) && ticks < MAX_TICKS)
+  {
+    for (int k = 0; k < FEED_TICKS; k++, ticks++)
+      pins.write(engine.tick(), engine.dirMask());
+    lost = lost || pins.overflowed();
+
+    uint32_t lastRise = ~0u;
+    uint8_t lastRiseAxis = 0;
+    for (uint32_t e = 0; e < pins.edgeCount(); e++)
+    {
+      const PinEdge& edge = pins.edge(e);
+      for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      {
+        if (edge.pin == dirPinsLow[i])
+        {
+          dir[i] = edge.level;
+          dirAt[i] = edge.timeUs;
+          dirSet[i] = true;
+          if (pulsed[i] && edge.timeUs - rose[i] < t.minDirHold) t.minDirHold = edge.timeUs - rose[i];
+        }
+        if (edge.pin != stepPinsLow[i]) continue;
+        if (edge.level)
+        {
+          t.steps[i] += dir[i] ? 1 : -1;
+          if (pulsed[i] && edge.timeUs - fell[i] < t.minLow) t.minLow = edge.timeUs - fell[i];
+          if (dirSet[i] && edge.timeUs - dirAt[i] < t.minDirSetup) t.minDirSetup = edge.timeUs - dirAt[i];
+          dirSet[i] = false;
+          if (lastRise == edge.timeUs && lastRiseAxis != i) t.together++;
+          lastRise = edge.timeUs;
+          lastRiseAxis = i;
+          rose[i] = edge.timeUs;
+          high[i] = true;
+          pulsed[i] = true;
+        }
+        else if (high[i])
+        {
+          uint32_t width = edge.timeUs - rose[i];
+          if (width < t.minHigh) t.minHigh = width;
+          if (width > t.maxHigh) t.maxHigh = width;
+          fell[i] = edge.timeUs;
+          high[i] = false;
+        }
+      }
+    }
+    pins.clearEdges();
+  }
+
+  printf("  slew with reversals at up to %lu steps/s: %ld + %ld steps counted, %lu on the same edge\n", STEP_MAX_RATE,
+         t.steps[AXIS_AZ], t.steps[AXIS_EL], t.together);
+  printf("  pulse high %u-%u us, low at least %u us, DIR set %u us before a step and %u us after one\n", t.minHigh,
+         t.maxHigh, t.minLow, t.minDirSetup, t.minDirHold);
+  check(!lost && t.steps[AXIS_AZ] == engine.position(AXIS_AZ) && t.steps[AXIS_EL] == engine.position(AXIS_EL),
+        "engine slew: rising edges and DIR count to the engine's position");
+  check(t.minHigh == STEP_TICK_US && t.maxHigh == STEP_TICK_US && t.minLow >= STEP_TICK_US,
+        "  every pulse one tick high and at least one tick low");
+  check(t.minDirSetup >= STEP_TICK_US && t.minDirHold >= STEP_TICK_US, "  DIR never changes within a tick of a step");
+  check(t.together > 0, "  both axes step on the same edge");
+}
+
+int main()
+{
+  testBegin(stepPinsLow, dirPinsLow, "begin(): STEP low, DIR at its level (pins below 32)");
+  testBegin(stepPinsHigh, dirPinsHigh, "begin(): STEP low, DIR at its level (pins in both banks)");
+  testRandomTicks(stepPinsLow, dirPinsLow, "random ticks: every line at its level, every edge real and on time");
+  testRandomTicks(stepPinsHigh, dirPinsHigh, "random ticks, pins in both banks");
+  testOverflow();
+  testEngine();
+  if (failures) printf("FAIL: %d pin group checks failed\n", failures);
+  else printf("PASS: the pin group writes every edge of a tick at once, on time\n");
+  return failures ? 1 : 0;
+}
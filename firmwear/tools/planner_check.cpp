@@ -0,0 +1,232 @@
+//======================================================================================================================
+// planner_check
+//
+// Host test of MotionPlanner's limits and benchmark of its planning throughput. Each path is planned and run through
+// the step engine tick by tick, watching the signed rate of each axis:
+//  - no axis runs faster than its top speed
+//  - between ticks an axis changes its rate by no more than its acceleration allows, except where one leg hands over
+//    to the next: there the rate may jump by up to the axis's start rate, and an axis that reverses must come down
+//    to its start rate on the one side and leave from it on the other
+//  - the path ends on its last waypoint, and takes no longer than stopping at every waypoint would
+// Paths are corners, zigzags, reversals, collinear and repeated waypoints, very short legs and random walks, on the
+// main.cpp settings and on axes with different limits.
+//
+// The benchmark times execute() - planning plus queueing the chain - for paths of several lengths and reports
+// waypoints per second on the host.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Ilib/Motion/src -o planner_check tools/planner_check.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./planner_check
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "MotionPlanner.h"
+
+#define RATE_TOLERANCE 0.01    // relative, for float rounding in the rate conversions
+#define RATE_SLACK 0.5f        // steps/s
+#define TIMED_PATHS 20000
+#define MAX_TICKS (600 * (unsigned long)STEP_TICK_HZ)
+
+struct Limits
+{
+  const char* name;
+  float startRate[AXIS_COUNT];
+  float accel[AXIS_COUNT];  // peak for an S-curve, as setProfile takes it
+  float maxRate[AXIS_COUNT];
+  RampShape shape;
+};
+
+static const Limits limitSets[] = {
+  { "main.cpp", { 800, 800 }, { 3000, 3000 }, { 4000, 4000 }, RAMP_SCURVE },
+  { "unequal", { 800, 300 }, { 6000, 1500 }, { 8000, 2000 }, RAMP_TRAPEZOID },
+  { "fast", { 1000, 1000 }, { 40000, 40000 }, { 20000, 20000 }, RAMP_TRAPEZOID },
+};
+#define LIMIT_COUNT (sizeof(limitSets) / sizeof(limitSets[0]))
+
+struct Path
+{
+  const char* name;
+  uint8_t count;
+  long points[PLANNER_MAX_WAYPOINTS][AXIS_COUNT];
+};
+
+static const Path fixedPaths[] = {
+  { "square", 4, { { 20000, 0 }, { 20000, 20000 }, { 0, 20000 }, { 0, 0 } } },
+  { "gentle corners", 4, { { 10000, 1000 }, { 20000, 3000 }, { 30000, 6000 }, { 40000, 10000 } } },
+  { "zigzag", 8, { { 3000, 1000 }, { 6000, -1000 }, { 9000, 1000 }, { 12000, -1000 },
+                   { 15000, 1000 }, { 18000, -1000 }, { 21000, 1000 }, { 24000, 0 } } },
+  { "reversal", 3, { { 15000, 5000 }, { 0, 0 }, { 15000, 5000 } } },
+  { "collinear", 5, { { 5000, 1000 }, { 10000, 2000 }, { 15000, 3000 }, { 20000, 4000 }, { 25000, 5000 } } },
+  { "repeated", 5, { { 8000, 0 }, { 8000, 0 }, { 16000, 0 }, { 16000, 0 }, { 16000, 8000 } } },
+  { "short legs", 8, { { 2, 1 }, { 5, 1 }, { 6, 4 }, { 3, 6 }, { 1, 5 }, { 40, 5 }, { 41, 60 }, { 0, 0 } } },
+  { "single axis", 3, { { 0, 12000 }, { 0, -4000 }, { 0, 500 } } },
+};
+#define FIXED_PATH_COUNT (sizeof(fixedPaths) / sizeof(fixedPaths[0]))
+#define RANDOM_PATH_COUNT 40
+
+// Deterministic pseudo-random numbers, so a failure reproduces
+static uint32_t seed = 12345;
+
+static uint32_t random(uint32_t below)
+{
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) % below;
+}
+
+static Path randomPath(uint32_t n)
+{
+  Path p = { "random", (uint8_t)(2 + random(PLANNER_MAX_WAYPOINTS - 1)), {} };
+  long at[AXIS_COUNT] = { 0, 0 };
+  // Alternately long and short legs, so some run at speed and some never get going
+  uint32_t reach = n % 2 ? 30000 : 600;
+  for (uint8_t k = 0; k < p.count; k++)
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      at[i] += (long)random(2 * reach + 1) - (long)reach;
+      p.points[k][i] = at[i];
+    }
+  return p;
+}
+
+static void setLimits(StepEngine& engine, const Limits& l)
+{
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    engine.setProfile(i, l.startRate[i], l.accel[i], l.maxRate[i], l.shape);
+}
+
+struct Result
+{
+  bool ended;          // on the last waypoint
+  double seconds;
+  double stopSeconds;  // stopping at every waypoint
+  double overSpeed;    // largest excess over the top speed, steps/s
+  double overAccel;    // largest excess of a ramp step over the acceleration, steps/s
+  double overJump;     // largest excess of a hand-over jump over the start rate, steps/s
+  unsigned long jumps;
+};
+
+// Runs the engine until both axes stop; returns the ticks taken, and checks the rates if given a result
+static unsigned long runEngine(StepEngine& engine, const Limits& l, Result* r)
+{
+  float last[AXIS_COUNT] = { 0, 0 };
+  unsigned long tick = 0;
+  uint32_t queued = engine.queuedSegments();
+  while ((engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL)) && tick < MAX_TICKS)
+  {
+    engine.tick();
+    tick++;
+    if (!r) continue;
+    // A leg hands over where the ISR takes the next segment from the queue. On the tick before, the finished leg
+    // reads as standing still; that is bookkeeping, not a rate the motors see.
+    bool handOver = engine.queuedSegments() != queued;
+    queued = engine.queuedSegments();
+    if (handOver) r->jumps++;
+    if (engine.rate(AXIS_AZ) == 0 && engine.rate(AXIS_EL) == 0 && engine.queuedSegments() > 0) continue;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      float rate = engine.rate(i) * (engine.dirMask() & (1 << i) ? 1 : -1);
+      float over = fabsf(rate) - l.maxRate[i] * (1 + RATE_TOLERANCE) - RATE_SLACK;
+      if (over > r->overSpeed) r->overSpeed = over;
+      float rampStep = l.accel[i] / STEP_TICK_HZ * (1 + RATE_TOLERANCE) + RATE_SLACK;
+      float change = fabsf(rate - last[i]);
+      // The ramp is decided step by step, so a leg can end up to one step's worth of acceleration off its exit rate
+      float stepSlack = l.accel[i] / l.startRate[i];
+      if (change > rampStep)
+      {
+        if (handOver || rate == 0 || last[i] == 0)
+        {
+          // Through a reversal the axis stops and starts again: each side on its own is the jump
+          float jump = change;
+          if (rate * last[i] < 0) jump = fabsf(rate) > fabsf(last[i]) ? fabsf(rate) : fabsf(last[i]);
+          float over = jump - l.startRate[i] * (1 + RATE_TOLERANCE) - rampStep - stepSlack;
+          if (over > r->overJump) r->overJump = over;
+        }
+        else if (change - rampStep > r->overAccel) r->overAccel = change - rampStep;
+      }
+      last[i] = rate;
+    }
+  }
+  return tick;
+}
+
+static Result check(const Limits& l, const Path& p)
+{
+  Result r = {};
+  StepEngine engine;
+  setLimits(engine, l);
+  MotionPlanner planner(engine);
+  for (uint8_t k = 0; k < p.count; k++)
+    planner.addWaypoint(p.points[k][AXIS_AZ], p.points[k][AXIS_EL]);
+  if (!planner.execute()) return r;
+  r.seconds = runEngine(engine, l, &r) / (double)STEP_TICK_HZ;
+  r.ended = engine.position(AXIS_AZ) == p.points[p.count - 1][AXIS_AZ] &&
+            engine.position(AXIS_EL) == p.points[p.count - 1][AXIS_EL];
+
+  // The same path with a stop at every waypoint
+  StepEngine stopping;
+  setLimits(stopping, l);
+  for (uint8_t k = 0; k < p.count; k++)
+    stopping.queueLine(p.points[k][AXIS_AZ], p.points[k][AXIS_EL]);
+  r.stopSeconds = runEngine(stopping, l, NULL) / (double)STEP_TICK_HZ;
+  return r;
+}
+
+static double now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Waypoints per second through execute(), for paths of the given length
+static double throughput(uint8_t count)
+{
+  double spent = 0;
+  unsigned long waypoints = 0;
+  for (unsigned n = 0; n < TIMED_PATHS; n++)
+  {
+    StepEngine engine;
+    setLimits(engine, limitSets[0]);
+    MotionPlanner planner(engine);
+    Path p = randomPath(n);
+    for (uint8_t k = 0; k < count; k++)
+      planner.addWaypoint(p.points[k % p.count][AXIS_AZ] + k, p.points[k % p.count][AXIS_EL]);
+    double start = now();
+    if (planner.execute()) waypoints += count;
+    spent += now() - start;
+  }
+  return waypoints / spent;
+}
+
+int main()
+{
+  printf("limits     path             legs  hand-overs   time s  stopping s  over speed  over accel  over jump\n");
+  int failures = 0;
+  for (unsigned li = 0; li < LIMIT_COUNT; li++)
+    for (unsigned k = 0; k < FIXED_PATH_COUNT + RANDOM_PATH_COUNT; k++)
+    {
+      Path p = k < FIXED_PATH_COUNT ? fixedPaths[k] : randomPath(k);
+      Result r = check(limitSets[li], p);
+      bool fail = !r.ended || r.overSpeed > 0 || r.overAccel > 0 || r.overJump > 0 || r.seconds > r.stopSeconds;
+      // Random paths only show up when they fail
+      if (k < FIXED_PATH_COUNT || fail)
+        printf("%-9s  %-15s  %4u  %10lu  %7.3f  %10.3f  %10.1f  %10.1f  %9.1f%s\n", limitSets[li].name, p.name,
+               p.count, r.jumps, r.seconds, r.stopSeconds, r.overSpeed, r.overAccel, r.overJump,
+               fail ? (r.ended ? "  <- FAIL" : "  <- FAIL (did not end on the last waypoint)") : "");
+      if (fail) failures++;
+    }
+  printf("(and %d random paths per set of limits)\n", RANDOM_PATH_COUNT);
+
+  printf("\nplanning throughput, execute() on the host:\n");
+  static const uint8_t lengths[] = { 2, 8, PLANNER_MAX_WAYPOINTS };
+  for (unsigned k = 0; k < sizeof(lengths) / sizeof(lengths[0]); k++)
+    printf("  %2u waypoints: %6.2f M waypoints/s\n", lengths[k], throughput(lengths[k]) * 1e-6);
+
+  if (failures) printf("FAIL: %d paths broke an axis limit, missed the last waypoint or ran slower than stopping\n",
+                       failures);
+  else printf("PASS: every path within the axis limits, on target and no slower than stopping at each waypoint\n");
+  return failures ? 1 : 0;
+}
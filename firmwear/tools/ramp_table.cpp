@@ -0,0 +1,85 @@
+//======================================================================================================================
+// ramp_table
+//
+// Host tool for the step engine's velocity profiles. Runs one axis through a move on the host and dumps the step
+// intervals it generates, then checks that the rate and acceleration stay continuous within the configured limits.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Ilib/Motion/src tools/ramp_table.cpp lib/Motion/src/*.cpp -o ramp_table
+//   ./ramp_table [scurve|trapezoid] [steps] [startRate] [accel] [maxRate]   step,time_us,interval_us,rate CSV
+//   ./ramp_table --table                                                    regenerate RampTable.cpp's table
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "StepEngine.h"
+
+static void printTable()
+{
+  for (int k = 0; k <= SCURVE_TABLE_SIZE; k++)
+  {
+    double t = (double)k / SCURVE_TABLE_SIZE;
+    double s = t < 0.5 ? 2 * t * t : 1 - 2 * (1 - t) * (1 - t);
+    printf("%s%lu,%s", k % 8 == 0 ? "  " : "", lround(s * SCURVE_ONE), k % 8 == 7 || k == SCURVE_TABLE_SIZE ? "\n" : " ");
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 1 && strcmp(argv[1], "--table") == 0)
+  {
+    printTable();
+    return 0;
+  }
+
+  RampShape shape = argc > 1 && strcmp(argv[1], "trapezoid") == 0 ? RAMP_TRAPEZOID : RAMP_SCURVE;
+  long steps = argc > 2 ? atol(argv[2]) : 20000;
+  float startRate = argc > 3 ? atof(argv[3]) : 800;
+  float accel = argc > 4 ? atof(argv[4]) : 3000;
+  float maxRate = argc > 5 ? atof(argv[5]) : 4000;
+
+  StepEngine engine;
+  engine.setProfile(AXIS_AZ, startRate, accel, maxRate, shape);
+  engine.moveTo(AXIS_AZ, steps, maxRate);
+
+  const double dt = STEP_TICK_US * 1e-6;
+  long tick = 0, lastStepTick = -1, stepCount = 0;
+  double prevRate = 0, prevAccel = 0, maxAccel = 0, maxAccelJump = 0;
+  printf("step,time_us,interval_us,rate\n");
+  while (engine.isRunning(AXIS_AZ) && tick < 100000000L)
+  {
+    uint8_t bits = engine.tick();
+    double rate = engine.rate(AXIS_AZ);
+
+    // The start rate is reached without a ramp, so only check while above it
+    if (prevRate > startRate && rate > startRate)
+    {
+      double a = (rate - prevRate) / dt;
+      if (fabs(a) > maxAccel) maxAccel = fabs(a);
+      if (fabs(a - prevAccel) > maxAccelJump) maxAccelJump = fabs(a - prevAccel);
+      prevAccel = a;
+    }
+    else prevAccel = 0;
+    prevRate = rate;
+
+    if (bits & (1 << AXIS_AZ))
+    {
+      stepCount++;
+      long interval = lastStepTick < 0 ? 0 : (tick - lastStepTick) * STEP_TICK_US;
+      printf("%ld,%ld,%ld,%.1f\n", stepCount, tick * STEP_TICK_US, interval, rate);
+      lastStepTick = tick;
+    }
+    tick++;
+  }
+
+  // Rate steps are bounded by the peak acceleration; the S-curve's acceleration changes only in small table steps,
+  // where the trapezoid's jumps straight between 0 and full acceleration
+  bool ok = engine.position(AXIS_AZ) == steps && maxAccel <= accel * 1.05;
+  if (shape == RAMP_SCURVE) ok = ok && maxAccelJump <= accel * 4.0 / SCURVE_TABLE_SIZE;
+  fprintf(stderr, "%s: %ld steps in %.3f s, peak accel %.0f (limit %.0f), largest accel step %.0f -> %s\n",
+          shape == RAMP_SCURVE ? "scurve" : "trapezoid", stepCount, tick * dt, maxAccel, accel, maxAccelJump,
+          ok ? "OK" : "FAIL");
+  return ok ? 0 : 1;
+}
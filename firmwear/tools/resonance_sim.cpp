@@ -0,0 +1,171 @@
+//======================================================================================================================
+// resonance_sim
+//
+// Host test of resonance band avoidance. Gives the elevation axis of MountModel a mid-band resonance and runs the
+// moves that used to cross it blindly - a jog, a goto line whose elevation rate lands in the band, a single-axis
+// move and timed segments, all at a rate inside the band, and a slew that only ramps through it - with and without
+// the band (plus a margin) configured in the step engine. With the band, the engine ramps through it at full
+// acceleration but never cruises inside, so the resonance does not get to build up and no steps are lost. Moves
+// reach the same distance either way, the timed segments in the same time.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -o resonance_sim tools/resonance_sim.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./resonance_sim [band low] [band high]   steps/s
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "StepEngine.h"
+#include "PinGroup.h"
+#include "MountModel.h"
+#include "MountConfig.h"
+
+// Same load as mount_sim
+#define LOAD_INERTIA_AZ 0.012f
+#define LOAD_INERTIA_EL 0.005f
+#define BACKLASH_DEG    0.1f
+#define FRICTION_AZ     0.3f
+#define FRICTION_EL     0.2f
+
+#define RESONANCE_DEPTH   0.9f   // of the torque
+#define RESONANCE_BUILDUP 0.1f   // s
+#define BAND_MARGIN       0.05f  // the band given to the engine is this much wider each side
+
+#define FEED_TICKS 256
+#define SETTLE_MS 300
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const uint8_t stepPins[AXIS_COUNT] = { STEP_X, STEP_Y };
+static const uint8_t dirPins[AXIS_COUNT] = { DIR_X, DIR_Y };
+
+static PinGroup pins;
+static float bandLow = 1150, bandHigh = 1350;
+
+enum Move
+{
+  MOVE_JOG,
+  MOVE_LINE,
+  MOVE_SINGLE,
+  MOVE_TIMED,
+  MOVE_RAMP_THROUGH,
+  MOVE_COUNT
+};
+
+static const char* moveNames[MOVE_COUNT] = { "jog 2 s", "goto line", "moveTo el", "timed x3", "moveTo el fast" };
+
+struct Result
+{
+  double seconds;
+  long commanded;
+  long missed;
+  uint32_t slips;
+  float resonance;
+};
+
+static void run(StepEngine& engine, MountModel& model, unsigned long ticks)
+{
+  for (unsigned long k = 0; k < ticks; k++)
+  {
+    pins.write(engine.tick(), engine.dirMask());
+    if (k % FEED_TICKS == FEED_TICKS - 1) model.feed(pins);
+  }
+  model.feed(pins);
+}
+
+static unsigned long runUntilIdle(StepEngine& engine, MountModel& model)
+{
+  unsigned long ticks = 0;
+  while ((engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL)) && ticks < 60 * STEP_TICK_HZ)
+  {
+    run(engine, model, FEED_TICKS);
+    ticks += FEED_TICKS;
+  }
+  return ticks;
+}
+
+static Result simulate(Move move, bool avoid)
+{
+  StepEngine engine;
+  MountModel model;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    engine.setProfile(i, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SCURVE);
+  if (avoid) engine.setResonanceBand(AXIS_EL, 0, bandLow * (1 - BAND_MARGIN), bandHigh * (1 + BAND_MARGIN));
+
+  AxisPlant el = AxisPlant::nema17A4988(gearEl, LOAD_INERTIA_EL, BACKLASH_DEG, FRICTION_EL);
+  el.resonanceLow = bandLow;
+  el.resonanceHigh = bandHigh;
+  el.resonanceDepth = RESONANCE_DEPTH;
+  el.resonanceBuildup = RESONANCE_BUILDUP;
+  model.setAxis(AXIS_AZ, AxisPlant::nema17A4988(gearAz, LOAD_INERTIA_AZ, BACKLASH_DEG, FRICTION_AZ), stepPins[0], dirPins[0]);
+  model.setAxis(AXIS_EL, el, stepPins[1], dirPins[1]);
+  pins.begin(stepPins, dirPins, engine.dirMask());
+  model.feed(pins);
+
+  float inBand = (bandLow + bandHigh) / 2;
+  unsigned long ticks = 0;
+  switch (move)
+  {
+    case MOVE_JOG:
+      engine.run(AXIS_EL, true, inBand);
+      run(engine, model, 2 * STEP_TICK_HZ);
+      engine.stop(AXIS_EL);
+      ticks = 2 * STEP_TICK_HZ + runUntilIdle(engine, model);
+      break;
+    case MOVE_LINE:
+      // Azimuth leads at the slew rate, elevation follows in the band
+      engine.queueLine(gearAz.degreesToSteps(180), (long)(gearAz.degreesToSteps(180) * inBand / SLEW_RATE));
+      ticks = runUntilIdle(engine, model);
+      break;
+    case MOVE_SINGLE:
+      engine.moveTo(AXIS_EL, gearEl.degreesToSteps(45), inBand);
+      ticks = runUntilIdle(engine, model);
+      break;
+    case MOVE_TIMED:
+      for (int k = 1; k <= 3; k++)
+        engine.queueTimed(0, (long)(inBand * k), 1000000UL);
+      ticks = runUntilIdle(engine, model);
+      break;
+    case MOVE_RAMP_THROUGH:
+      engine.moveTo(AXIS_EL, gearEl.degreesToSteps(90), SLEW_RATE);
+      ticks = runUntilIdle(engine, model);
+      break;
+    default:
+      break;
+  }
+  run(engine, model, SETTLE_MS * 1000UL / STEP_TICK_US);
+
+  Result r;
+  r.seconds = ticks / (double)STEP_TICK_HZ;
+  r.commanded = model.commanded(AXIS_EL);
+  r.missed = model.missedSteps(AXIS_EL);
+  r.slips = model.slips(AXIS_EL);
+  r.resonance = model.peakResonance(AXIS_EL);
+  return r;
+}
+
+int main(int argc, char** argv)
+{
+  if (argc > 2)
+  {
+    bandLow = atof(argv[1]);
+    bandHigh = atof(argv[2]);
+  }
+
+  printf("elevation resonance %.0f-%.0f steps/s, %.0f%% of the torque, builds up in %.0f ms\n", bandLow, bandHigh,
+         RESONANCE_DEPTH * 100, RESONANCE_BUILDUP * 1000);
+  printf("                   band not configured                    band configured\n");
+  printf("move               time s  el steps  missed  slips  res     time s  el steps  missed  slips  res\n");
+  int failures = 0;
+  for (int m = 0; m < MOVE_COUNT; m++)
+  {
+    Result off = simulate((Move)m, false);
+    Result on = simulate((Move)m, true);
+    printf("%-16s  %7.2f  %8ld  %6ld  %5u  %4.2f   %7.2f  %8ld  %6ld  %5u  %4.2f\n", moveNames[m], off.seconds,
+           off.commanded, off.missed, off.slips, off.resonance, on.seconds, on.commanded, on.missed, on.slips,
+           on.resonance);
+    if (on.slips > 0) failures++;
+  }
+  printf("%s\n", failures ? "FAIL: steps lost with the band configured" : "PASS: no steps lost with the band configured");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,272 @@
+//======================================================================================================================
+// rmt_encoder_test
+//
+// Host unit test and benchmark of RmtEncoder. Decodes what the encoder writes back into level runs and checks:
+//  - random step patterns: every batch lasts exactly ticks * tickDuration, each step is a pulse of the pulse width at
+//    the start of its tick, and nothing else is high
+//  - idle runs longer than a 15-bit duration are split and still add up
+//  - a small buffer: ticking only while hasRoom() says so, no tick is ever refused and no step goes missing
+//  - trimLead() shortens only a leading low run, never below one RMT tick
+//  - a slew from the step engine, cut into batches the way RmtStepDriver::encodeBatch() cuts them, comes out with
+//    every step the engine made at its tick
+// Then times the encoder per tick at a few step rates.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Ilib/Motion/src -o rmt_encoder_test tools/rmt_encoder_test.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./rmt_encoder_test
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <vector>
+#include "RmtEncoder.h"
+#include "StepEngine.h"
+
+// Same as StepDriver.h
+#define RMT_BATCH_TICKS 400
+#define RMT_BATCH_SYMBOLS (RMT_BATCH_TICKS / 2 + 8)
+#define RMT_PULSE_US 3
+
+#define TIMED_TICKS 20000000UL
+
+static int failures = 0;
+
+static void check(bool ok, const char* what)
+{
+  printf("%-64s %s\n", what, ok ? "ok" : "FAIL");
+  if (!ok) failures++;
+}
+
+// Deterministic pseudo-random numbers, so a failure reproduces
+static uint32_t seed = 12345;
+
+static uint32_t random(uint32_t below)
+{
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) % below;
+}
+
+// The waveform the symbols play back, one level per RMT tick, up to the end marker
+static std::vector<uint8_t> decode(const RmtSymbol* symbols, size_t count)
+{
+  std::vector<uint8_t> wave;
+  for (size_t k = 0; k < count; k++)
+  {
+    if (symbols[k].duration0 == 0) break;
+    wave.insert(wave.end(), symbols[k].duration0, symbols[k].level0);
+    if (symbols[k].duration1 == 0) break;
+    wave.insert(wave.end(), symbols[k].duration1, symbols[k].level1);
+  }
+  return wave;
+}
+
+// The waveform a step pattern should give
+static std::vector<uint8_t> expected(const std::vector<bool>& steps, uint16_t tickDuration, uint16_t pulseDuration)
+{
+  std::vector<uint8_t> wave;
+  for (size_t t = 0; t < steps.size(); t++)
+    for (uint16_t u = 0; u < tickDuration; u++)
+      wave.push_back(steps[t] && u < pulseDuration);
+  return wave;
+}
+
+static bool encodes(const std::vector<bool>& steps, uint16_t tickDuration, uint16_t pulseDuration, size_t capacity)
+{
+  std::vector<RmtSymbol> buffer(capacity);
+  RmtEncoder encoder(tickDuration, pulseDuration);
+  encoder.begin(&buffer[0], capacity);
+  for (size_t t = 0; t < steps.size(); t++)
+    if (!encoder.addTick(steps[t])) return false;
+  size_t count = encoder.finish();
+  return !encoder.overflowed() && decode(&buffer[0], count) == expected(steps, tickDuration, pulseDuration);
+}
+
+static void testRandomPatterns()
+{
+  bool ok = true;
+  for (int k = 0; k < 2000 && ok; k++)
+  {
+    // From sparse to a step on every tick
+    uint32_t perMille = random(1001);
+    std::vector<bool> steps(1 + random(RMT_BATCH_TICKS));
+    for (size_t t = 0; t < steps.size(); t++)
+      steps[t] = random(1000) < perMille;
+    ok = encodes(steps, STEP_TICK_US, RMT_PULSE_US, steps.size() + 8);
+  }
+  check(ok, "random step patterns decode to their waveform");
+}
+
+static void testLongRuns()
+{
+  std::vector<bool> steps(5000, false);
+  steps[0] = steps[1700] = steps[4999] = true;
+  check(encodes(steps, STEP_TICK_US, RMT_PULSE_US, 16), "idle runs past 32767 RMT ticks are split");
+  std::vector<bool> idle(3000, false);
+  check(encodes(idle, STEP_TICK_US, RMT_PULSE_US, 4), "a batch with no steps at all");
+}
+
+static void testSmallBuffer()
+{
+  bool ok = true;
+  for (int k = 0; k < 2000 && ok; k++)
+  {
+    size_t capacity = 2 + random(12);
+    uint32_t perMille = random(1001);
+    std::vector<RmtSymbol> buffer(capacity);
+    RmtEncoder encoder(STEP_TICK_US, RMT_PULSE_US);
+    encoder.begin(&buffer[0], capacity);
+    std::vector<bool> steps;
+    while (encoder.hasRoom() && steps.size() < 10000)
+    {
+      bool step = random(1000) < perMille;
+      steps.push_back(step);
+      if (!encoder.addTick(step)) ok = false;
+    }
+    size_t count = encoder.finish();
+    ok = ok && !encoder.overflowed() && decode(&buffer[0], count) == expected(steps, STEP_TICK_US, RMT_PULSE_US);
+  }
+  check(ok, "ticking while hasRoom(): never refused, no step lost");
+
+  // Ticking on regardless is refused once full, and says so
+  RmtSymbol buffer[2];
+  RmtEncoder encoder(STEP_TICK_US, RMT_PULSE_US);
+  encoder.begin(buffer, 2);
+  bool refused = false;
+  for (int t = 0; t < 10 && !refused; t++)
+    refused = !encoder.addTick(true);
+  check(refused && encoder.overflowed(), "a full buffer refuses the tick and reports overflow");
+}
+
+static void testTrimLead()
+{
+  RmtSymbol buffer[8];
+  RmtEncoder encoder(STEP_TICK_US, RMT_PULSE_US);
+  encoder.begin(buffer, 8);
+  for (int t = 0; t < 10; t++)
+    encoder.addTick(t == 4);
+  size_t count = encoder.finish();
+  bool ok = encoder.leadTrimmable() == 4 * STEP_TICK_US - 1;
+  encoder.trimLead(30);
+  std::vector<uint8_t> wave = decode(buffer, count);
+  ok = ok && wave.size() == 10 * STEP_TICK_US - 30 && wave[4 * STEP_TICK_US - 30] == 1 && wave[0] == 0;
+  encoder.trimLead(1000);
+  wave = decode(buffer, count);
+  ok = ok && wave.size() == 6 * STEP_TICK_US + 1 && wave[0] == 0 && wave[1] == 1;
+  check(ok, "trimLead() shortens the leading low run, keeping one tick");
+
+  encoder.begin(buffer, 8);
+  encoder.addTick(true);
+  encoder.addTick(false);
+  count = encoder.finish();
+  encoder.trimLead(10);
+  check(encoder.leadTrimmable() == 0 && decode(buffer, count).size() == 2 * STEP_TICK_US,
+        "trimLead() leaves a batch that starts with a pulse alone");
+}
+
+// encodeBatch() on the host: returns the ticks taken
+static uint16_t encodeBatch(StepEngine& engine, RmtEncoder encoder[AXIS_COUNT], RmtSymbol buffer[AXIS_COUNT][RMT_BATCH_SYMBOLS],
+                            std::vector<uint8_t>& engineSteps, unsigned long& lost)
+{
+  uint8_t dirBits = engine.dirMask();
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    encoder[i].begin(buffer[i], RMT_BATCH_SYMBOLS);
+  uint16_t ticks = 0;
+  while (ticks < RMT_BATCH_TICKS && encoder[AXIS_AZ].hasRoom() && encoder[AXIS_EL].hasRoom())
+  {
+    uint8_t stepBits = engine.tick();
+    engineSteps.push_back(stepBits);
+    ticks++;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      if (!encoder[i].addTick(stepBits & (1 << i))) lost++;
+    if (engine.dirMask() != dirBits) break;
+  }
+  return ticks;
+}
+
+static void testEngineBatches()
+{
+  StepEngine engine;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    engine.setProfile(i, 800, 60000, STEP_MAX_RATE, RAMP_TRAPEZOID);
+  engine.queueLine(60000, -25000);
+  engine.queueLine(0, 0);
+
+  static RmtSymbol buffer[AXIS_COUNT][RMT_BATCH_SYMBOLS];
+  RmtEncoder encoder[AXIS_COUNT] = { RmtEncoder(STEP_TICK_US, RMT_PULSE_US), RmtEncoder(STEP_TICK_US, RMT_PULSE_US) };
+  std::vector<uint8_t> engineSteps;
+  std::vector<uint8_t> wave[AXIS_COUNT];
+  unsigned long lost = 0, batches = 0, shortBatches = 0;
+  while (engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL))
+  {
+    uint16_t ticks = encodeBatch(engine, encoder, buffer, engineSteps, lost);
+    batches++;
+    if (ticks < RMT_BATCH_TICKS) shortBatches++;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      std::vector<uint8_t> w = decode(buffer[i], encoder[i].finish());
+      wave[i].insert(wave[i].end(), w.begin(), w.end());
+    }
+  }
+
+  bool ok = lost == 0;
+  long steps[AXIS_COUNT] = { 0, 0 };
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    std::vector<bool> pattern(engineSteps.size());
+    for (size_t t = 0; t < engineSteps.size(); t++)
+    {
+      pattern[t] = (engineSteps[t] & (1 << i)) != 0;
+      steps[i] += pattern[t];
+    }
+    ok = ok && wave[i] == expected(pattern, STEP_TICK_US, RMT_PULSE_US);
+  }
+  printf("  slew out and back at up to %lu steps/s: %lu batches, %lu ended early (DIR change or buffer), %ld + %ld steps\n",
+         STEP_MAX_RATE, batches, shortBatches, steps[AXIS_AZ], steps[AXIS_EL]);
+  check(ok && steps[AXIS_AZ] == 120000 && steps[AXIS_EL] == 50000, "engine slew in batches: every step at its tick");
+}
+
+static void benchmark()
+{
+  static const uint32_t perMille[] = { 0, 10, 100, 500 };
+  static RmtSymbol buffer[RMT_BATCH_SYMBOLS];
+  RmtEncoder encoder(STEP_TICK_US, RMT_PULSE_US);
+  for (unsigned k = 0; k < sizeof(perMille) / sizeof(perMille[0]); k++)
+  {
+    // Steps every 1000 / perMille ticks, evenly
+    struct timespec a, b;
+    unsigned long symbols = 0;
+    uint32_t phase = 0;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (unsigned long t = 0; t < TIMED_TICKS; t += RMT_BATCH_TICKS)
+    {
+      encoder.begin(buffer, RMT_BATCH_SYMBOLS);
+      for (uint16_t u = 0; u < RMT_BATCH_TICKS; u++)
+      {
+        phase += perMille[k];
+        bool step = phase >= 1000;
+        if (step) phase -= 1000;
+        encoder.addTick(step);
+      }
+      symbols += encoder.finish();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    double ns = ((b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec)) / TIMED_TICKS;
+    printf("  %5.0f steps/s: %5.2f ns/tick, %5.1f symbols per batch\n", perMille[k] * STEP_TICK_HZ / 1000.0, ns,
+           (double)symbols * RMT_BATCH_TICKS / TIMED_TICKS);
+  }
+}
+
+int main()
+{
+  testRandomPatterns();
+  testLongRuns();
+  testSmallBuffer();
+  testTrimLead();
+  testEngineBatches();
+  printf("encoding, one line:\n");
+  benchmark();
+  if (failures) printf("FAIL: %d encoder checks failed\n", failures);
+  else printf("PASS: the encoder plays back every step pattern exactly\n");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,107 @@
+//======================================================================================================================
+// segment_queue_stress
+//
+// Host stress test of SegmentQueue, the ring buffer between the planner and the step ISR. A producer thread pushes
+// a numbered sequence of StepSegments into a queue of STEP_QUEUE_SIZE while a consumer thread pops them, both as fast
+// as they can, each yielding and retrying while the queue is full or empty. Every field of a segment is derived from
+// its number, so the consumer can tell a segment lost, repeated, out of order or read before it was fully written.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -pthread -Ilib/Motion/src -o segment_queue_stress tools/segment_queue_stress.cpp
+//   ./segment_queue_stress [segments] [rounds]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include "StepEngine.h"
+
+static SegmentQueue<StepSegment, STEP_QUEUE_SIZE> queue;
+
+static StepSegment numbered(uint32_t n)
+{
+  StepSegment seg;
+  seg.steps[AXIS_AZ] = (long)n;
+  seg.steps[AXIS_EL] = -(long)n;
+  seg.startInc = n * 3;
+  seg.entryInc = n * 5;
+  seg.cruiseInc = n * 7;
+  seg.exitInc = n * 11;
+  seg.accelInc = n * 13;
+  seg.decelAfter = ~n;
+  seg.ticks = n ^ 0x5a5a5a5a;
+  seg.shape = (uint8_t)n;
+  return seg;
+}
+
+static bool intact(const StepSegment& seg, uint32_t n)
+{
+  StepSegment want = numbered(n);
+  return seg.steps[AXIS_AZ] == want.steps[AXIS_AZ] && seg.steps[AXIS_EL] == want.steps[AXIS_EL] &&
+         seg.startInc == want.startInc && seg.entryInc == want.entryInc && seg.cruiseInc == want.cruiseInc &&
+         seg.exitInc == want.exitInc && seg.accelInc == want.accelInc && seg.decelAfter == want.decelAfter &&
+         seg.ticks == want.ticks && seg.shape == want.shape;
+}
+
+struct Result
+{
+  uint32_t received;
+  uint32_t outOfOrder;  // a number other than the next one expected
+  uint32_t torn;        // the right number with other fields wrong
+  uint32_t fullRetries;
+  uint32_t emptyRetries;
+};
+
+static Result runRound(uint32_t count)
+{
+  Result r = {};
+  std::thread producer([&r, count]() {
+    for (uint32_t n = 0; n < count; n++)
+      while (!queue.push(numbered(n)))
+      {
+        r.fullRetries++;
+        std::this_thread::yield();  // on a single core the consumer cannot run meanwhile otherwise
+      }
+  });
+  std::thread consumer([&r, count]() {
+    uint32_t expect = 0;
+    while (expect < count)
+    {
+      StepSegment seg;
+      if (!queue.pop(seg))
+      {
+        r.emptyRetries++;
+        std::this_thread::yield();
+        continue;
+      }
+      uint32_t n = (uint32_t)seg.steps[AXIS_AZ];
+      if (n != expect) r.outOfOrder++;
+      else if (!intact(seg, n)) r.torn++;
+      r.received++;
+      expect = n + 1;
+    }
+  });
+  producer.join();
+  consumer.join();
+  return r;
+}
+
+int main(int argc, char** argv)
+{
+  uint32_t count = argc > 1 ? (uint32_t)atol(argv[1]) : 2000000;
+  int rounds = argc > 2 ? atoi(argv[2]) : 5;
+
+  printf("%u segments per round through a queue of %u, %d rounds\n", count, STEP_QUEUE_SIZE, rounds);
+  printf("round  received  out of order  torn  left over  full retries  empty retries\n");
+  int failures = 0;
+  for (int k = 0; k < rounds; k++)
+  {
+    Result r = runRound(count);
+    uint32_t left = queue.size();
+    printf("%5d  %8u  %12u  %4u  %9u  %12u  %13u\n", k + 1, r.received, r.outOfOrder, r.torn, left, r.fullRetries,
+           r.emptyRetries);
+    if (r.received != count || r.outOfOrder || r.torn || left) failures++;
+  }
+  printf("%s\n", failures ? "FAIL: segments lost, repeated or corrupted" : "PASS: every segment received once, in order");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,178 @@
+//======================================================================================================================
+// solar_float_bench
+//
+// Host accuracy sweep and benchmark of SolarCalculatorF and Observer. Compares calcHorizontalCoordinatesF() and
+// Observer's float sunPosition() with the double calcHorizontalCoordinates() over a grid of sites (latitudes -66 to
+// 66, all longitudes) and epochs (every EPOCH_STEP_YEARS from 2020 to 2060), at instants spread over each epoch's
+// SOLAR_F_EPOCH_DAYS. Reports the largest direction and elevation difference with the sun up and down to
+// HORIZON_MARGIN_DEG below the horizon, and exits non-zero if a sun-up error exceeds SOLAR_F_MAX_ERROR_DEG. Observer's
+// double sunPosition() is checked alongside. Then counts cycles per call, with and without an Observer holding the
+// site (time stamp counter on x86, nanoseconds elsewhere).
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Ilib/SunPosition/src -I.pio/libdeps/esp32dev/SolarCalculator/src -o solar_float_bench
+//       tools/solar_float_bench.cpp lib/SunPosition/src/*.cpp .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./solar_float_bench
+//======================================================================================================================
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "SolarCalculatorF.h"
+#include "Observer.h"
+#include <SolarCalculator.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COUNTER_UNIT "cycles"
+static unsigned long long counter() { return __rdtsc(); }
+#else
+#define COUNTER_UNIT "ns"
+static unsigned long long counter()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+#endif
+
+#define FIRST_YEAR 2020
+#define LAST_YEAR 2060
+#define EPOCH_STEP_YEARS 5
+#define LAT_STEP 6
+#define LON_STEP 30
+#define SAMPLE_S 3607UL  // not a divisor of the day, so samples walk through all times of day
+#define HORIZON_MARGIN_DEG 1.0
+#define TIMED_CALLS 1000000UL
+
+static double separation(double az1, double el1, double az2, double el2);
+
+struct Error
+{
+  double elUp;
+  double angleUp;
+  double elLow;
+  double angleLow;
+
+  void add(double az1, double el1, double az2, double el2)
+  {
+    double dEl = fabs(el1 - el2), angle = separation(az1, el1, az2, el2);
+    if (el2 > 0)
+    {
+      if (dEl > elUp) elUp = dEl;
+      if (angle > angleUp) angleUp = angle;
+    }
+    if (el2 > -HORIZON_MARGIN_DEG)
+    {
+      if (dEl > elLow) elLow = dEl;
+      if (angle > angleLow) angleLow = angle;
+    }
+  }
+
+  bool within(double bound) const { return angleUp <= bound && elUp <= bound; }
+
+  void print(const char* name) const
+  {
+    printf("%-16s %10.2e %10.2e   %10.2e %10.2e\n", name, angleUp, elUp, angleLow, elLow);
+  }
+};
+
+// Angle between two directions given as azimuth/elevation, degrees
+static double separation(double az1, double el1, double az2, double el2)
+{
+  const double r = M_PI / 180;
+  double dx = cos(el1 * r) * cos(az1 * r) - cos(el2 * r) * cos(az2 * r);
+  double dy = cos(el1 * r) * sin(az1 * r) - cos(el2 * r) * sin(az2 * r);
+  double dz = sin(el1 * r) - sin(el2 * r);
+  return 2 * asin(sqrt(dx * dx + dy * dy + dz * dz) / 2) / r;
+}
+
+static unsigned long yearStart(int year)
+{
+  struct tm date = {};
+  date.tm_year = year - 1900;
+  date.tm_mday = 1;
+  return (unsigned long)timegm(&date);
+}
+
+int main()
+{
+  Error engine = {}, observerF = {}, observerD = {};
+  unsigned long samples = 0;
+  for (int year = FIRST_YEAR; year <= LAST_YEAR; year += EPOCH_STEP_YEARS)
+  {
+    SolarEpochF epoch(yearStart(year));
+    for (int lat = -66; lat <= 66; lat += LAT_STEP)
+      for (int lon = -180; lon < 180; lon += LON_STEP)
+      {
+        Observer site(lat, lon);
+        for (unsigned long t = epoch.utc; epoch.covers(t); t += SAMPLE_S)
+        {
+          double az, el, azD, elD;
+          float azF, elF;
+          calcHorizontalCoordinates(t, lat, lon, az, el);
+          calcHorizontalCoordinatesF(epoch, t, (float)lat, (float)lon, azF, elF);
+          engine.add(azF, elF, az, el);
+          site.sunPosition(epoch, t, azF, elF);
+          observerF.add(azF, elF, az, el);
+          site.sunPosition(t, azD, elD);
+          observerD.add(azD, elD, az, el);
+          samples++;
+        }
+      }
+  }
+
+  // Cycles per call: one epoch, instants spread over it, at a mid latitude
+  SolarEpochF epoch(yearStart(2026));
+  Observer site(48.21, 16.37);
+  double checksum = 0;
+  unsigned long long ticks[5];
+  ticks[0] = counter();
+  for (unsigned long k = 0; k < TIMED_CALLS; k++)
+  {
+    double az, el;
+    calcHorizontalCoordinates(epoch.utc + k * 37 % (SOLAR_F_EPOCH_DAYS * 86400UL), 48.21, 16.37, az, el);
+    checksum += el;
+  }
+  ticks[1] = counter();
+  for (unsigned long k = 0; k < TIMED_CALLS; k++)
+  {
+    double az, el;
+    site.sunPosition(epoch.utc + k * 37 % (SOLAR_F_EPOCH_DAYS * 86400UL), az, el);
+    checksum += el;
+  }
+  ticks[2] = counter();
+  for (unsigned long k = 0; k < TIMED_CALLS; k++)
+  {
+    float az, el;
+    calcHorizontalCoordinatesF(epoch, epoch.utc + k * 37 % (SOLAR_F_EPOCH_DAYS * 86400UL), 48.21f, 16.37f, az, el);
+    checksum += el;
+  }
+  ticks[3] = counter();
+  for (unsigned long k = 0; k < TIMED_CALLS; k++)
+  {
+    float az, el;
+    site.sunPosition(epoch, epoch.utc + k * 37 % (SOLAR_F_EPOCH_DAYS * 86400UL), az, el);
+    checksum += el;
+  }
+  ticks[4] = counter();
+  double perCall[4];
+  for (int k = 0; k < 4; k++)
+    perCall[k] = (double)(ticks[k + 1] - ticks[k]) / TIMED_CALLS;
+
+  bool pass = engine.within(SOLAR_F_MAX_ERROR_DEG) && observerF.within(SOLAR_F_MAX_ERROR_DEG);
+  printf("%lu positions, %d-%d, epochs up to %d days old (checksum %.0f)\n", samples, FIRST_YEAR, LAST_YEAR,
+         SOLAR_F_EPOCH_DAYS, checksum);
+  printf("max error against calcHorizontalCoordinates, deg\n");
+  printf("                 sun up                  sun above %.0f deg\n", -HORIZON_MARGIN_DEG);
+  printf("                  direction  elevation    direction  elevation\n");
+  engine.print("float");
+  observerF.print("Observer float");
+  observerD.print("Observer double");
+  printf("%-16s  site per call  Observer\n", COUNTER_UNIT);
+  printf("double            %13.0f  %8.0f  %.1fx\n", perCall[0], perCall[1], perCall[0] / perCall[1]);
+  printf("float             %13.0f  %8.0f  %.1fx  (%.1fx over double per call)\n", perCall[2], perCall[3],
+         perCall[2] / perCall[3], perCall[0] / perCall[3]);
+  printf("%s: float sun-up errors %s SOLAR_F_MAX_ERROR_DEG (%.1e deg)\n", pass ? "PASS" : "FAIL",
+         pass ? "within" : "beyond", SOLAR_F_MAX_ERROR_DEG);
+  return pass ? 0 : 1;
+}
@@ -0,0 +1,176 @@
+//======================================================================================================================
+// step_jitter_sim
+//
+// Host regression test of step timing. A simulated main loop runs alongside a simulated step timer: most loop passes
+// take a fraction of a millisecond, but now and then one stalls for tens of milliseconds, as server.handleClient()
+// and webSocket.loop() do. The timer fires every STEP_TICK_US regardless, a little late by a random ISR entry latency,
+// and calls StepEngine::tick().
+//
+// For a range of rates on both axes it measures every interval between consecutive steps against the ideal 1/rate,
+// and the steps made against rate * time. Steps land on the tick grid, so no interval may be off by more than a tick
+// plus the worst ISR latency and no step may go missing, whatever the loop does. For comparison the same loop drives
+// the old polled scheme (updateSteppers() stepping when a pass finds the interval has elapsed), where every stall
+// is a gap in the pulse train.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Ilib/Motion/src -o step_jitter_sim tools/step_jitter_sim.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./step_jitter_sim [seconds per rate]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "StepEngine.h"
+
+#define LOOP_PASS_MIN_US 40     // an ordinary loop() pass
+#define LOOP_PASS_MAX_US 400
+#define LOOP_STALL_PER_MILLE 5  // passes that stall in the network stack
+#define LOOP_STALL_MAX_US 80000
+#define ISR_LATENCY_MAX_US 2
+
+static const float rates[] = { 50, 333, 1000, 3000, 7777, 12000, STEP_MAX_RATE };
+#define RATE_COUNT (sizeof(rates) / sizeof(rates[0]))
+
+// Deterministic pseudo-random numbers, so a failure reproduces
+static uint32_t seed = 12345;
+
+static uint32_t random(uint32_t below)
+{
+  seed = seed * 1664525 + 1013904223;
+  return (seed >> 8) % below;
+}
+
+static uint32_t loopPassUs()
+{
+  if (random(1000) < LOOP_STALL_PER_MILLE) return random(LOOP_STALL_MAX_US);
+  return LOOP_PASS_MIN_US + random(LOOP_PASS_MAX_US - LOOP_PASS_MIN_US);
+}
+
+struct Timing
+{
+  unsigned long steps;
+  double expected;  // rate * time
+  double maxDev;    // largest |interval - 1/rate|, us
+  double rmsDev;
+};
+
+// Interval statistics of one axis's rising STEP edges
+struct Intervals
+{
+  double ideal;
+  double last;
+  double maxDev;
+  double sumSq;
+  unsigned long steps;
+
+  void begin(double idealUs)
+  {
+    ideal = idealUs;
+    last = -1;
+    maxDev = sumSq = 0;
+    steps = 0;
+  }
+
+  void step(double timeUs)
+  {
+    if (last >= 0)
+    {
+      double dev = fabs(timeUs - last - ideal);
+      if (dev > maxDev) maxDev = dev;
+      sumSq += dev * dev;
+    }
+    last = timeUs;
+    steps++;
+  }
+
+  Timing result(double seconds, double rate) const
+  {
+    Timing t;
+    t.steps = steps;
+    t.expected = rate * seconds;
+    t.maxDev = maxDev;
+    t.rmsDev = steps > 1 ? sqrt(sumSq / (steps - 1)) : 0;
+    return t;
+  }
+};
+
+// The timer engine. Both axes run, elevation at half the azimuth rate; the loop re-sends the rates every pass, as
+// tracking does.
+static void timerEngine(float rate, double seconds, Timing out[AXIS_COUNT])
+{
+  StepEngine engine;
+  float axisRate[AXIS_COUNT] = { rate, rate / 2 };
+  Intervals iv[AXIS_COUNT];
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+  {
+    engine.setProfile(i, STEP_MAX_RATE, 0, STEP_MAX_RATE, RAMP_FIXED);
+    iv[i].begin(1e6 / axisRate[i]);
+  }
+
+  unsigned long ticks = (unsigned long)(seconds * STEP_TICK_HZ);
+  unsigned long nextLoopUs = 0;
+  for (unsigned long k = 0; k < ticks; k++)
+  {
+    unsigned long nowUs = k * STEP_TICK_US;
+    while (nextLoopUs <= nowUs)
+    {
+      for (uint8_t i = 0; i < AXIS_COUNT; i++)
+        engine.setVelocity(i, axisRate[i]);
+      nextLoopUs += loopPassUs();
+    }
+    uint8_t stepBits = engine.tick();
+    double edgeUs = nowUs + random(ISR_LATENCY_MAX_US * 1000 + 1) / 1000.0;
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+      if (stepBits & (1 << i)) iv[i].step(edgeUs);
+  }
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    out[i] = iv[i].result(seconds, axisRate[i]);
+}
+
+// The old scheme: each loop pass steps an axis once if its interval has elapsed since its last step
+static Timing polled(float rate, double seconds)
+{
+  Intervals iv;
+  iv.begin(1e6 / rate);
+  unsigned long intervalUs = (unsigned long)(1e6 / rate);
+  unsigned long endUs = (unsigned long)(seconds * 1e6);
+  unsigned long lastStepUs = 0;
+  for (unsigned long nowUs = 0; nowUs < endUs; nowUs += loopPassUs())
+  {
+    if (nowUs - lastStepUs < intervalUs) continue;
+    lastStepUs = nowUs;
+    iv.step(nowUs);
+  }
+  return iv.result(seconds, rate);
+}
+
+int main(int argc, char** argv)
+{
+  double seconds = argc > 1 ? atof(argv[1]) : 10;
+
+  double bound = STEP_TICK_US + ISR_LATENCY_MAX_US;
+  printf("%.0f s per rate; loop passes %d-%d us, %d per mille stall up to %d ms; ISR latency up to %d us\n", seconds,
+         LOOP_PASS_MIN_US, LOOP_PASS_MAX_US, LOOP_STALL_PER_MILLE, LOOP_STALL_MAX_US / 1000, ISR_LATENCY_MAX_US);
+  printf("                   timer, %2d us tick                           polled loop\n", STEP_TICK_US);
+  printf("axis rate steps/s   steps   missing  max dev us  rms dev us      steps   missing  max dev us\n");
+  int failures = 0;
+  for (unsigned r = 0; r < RATE_COUNT; r++)
+  {
+    Timing timed[AXIS_COUNT];
+    timerEngine(rates[r], seconds, timed);
+    for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    {
+      float axisRate = i == AXIS_AZ ? rates[r] : rates[r] / 2;
+      Timing old = polled(axisRate, seconds);
+      double missing = timed[i].expected - timed[i].steps;
+      bool fail = fabs(missing) > 1 || timed[i].maxDev > bound;
+      printf("%-4s %12.0f  %8lu  %8.0f  %10.1f  %10.2f   %8lu  %8.0f  %10.1f%s\n", i == AXIS_AZ ? "az" : "el", axisRate,
+             timed[i].steps, missing, timed[i].maxDev, timed[i].rmsDev, old.steps, old.expected - old.steps, old.maxDev,
+             fail ? "  <- FAIL" : "");
+      if (fail) failures++;
+    }
+  }
+  if (failures) printf("FAIL: steps missing or an interval off by more than %.0f us\n", bound);
+  else printf("PASS: no steps missing, every interval within %.0f us\n", bound);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+//======================================================================================================================
+// sun_batch_bench
+//
+// Host benchmark of the batch sun position API. Computes the sun's position for every second of a year, once with a
+// scalar loop over calcHorizontalCoordinates() and once with calcHorizontalCoordinatesBatch() in double and in
+// float, SUN_BATCH_BLOCK-sized chunks at a time, and reports the time per position and the largest difference from
+// the scalar result.
+//
+// Build and run from firmwear/ (the batch loop vectorizes with -ffast-math, which enables glibc's vector math):
+//   g++ -O3 -ffast-math -march=native -Ilib/SunPosition/src -I.pio/libdeps/esp32dev/SolarCalculator/src
+//       -o sun_batch_bench tools/sun_batch_bench.cpp lib/SunPosition/src/*.cpp
+//       .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./sun_batch_bench [lat] [lon] [year]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SunPosition.h"
+#include <SolarCalculator.h>
+
+#define CHUNK 4096
+
+static double seconds(const struct timespec& a, const struct timespec& b)
+{
+  return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) * 1e-9;
+}
+
+struct Diff
+{
+  double az;
+  double el;
+
+  void add(double az1, double el1, double az2, double el2)
+  {
+    double dAz = fabs(wrapTo180(az1 - az2)), dEl = fabs(el1 - el2);
+    if (el2 > -1 && dAz > az) az = dAz;  // azimuth is meaningless with the sun far below the horizon
+    if (dEl > el) el = dEl;
+  }
+};
+
+int main(int argc, char** argv)
+{
+  double lat = argc > 1 ? atof(argv[1]) : 48.21;
+  double lon = argc > 2 ? atof(argv[2]) : 16.37;
+  int year = argc > 3 ? atoi(argv[3]) : 2026;
+
+  struct tm date = {};
+  date.tm_year = year - 1900;
+  date.tm_mday = 1;
+  unsigned long from = (unsigned long)timegm(&date);
+  date.tm_year++;
+  unsigned long to = (unsigned long)timegm(&date);
+
+  static unsigned long utc[CHUNK];
+  static double azS[CHUNK], elS[CHUNK], azD[CHUNK], elD[CHUNK];
+  static float azF[CHUNK], elF[CHUNK];
+  double tScalar = 0, tDouble = 0, tFloat = 0, checksum = 0;
+  Diff dDouble = { 0, 0 }, dFloat = { 0, 0 };
+  struct timespec a, b;
+
+  for (unsigned long t = from; t < to; t += CHUNK)
+  {
+    size_t n = to - t < CHUNK ? to - t : CHUNK;
+    for (size_t k = 0; k < n; k++)
+      utc[k] = t + k;
+
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (size_t k = 0; k < n; k++)
+      calcHorizontalCoordinates(utc[k], lat, lon, azS[k], elS[k]);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    tScalar += seconds(a, b);
+
+    calcHorizontalCoordinatesBatch(utc, n, lat, lon, azD, elD);
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    tDouble += seconds(b, a);
+
+    calcHorizontalCoordinatesBatch(utc, n, (float)lat, (float)lon, azF, elF);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    tFloat += seconds(a, b);
+
+    for (size_t k = 0; k < n; k++)
+    {
+      dDouble.add(azD[k], elD[k], azS[k], elS[k]);
+      dFloat.add(azF[k], elF[k], azS[k], elS[k]);
+      checksum += elS[k] + elD[k] + elF[k];
+    }
+  }
+
+  double count = to - from;
+  printf("%.0f positions (every second of %d), lat %.2f lon %.2f, checksum %.0f\n", count, year, lat, lon, checksum);
+  printf("                ns/position  speedup  max diff az deg  max diff el deg\n");
+  printf("scalar double   %11.1f  %7.2f\n", tScalar / count * 1e9, 1.0);
+  printf("batch double    %11.1f  %7.2f  %15.2e  %15.2e\n", tDouble / count * 1e9, tScalar / tDouble, dDouble.az,
+         dDouble.el);
+  printf("batch float     %11.1f  %7.2f  %15.2e  %15.2e\n", tFloat / count * 1e9, tScalar / tFloat, dFloat.az,
+         dFloat.el);
+  return 0;
+}
@@ -0,0 +1,118 @@
+//======================================================================================================================
+// sun_ephemeris_bench
+//
+// Host check of SunEphemeris. Fits the sun's path once a day for a year, as the firmware does, and compares every
+// SAMPLE_S-th second of it with calcHorizontalCoordinates(): the largest elevation difference and the largest angle
+// between the two directions, with the sun above the horizon and down to HORIZON_MARGIN_DEG below it. Then times a
+// position from the fit against the full calculation, and the fit itself.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Ilib/SunPosition/src -I.pio/libdeps/esp32dev/SolarCalculator/src -o sun_ephemeris_bench
+//       tools/sun_ephemeris_bench.cpp lib/SunPosition/src/*.cpp .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./sun_ephemeris_bench [lat] [lon] [year]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SunEphemeris.h"
+#include <SolarCalculator.h>
+
+#define SAMPLE_S 10
+#define HORIZON_MARGIN_DEG 1.0
+#define TIMED_CALLS 2000000UL
+
+static double seconds(const struct timespec& a, const struct timespec& b)
+{
+  return (b.tv_sec - a.tv_sec) + (b.tv_nsec - a.tv_nsec) * 1e-9;
+}
+
+// Angle between two directions given as azimuth/elevation, degrees
+static double separation(double az1, double el1, double az2, double el2)
+{
+  const double r = M_PI / 180;
+  double dx = cos(el1 * r) * cos(az1 * r) - cos(el2 * r) * cos(az2 * r);
+  double dy = cos(el1 * r) * sin(az1 * r) - cos(el2 * r) * sin(az2 * r);
+  double dz = sin(el1 * r) - sin(el2 * r);
+  return 2 * asin(sqrt(dx * dx + dy * dy + dz * dz) / 2) / r;
+}
+
+int main(int argc, char** argv)
+{
+  double lat = argc > 1 ? atof(argv[1]) : 48.21;
+  double lon = argc > 2 ? atof(argv[2]) : 16.37;
+  int year = argc > 3 ? atoi(argv[3]) : 2026;
+
+  struct tm date = {};
+  date.tm_year = year - 1900;
+  date.tm_mday = 1;
+  unsigned long from = (unsigned long)timegm(&date);
+  date.tm_year++;
+  unsigned long to = (unsigned long)timegm(&date);
+
+  // Accuracy: refit once a day, like the firmware, and sample the whole fitted span but the look-ahead hour
+  Observer site(lat, lon);
+  SunEphemeris ephemeris;
+  double elUp = 0, angleUp = 0, elLow = 0, angleLow = 0;
+  unsigned long fits = 0;
+  for (unsigned long t = from; t < to; t += SAMPLE_S)
+  {
+    if (!ephemeris.covers(t + SUN_EPHEMERIS_SPAN_S - 86400))
+    {
+      ephemeris.fit(t, site);
+      fits++;
+    }
+    double az, el;
+    float azFit, elFit;
+    calcHorizontalCoordinates(t, lat, lon, az, el);
+    ephemeris.position(t, azFit, elFit);
+    double dEl = fabs(elFit - el), angle = separation(azFit, elFit, az, el);
+    if (el > 0)
+    {
+      if (dEl > elUp) elUp = dEl;
+      if (angle > angleUp) angleUp = angle;
+    }
+    if (el > -HORIZON_MARGIN_DEG)
+    {
+      if (dEl > elLow) elLow = dEl;
+      if (angle > angleLow) angleLow = angle;
+    }
+  }
+
+  // Speed: the same instants through both
+  struct timespec a, b;
+  double checksum = 0;
+  ephemeris.fit(from, site);
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  for (unsigned long k = 0; k < TIMED_CALLS; k++)
+  {
+    double az, el;
+    calcHorizontalCoordinates(from + k % 86400, lat, lon, az, el);
+    checksum += el;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  double tFull = seconds(a, b) / TIMED_CALLS;
+  for (unsigned long k = 0; k < TIMED_CALLS; k++)
+  {
+    float az, el;
+    ephemeris.position(from + k % 86400, az, el);
+    checksum += el;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &a);
+  double tFit = seconds(b, a) / TIMED_CALLS;
+  for (unsigned long k = 0; k < TIMED_CALLS / 100; k++)
+    ephemeris.fit(from + k, site);
+  clock_gettime(CLOCK_MONOTONIC, &b);
+  double tRefit = seconds(a, b) / (TIMED_CALLS / 100);
+
+  printf("%d, lat %.2f lon %.2f: %lu fits of order %d over %lu s, checked every %d s (checksum %.0f)\n", year, lat,
+         lon, fits, SUN_EPHEMERIS_DEGREE, SUN_EPHEMERIS_SPAN_S, SAMPLE_S, checksum);
+  printf("max error, sun above the horizon:      elevation %.2e deg, direction %.2e deg\n", elUp, angleUp);
+  printf("max error, sun above %.0f deg below it:  elevation %.2e deg, direction %.2e deg\n", -HORIZON_MARGIN_DEG, elLow,
+         angleLow);
+  printf("full calculation  %7.1f ns/position\n", tFull * 1e9);
+  printf("ephemeris         %7.1f ns/position, %.1fx faster\n", tFit * 1e9, tFull / tFit);
+  printf("fit               %7.1f ns, once a day\n", tRefit * 1e9);
+  return 0;
+}
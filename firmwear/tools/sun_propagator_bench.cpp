@@ -0,0 +1,167 @@
+//======================================================================================================================
+// sun_propagator_bench
+//
+// Host test of SunPropagator. Drift: anchors once and steps through a day at several step lengths without
+// re-anchoring, comparing each position with calcHorizontalCoordinates(); the largest direction error within each
+// of the first hours shows how fast float rounding adds up. Then a year at TRACK_STEP_S steps with the default
+// re-anchoring, which bounds it. Speed: cycles per update plus position, against Observer's float sunPosition() and
+// calcHorizontalCoordinates() (time stamp counter on x86, nanoseconds elsewhere).
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Ilib/SunPosition/src -I.pio/libdeps/esp32dev/SolarCalculator/src -o sun_propagator_bench
+//       tools/sun_propagator_bench.cpp lib/SunPosition/src/*.cpp .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./sun_propagator_bench [lat] [lon] [year]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SunPropagator.h"
+#include <SolarCalculator.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define COUNTER_UNIT "cycles"
+static unsigned long long counter() { return __rdtsc(); }
+#else
+#define COUNTER_UNIT "ns"
+static unsigned long long counter()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000ULL + t.tv_nsec;
+}
+#endif
+
+#define DRIFT_HOURS 24
+#define TRACK_STEP_S 5
+#define TIMED_UPDATES 2000000UL
+
+static const long driftSteps[] = { 1, 10, 60, 300 };
+static const int reportHours[] = { 1, 2, 6, 12, 24 };
+
+// Angle between two directions given as azimuth/elevation, degrees
+static double separation(double az1, double el1, double az2, double el2)
+{
+  const double r = M_PI / 180;
+  double dx = cos(el1 * r) * cos(az1 * r) - cos(el2 * r) * cos(az2 * r);
+  double dy = cos(el1 * r) * sin(az1 * r) - cos(el2 * r) * sin(az2 * r);
+  double dz = sin(el1 * r) - sin(el2 * r);
+  return 2 * asin(sqrt(dx * dx + dy * dy + dz * dz) / 2) / r;
+}
+
+static double error(const SunPropagator& sun, double lat, double lon)
+{
+  double az, el;
+  float azP, elP;
+  calcHorizontalCoordinates(sun.time(), lat, lon, az, el);
+  sun.position(azP, elP);
+  return separation(azP, elP, az, el);
+}
+
+int main(int argc, char** argv)
+{
+  double lat = argc > 1 ? atof(argv[1]) : 48.21;
+  double lon = argc > 2 ? atof(argv[2]) : 16.37;
+  int year = argc > 3 ? atoi(argv[3]) : 2026;
+
+  struct tm date = {};
+  date.tm_year = year - 1900;
+  date.tm_mday = 1;
+  unsigned long from = (unsigned long)timegm(&date);
+  date.tm_year++;
+  unsigned long to = (unsigned long)timegm(&date);
+  Observer site(lat, lon);
+
+  printf("%d, lat %.2f lon %.2f\n", year, lat, lon);
+  printf("drift from one anchor, largest direction error (deg) within the first\n");
+  printf("step s");
+  for (unsigned k = 0; k < sizeof(reportHours) / sizeof(reportHours[0]); k++)
+    printf("  %7d h", reportHours[k]);
+  printf("\n");
+  for (unsigned s = 0; s < sizeof(driftSteps) / sizeof(driftSteps[0]); s++)
+  {
+    // Anchored at midsummer noon UT, so the sun is up for the first hours
+    SunPropagator sun;
+    sun.setAnchorInterval(DRIFT_HOURS * 3600UL);
+    unsigned long start = from + 181 * 86400UL + 43200UL;
+    sun.anchor(start, site);
+    double worst = 0;
+    unsigned report = 0;
+    printf("%6ld", driftSteps[s]);
+    for (unsigned long t = start; t <= start + DRIFT_HOURS * 3600UL; t += driftSteps[s])
+    {
+      sun.update(t);
+      double e = error(sun, lat, lon);
+      if (e > worst) worst = e;
+      if (t - start == reportHours[report] * 3600UL)
+      {
+        printf("  %9.2e", worst);
+        report++;
+      }
+    }
+    printf("\n");
+  }
+
+  // A year of tracking steps with re-anchoring
+  SunPropagator sun;
+  sun.anchor(from, site);
+  double worstUp = 0;
+  for (unsigned long t = from; t < to; t += TRACK_STEP_S)
+  {
+    sun.update(t);
+    double az, el;
+    float azP, elP;
+    calcHorizontalCoordinates(t, lat, lon, az, el);
+    sun.position(azP, elP);
+    double e = separation(azP, elP, az, el);
+    if (el > 0 && e > worstUp) worstUp = e;
+  }
+  printf("a year at %d s steps, re-anchored every %lu s (%lu anchors): largest error with the sun up %.2e deg\n",
+         TRACK_STEP_S, SUN_PROPAGATOR_ANCHOR_S, sun.anchors(), worstUp);
+
+  // Speed, a tracking step at a time
+  SolarEpochF epoch(from);
+  double checksum = 0;
+  unsigned long long ticks[5];
+  sun.anchor(from, site);
+  ticks[0] = counter();
+  for (unsigned long k = 0; k < TIMED_UPDATES; k++)
+  {
+    float az, el;
+    sun.update(from + k * TRACK_STEP_S);
+    sun.position(az, el);
+    checksum += el;
+  }
+  ticks[1] = counter();
+  for (unsigned long k = 0; k < TIMED_UPDATES; k++)
+  {
+    sun.update(from + k * TRACK_STEP_S);
+    checksum += sun.time();
+  }
+  ticks[2] = counter();
+  for (unsigned long k = 0; k < TIMED_UPDATES; k++)
+  {
+    float az, el;
+    site.sunPosition(epoch, from + k * TRACK_STEP_S, az, el);
+    checksum += el;
+  }
+  ticks[3] = counter();
+  for (unsigned long k = 0; k < TIMED_UPDATES; k++)
+  {
+    double az, el;
+    calcHorizontalCoordinates(from + k * TRACK_STEP_S, lat, lon, az, el);
+    checksum += el;
+  }
+  ticks[4] = counter();
+
+  double perUpdate[4];
+  for (int k = 0; k < 4; k++)
+    perUpdate[k] = (double)(ticks[k + 1] - ticks[k]) / TIMED_UPDATES;
+  printf("%s per position (checksum %.0f)\n", COUNTER_UNIT, checksum);
+  printf("propagator, update and position  %6.0f\n", perUpdate[0]);
+  printf("propagator, update only          %6.0f\n", perUpdate[1]);
+  printf("Observer float sunPosition       %6.0f  %.1fx the propagator\n", perUpdate[2], perUpdate[2] / perUpdate[0]);
+  printf("calcHorizontalCoordinates        %6.0f  %.1fx the propagator\n", perUpdate[3], perUpdate[3] / perUpdate[0]);
+  return 0;
+}
@@ -0,0 +1,175 @@
+//======================================================================================================================
+// sun_update_bench
+//
+// Host benchmark of the sun update interval. Follows the sun through the daylight hours of one day a week for a
+// year with the firmware's SunTracker and a SunSource, on a simulated clock, and takes its commanded target every
+// second: position and rate at each sun update, extrapolated in between, rounded to microsteps. The axes are put on
+// that target instead of simulated (step mode, so nothing is queued) and zenith passes are left to normal tracking,
+// which leaves the error the sun updates alone cause; keyhole_sim covers the pass ramp. The same days are followed with the fixed interval the adaptive one replaced - 60 s, 5 s while the sun is
+// above 80 degrees, from the same SunSource - and both report sun positions read per day and the pointing error
+// against calcHorizontalCoordinates(), every second.
+//
+// Fails if at any latitude the adaptive interval's largest pointing error exceeds the fixed interval's, or it reads
+// the sun more often.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -Ilib/SunPosition/src -Ilib/Tracking/src
+//       -I.pio/libdeps/esp32dev/SolarCalculator/src -o sun_update_bench tools/sun_update_bench.cpp
+//       $(ls lib/Motion/src/*.cpp | grep -v StepDriver) lib/SunPosition/src/*.cpp lib/Tracking/src/*.cpp
+//       .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./sun_update_bench [year]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SunTracker.h"
+#include "MountConfig.h"
+#include <SolarCalculator.h>
+
+#define FIXED_INTERVAL_S 60
+#define FIXED_HIGH_INTERVAL_S 5   // the fixed interval while the sun was high, before the adaptive one
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const CableWrap cableWrap(angleFromDegrees(DEFAULT_WRAP_MIN_DEG), angleFromDegrees(DEFAULT_WRAP_MAX_DEG));
+
+struct Stats
+{
+  double computations;  // sun positions read per day
+  double maxError;      // deg, pointing
+  double sumSquares;
+  unsigned long samples;
+  long maxAzSteps;      // microsteps off the sun's own microstep target
+  long maxElSteps;
+};
+
+static unsigned long simUtc;
+
+static unsigned long simClock()
+{
+  return simUtc;
+}
+
+// Angle between two directions, degrees
+static double separation(double az1, double el1, double az2, double el2)
+{
+  const double r = M_PI / 180;
+  double dEl = sin((el2 - el1) * r / 2), dAz = sin((az2 - az1) * r / 2);
+  double h = dEl * dEl + cos(el1 * r) * cos(el2 * r) * dAz * dAz;
+  return 2 * asin(sqrt(h > 1 ? 1 : h)) / r;
+}
+
+// The commanded microstep position at utc against the true sun
+static void record(double lat, double lon, unsigned long utc, long azSteps, long elSteps, Stats& st)
+{
+  double sunAz, sunEl;
+  calcHorizontalCoordinates(utc, lat, lon, sunAz, sunEl);
+  double az = gearAz.stepsToDegrees(azSteps), el = gearEl.stepsToDegrees(elSteps);
+  long sunAzSteps = gearAz.degreesToSteps(az + wrapTo180(sunAz - az)), sunElSteps = gearEl.degreesToSteps(sunEl);
+
+  double error = separation(az, el, sunAz, sunEl);
+  if (error > st.maxError) st.maxError = error;
+  st.sumSquares += error * error;
+  st.samples++;
+  if (sunEl < KEYHOLE_WATCH_EL_DEG && labs(azSteps - sunAzSteps) > st.maxAzSteps) st.maxAzSteps = labs(azSteps - sunAzSteps);
+  if (labs(elSteps - sunElSteps) > st.maxElSteps) st.maxElSteps = labs(elSteps - sunElSteps);
+}
+
+// SunTracker's target from `from` to `to`, the axes kept on it
+static void trackAdaptive(double lat, double lon, unsigned long from, unsigned long to, Stats& st)
+{
+  StepEngine engine;
+  SunSource sun(Observer(lat, lon));
+  SunTracker tracker(engine, sun, simClock, gearAz, gearEl, cableWrap);
+  tracker.setVelocityMode(false);
+  tracker.setKeyholeRate(0);
+
+  double az, el;
+  calcHorizontalCoordinates(from, lat, lon, az, el);
+  engine.setPosition(AXIS_AZ, gearAz.degreesToSteps(angleToDegrees(cableWrap.nearest(0, angleFromDegrees(az)))));
+  engine.setPosition(AXIS_EL, gearEl.degreesToSteps(el));
+  tracker.start(0);
+  for (unsigned long t = from; t < to; t++)
+  {
+    unsigned long ms = (t - from) * 1000;
+    simUtc = t;
+    if (t > from)
+    {
+      engine.setPosition(AXIS_AZ, tracker.targetAzSteps(ms));
+      engine.setPosition(AXIS_EL, tracker.targetElSteps(ms));
+    }
+    tracker.update(ms);
+    record(lat, lon, t, tracker.targetAzSteps(ms), tracker.targetElSteps(ms), st);
+  }
+  st.computations += sun.lookups();
+}
+
+// The fixed interval, with the rate taken as the secant to the position an interval on
+static void trackFixed(double lat, double lon, unsigned long from, unsigned long to, Stats& st)
+{
+  SunSource sun(Observer(lat, lon));
+  double targetAz = 0, targetEl = 0, azRate = 0, elRate = 0;
+  unsigned long lastUpdate = 0, updateS = FIXED_INTERVAL_S;
+  for (unsigned long t = from; t < to; t++)
+  {
+    if (t == from || t - lastUpdate >= updateS)
+    {
+      updateS = targetEl >= KEYHOLE_WATCH_EL_DEG ? FIXED_HIGH_INTERVAL_S : FIXED_INTERVAL_S;
+      double az2, el2;
+      sun.refit(t);
+      sun.positionNow(t, targetAz, targetEl);
+      sun.positionAt(t + updateS, az2, el2);
+      azRate = wrapTo180(az2 - targetAz) / updateS;
+      elRate = (el2 - targetEl) / updateS;
+      lastUpdate = t;
+    }
+    record(lat, lon, t, gearAz.degreesToSteps(targetAz + azRate * (t - lastUpdate)),
+           gearEl.degreesToSteps(targetEl + elRate * (t - lastUpdate)), st);
+  }
+  st.computations += sun.lookups();
+}
+
+int main(int argc, char** argv)
+{
+  int year = argc > 1 ? atoi(argv[1]) : 2026;
+  const double sites[][2] = { { 0, 0 }, { 20, 0 }, { 48.21, 16.37 }, { 60, 10 } };
+
+  printf("one day a week of %d, daylight only; az steps excluded while the sun is above %.0f deg\n", year,
+         KEYHOLE_WATCH_EL_DEG);
+  printf("lat     interval  calcs/day  max err deg  rms err deg  max az steps  max el steps\n");
+  int failures = 0;
+  for (unsigned s = 0; s < sizeof(sites) / sizeof(sites[0]); s++)
+  {
+    Stats fixed = { 0, 0, 0, 0, 0, 0 };
+    for (int adaptive = 0; adaptive < 2; adaptive++)
+    {
+      Stats st = { 0, 0, 0, 0, 0, 0 };
+      int days = 0;
+      for (int day = 0; day < 365; day += 7, days++)
+      {
+        struct tm date = {};
+        date.tm_year = year - 1900;
+        date.tm_mday = 1 + day;
+        unsigned long midnight = (unsigned long)timegm(&date);
+        double transit, rise, set;
+        calcSunriseSunset(midnight, sites[s][0], sites[s][1], transit, rise, set);
+        unsigned long from = midnight + (unsigned long)(rise * 3600) + 60;
+        unsigned long to = midnight + (unsigned long)(set * 3600) - 60;
+        if (adaptive) trackAdaptive(sites[s][0], sites[s][1], from, to, st);
+        else trackFixed(sites[s][0], sites[s][1], from, to, st);
+      }
+      st.computations /= days;
+      bool fail = adaptive && (st.maxError > fixed.maxError || st.computations > fixed.computations);
+      printf("%6.2f  %-8s  %9.0f  %11.4f  %11.4f  %12ld  %12ld%s\n", sites[s][0], adaptive ? "adaptive" : "fixed",
+             st.computations, st.maxError, sqrt(st.sumSquares / st.samples), st.maxAzSteps, st.maxElSteps,
+             fail ? "  <- FAIL" : "");
+      if (fail) failures++;
+      if (!adaptive) fixed = st;
+    }
+  }
+  if (failures) printf("FAIL: the adaptive interval points worse or reads the sun more often than the fixed one\n");
+  else printf("PASS: the adaptive interval points at least as well as the fixed one, on fewer sun positions\n");
+  return failures ? 1 : 0;
+}
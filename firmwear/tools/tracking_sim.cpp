@@ -0,0 +1,206 @@
+//======================================================================================================================
+// tracking_sim
+//
+// Host simulation of velocity tracking over whole days. Runs the firmware's SunTracker on the step engine from
+// sunrise to sunset, with the sun from a SunSource at the site as main.cpp has it - sun updates at the interval
+// SunTracker::sunMotion() picks, the target extrapolated at the sun's rate in between, constant-rate segments queued
+// TRACK_QUEUE_AHEAD deep - and compares the mirror's axes with calcHorizontalCoordinates() every second. It reports
+// the RMS and largest pointing error at several latitudes on the equinox and both solstices, against the original
+// tracker: one microstep per axis every 5 s towards a target refreshed once a minute.
+//
+// The day is tracked within the default cable wrap. Where the sun's path runs past its end the azimuth axis unwinds a
+// turn and acquisition brings the mirror back; those seconds are counted apart from the pointing error, and the test
+// fails if an unwind keeps the mirror off the sun for more than UNWIND_MAX_S, or lock is lost for any other reason.
+//
+// The pointing error is the angle between the direction the axes point in and the sun's; a microstep is 0.013 deg
+// in azimuth and 0.037 deg in elevation, so about 0.01 deg RMS is what rounding to whole microsteps leaves. The test
+// fails if velocity tracking is off by more than TRACK_MAX_RMS_DEG RMS or TRACK_MAX_ERROR_DEG at any time.
+// Latitudes where the sun passes near the zenith are left to keyhole_sim. Every second of tracking is 40000 engine
+// ticks, so a run takes a few minutes.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -Ilib/SunPosition/src -Ilib/Tracking/src
+//       -I.pio/libdeps/esp32dev/SolarCalculator/src -o tracking_sim tools/tracking_sim.cpp
+//       $(ls lib/Motion/src/*.cpp | grep -v StepDriver) lib/SunPosition/src/*.cpp lib/Tracking/src/*.cpp
+//       .pio/libdeps/esp32dev/SolarCalculator/src/*.cpp
+//   ./tracking_sim [lon] [year]
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "SunTracker.h"
+#include "MountConfig.h"
+#include <SolarCalculator.h>
+
+#define LEGACY_STEP_INTERVAL_S 5
+
+#define TRACK_MAX_RMS_DEG 0.02
+#define TRACK_MAX_ERROR_DEG 0.08
+#define UNWIND_MAX_S 20  // longest a cable-wrap unwind may keep the mirror off the sun
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+static const GearRatio gearEl = DEFAULT_GEAR_EL;
+static const CableWrap cableWrap(angleFromDegrees(DEFAULT_WRAP_MIN_DEG), angleFromDegrees(DEFAULT_WRAP_MAX_DEG));
+
+static const double latitudes[] = { -45, 30, 40, 48.21, 55, 65 };
+#define LATITUDE_COUNT (sizeof(latitudes) / sizeof(latitudes[0]))
+static const int dates[][2] = { { 3, 20 }, { 6, 21 }, { 12, 21 } };  // month, day
+#define DATE_COUNT (sizeof(dates) / sizeof(dates[0]))
+
+struct Error
+{
+  double sumSquares;
+  double max;
+  unsigned long samples;
+  unsigned unwinds;          // lock lost while the azimuth axis turned round at the end of the cable wrap
+  unsigned long unwindSec;   // longest of them, s
+  unsigned losses;           // lock lost otherwise
+
+  void add(double deg)
+  {
+    sumSquares += deg * deg;
+    if (deg > max) max = deg;
+    samples++;
+  }
+  double rms() const { return samples ? sqrt(sumSquares / samples) : 0; }
+};
+
+// Angle between two directions, degrees
+static double separation(double az1, double el1, double az2, double el2)
+{
+  const double r = M_PI / 180;
+  double dEl = sin((el2 - el1) * r / 2), dAz = sin((az2 - az1) * r / 2);
+  double h = dEl * dEl + cos(el1 * r) * cos(el2 * r) * dAz * dAz;
+  return 2 * asin(sqrt(h > 1 ? 1 : h)) / r;
+}
+
+static double pointingError(long azSteps, long elSteps, double az, double el)
+{
+  return separation(azSteps / gearAz.stepsPerDegree(), elSteps / gearEl.stepsPerDegree(), az, el);
+}
+
+// The firmware's SunTracker on a simulated clock, with the mirror starting on the sun
+static unsigned long simUtc;
+
+static unsigned long simClock()
+{
+  return simUtc;
+}
+
+static Error track(double lat, double lon, unsigned long from, unsigned long to)
+{
+  Error err = {};
+  StepEngine engine;
+  engine.setProfile(AXIS_AZ, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_AZ);
+  engine.setProfile(AXIS_EL, STEP_START_RATE, STEP_ACCEL, SLEW_RATE, RAMP_SHAPE_EL);
+  SunSource sun(Observer(lat, lon));
+  SunTracker tracker(engine, sun, simClock, gearAz, gearEl, cableWrap);
+
+  double az, el;
+  calcHorizontalCoordinates(from, lat, lon, az, el);
+  engine.setPosition(AXIS_AZ, gearAz.degreesToSteps(angleToDegrees(cableWrap.nearest(0, angleFromDegrees(az)))));
+  engine.setPosition(AXIS_EL, gearEl.degreesToSteps(el));
+  tracker.start(0);
+  bool off = false;
+  unsigned long offMs = 0;
+  long offAz = 0;
+  for (unsigned long ms = 0; from + ms / 1000 < to; ms += TRACK_VELOCITY_INTERVAL_MS)
+  {
+    simUtc = from + ms / 1000;
+    tracker.update(ms);
+    for (unsigned long t = 0; t < TRACK_VELOCITY_INTERVAL_MS * 1000UL / STEP_TICK_US; t++)
+      engine.tick();
+
+    // Off the sun from losing lock until it is locked again; an unwind turns the azimuth axis most of a turn
+    if (!tracker.locked())
+    {
+      if (!off)
+      {
+        off = true;
+        offMs = ms;
+        offAz = engine.position(AXIS_AZ);
+      }
+      continue;
+    }
+    if (off)
+    {
+      off = false;
+      if (gearAz.stepsToDegrees(labs(engine.position(AXIS_AZ) - offAz)) > 180)
+      {
+        err.unwinds++;
+        if ((ms - offMs) / 1000 > err.unwindSec) err.unwindSec = (ms - offMs) / 1000;
+      }
+      else err.losses++;
+    }
+    calcHorizontalCoordinates(simUtc + 1, lat, lon, az, el);
+    err.add(pointingError(engine.position(AXIS_AZ), engine.position(AXIS_EL), az, el));
+  }
+  if (off) err.losses++;
+  return err;
+}
+
+// The original tracker: every 5 s one microstep per axis towards a target refreshed every minute, if more than two off
+static Error legacy(double lat, double lon, unsigned long from, unsigned long to)
+{
+  Error err = {};
+  double az, el, targetAz = 0, targetEl = 0;
+  calcHorizontalCoordinates(from, lat, lon, az, el);
+  long azPos = (long)(az * gearAz.stepsPerDegree()), elPos = (long)(el * gearEl.stepsPerDegree());
+  for (unsigned long t = from; t < to; t++)
+  {
+    if ((t - from) % (SUN_UPDATE_INTERVAL_MS / 1000) == 0) calcHorizontalCoordinates(t, lat, lon, targetAz, targetEl);
+    if ((t - from) % LEGACY_STEP_INTERVAL_S == 0)
+    {
+      long diffAz = (long)(targetAz * gearAz.stepsPerDegree()) - azPos;
+      long diffEl = (long)(targetEl * gearEl.stepsPerDegree()) - elPos;
+      if (labs(diffAz) > 2) azPos += diffAz > 0 ? 1 : -1;
+      if (labs(diffEl) > 2) elPos += diffEl > 0 ? 1 : -1;
+    }
+    calcHorizontalCoordinates(t + 1, lat, lon, az, el);
+    err.add(pointingError(azPos, elPos, az, el));
+  }
+  return err;
+}
+
+int main(int argc, char** argv)
+{
+  double lon = argc > 1 ? atof(argv[1]) : 16.37;
+  int year = argc > 2 ? atoi(argv[2]) : 2026;
+
+  printf("lon %.2f, %d, sunrise to sunset\n", lon, year);
+  printf("                         velocity tracking, while locked    unwinds  longest   "
+         "original, 1 step / 5 s\n");
+  printf("   lat  date    hours    rms deg    max deg  lock lost                s      rms deg    max deg\n");
+  int failures = 0;
+  for (unsigned i = 0; i < LATITUDE_COUNT; i++)
+    for (unsigned d = 0; d < DATE_COUNT; d++)
+    {
+      struct tm date = {};
+      date.tm_year = year - 1900;
+      date.tm_mon = dates[d][0] - 1;
+      date.tm_mday = dates[d][1];
+      unsigned long day = (unsigned long)timegm(&date);
+      double transit, rise, set;
+      calcSunriseSunset(day, latitudes[i], lon, transit, rise, set, SUNRISE_ALTITUDE);
+      if (isnan(rise) || isnan(set)) continue;
+      unsigned long from = day + (unsigned long)(rise * 3600) + 60, to = day + (unsigned long)(set * 3600) - 60;
+      if (to < from) to += 86400;
+
+      Error v = track(latitudes[i], lon, from, to);
+      Error old = legacy(latitudes[i], lon, from, to);
+      bool fail = v.rms() > TRACK_MAX_RMS_DEG || v.max > TRACK_MAX_ERROR_DEG || v.losses || v.unwindSec > UNWIND_MAX_S;
+      printf("%6.2f  %02d-%02d  %5.1f  %9.4f  %9.4f  %9u  %7u  %7lu    %9.3f  %9.3f%s\n", latitudes[i], dates[d][0],
+             dates[d][1], (to - from) / 3600.0, v.rms(), v.max, v.losses, v.unwinds, v.unwindSec, old.rms(), old.max,
+             fail ? "  <- FAIL" : "");
+      if (fail) failures++;
+    }
+  if (failures)
+    printf("FAIL: velocity tracking off by more than %.2f deg RMS or %.2f deg, lost lock, or unwound for over %d s\n",
+           TRACK_MAX_RMS_DEG, TRACK_MAX_ERROR_DEG, UNWIND_MAX_S);
+  else
+    printf("PASS: velocity tracking within %.2f deg RMS and %.2f deg, off the sun only to unwind, for at most %d s\n",
+           TRACK_MAX_RMS_DEG, TRACK_MAX_ERROR_DEG, UNWIND_MAX_S);
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+//======================================================================================================================
+// trapezoid_check
+//
+// Host test and benchmark of the trapezoidal profile. Runs single-axis moves (moveTo, as jogs and tracking slews use
+// them) and coordinated lines (queueLine, the major axis) from rest to rest, and checks the tick of every step against
+// the analytic profile: from the start rate up at a constant acceleration to the cruise rate, or to the peak a short
+// move allows, and back down symmetrically, where step n is due the moment the distance covered reaches n.
+//
+// Steps land on the tick grid, so each may be up to a tick late; the per-tick ramp adds up to another. The profile is
+// placed by the first step, since how many ticks go into latching DIR beforehand is not part of it. The test fails
+// if any step is further than STEP_TOLERANCE_TICKS off, if a move does not end where it should, or if its last step is
+// off by more than that. It also reports the ticks per second the engine sustains on the host.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Ilib/Motion/src -o trapezoid_check tools/trapezoid_check.cpp $(ls lib/Motion/src/*.cpp | grep -v StepDriver)
+//   ./trapezoid_check
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include "StepEngine.h"
+
+#define STEP_TOLERANCE_TICKS 2.0
+
+struct Profile
+{
+  long steps;
+  float startRate;  // steps/s
+  float accel;      // steps/s^2
+  float maxRate;    // steps/s
+};
+
+static const Profile profiles[] = {
+  { 20000, 800, 3000, 4000 },      // main.cpp's slew settings
+  { 3000, 800, 3000, 4000 },       // too short to reach the cruise rate
+  { 200000, 800, 12000, 20000 },   // fast
+  { 800, 100, 200, 400 },          // slow, long intervals
+  { 40, 800, 3000, 4000 },         // never leaves the start rate by much
+};
+#define PROFILE_COUNT (sizeof(profiles) / sizeof(profiles[0]))
+
+// Analytic trapezoid from rest to rest
+struct Trapezoid
+{
+  double v0, a, peak, rampSteps, rampTime, total;
+  long steps;
+
+  Trapezoid(const Profile& p) : v0(p.startRate), a(p.accel), steps(p.steps)
+  {
+    rampSteps = ((double)p.maxRate * p.maxRate - v0 * v0) / (2 * a);
+    if (2 * rampSteps > steps) rampSteps = steps / 2.0;
+    peak = sqrt(v0 * v0 + 2 * a * rampSteps);
+    rampTime = (peak - v0) / a;
+    total = 2 * rampTime + (steps - 2 * rampSteps) / peak;
+  }
+
+  // Time into the ramp at which n steps have been covered
+  double rampTimeOf(double n) const { return (sqrt(v0 * v0 + 2 * a * n) - v0) / a; }
+
+  // Time at which step n is due
+  double stepTime(long n) const
+  {
+    if (n <= rampSteps) return rampTimeOf(n);
+    if (n <= steps - rampSteps) return rampTime + (n - rampSteps) / peak;
+    return total - rampTimeOf(steps - n);
+  }
+};
+
+struct Result
+{
+  long steps;
+  double seconds;
+  double expected;
+  double maxDevTicks;
+  double meanDevTicks;
+  double ticksPerSec;  // host speed
+};
+
+static double now()
+{
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static Result check(const Profile& p, bool line)
+{
+  StepEngine engine;
+  for (uint8_t i = 0; i < AXIS_COUNT; i++)
+    engine.setProfile(i, p.startRate, p.accel, p.maxRate, RAMP_TRAPEZOID);
+  if (line) engine.queueLine(p.steps, p.steps / 3);
+  else engine.moveTo(AXIS_AZ, p.steps, p.maxRate);
+
+  Trapezoid model(p);
+  Result r = {};
+  long tick = 0;
+  double startTick = 0, endTick = 0, sumDev = 0, clock = now();
+  while ((engine.isRunning(AXIS_AZ) || engine.isRunning(AXIS_EL)) && tick < 600 * (long)STEP_TICK_HZ)
+  {
+    uint8_t stepBits = engine.tick();
+    if (stepBits & (1 << AXIS_AZ))
+    {
+      // A step is due at the end of the tick that completes it. The profile starts where the first step puts it:
+      // lines and single-axis moves take different numbers of ticks to latch DIR first.
+      r.steps++;
+      if (r.steps == 1) startTick = tick + 1 - model.stepTime(1) * STEP_TICK_HZ;
+      double dev = (tick + 1 - startTick) - model.stepTime(r.steps) * STEP_TICK_HZ;
+      if (fabs(dev) > r.maxDevTicks) r.maxDevTicks = fabs(dev);
+      sumDev += dev;
+      endTick = tick + 1;
+    }
+    tick++;
+  }
+  r.ticksPerSec = tick / (now() - clock);
+  r.seconds = (endTick - startTick) / (double)STEP_TICK_HZ;
+  r.expected = model.total;
+  r.meanDevTicks = r.steps ? sumDev / r.steps : 0;
+  return r;
+}
+
+int main()
+{
+  printf("steps   start  accel    max   move     steps  time s  model s  max dev ticks  mean dev  Mticks/s\n");
+  int failures = 0;
+  for (unsigned k = 0; k < PROFILE_COUNT; k++)
+  {
+    const Profile& p = profiles[k];
+    for (int line = 0; line < 2; line++)
+    {
+      Result r = check(p, line != 0);
+      bool fail = r.steps != p.steps || r.maxDevTicks > STEP_TOLERANCE_TICKS ||
+                  fabs(r.seconds - r.expected) * STEP_TICK_HZ > STEP_TOLERANCE_TICKS;
+      printf("%6ld  %5.0f  %5.0f  %5.0f  %-6s  %6ld  %6.3f  %7.3f  %13.2f  %8.2f  %8.1f%s\n", p.steps, p.startRate,
+             p.accel, p.maxRate, line ? "line" : "moveTo", r.steps, r.seconds, r.expected, r.maxDevTicks,
+             r.meanDevTicks, r.ticksPerSec * 1e-6, fail ? "  <- FAIL" : "");
+      if (fail) failures++;
+    }
+  }
+  if (failures) printf("FAIL: step times off the analytic profile by more than %.1f ticks\n", STEP_TOLERANCE_TICKS);
+  else printf("PASS: every step within %.1f ticks of the analytic profile\n", STEP_TOLERANCE_TICKS);
+  return failures ? 1 : 0;
+}
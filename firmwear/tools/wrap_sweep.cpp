@@ -0,0 +1,179 @@
+//======================================================================================================================
+// wrap_sweep
+//
+// Host test of CableWrap across the 0/360 boundary. For several cable-wrap ranges:
+//  - every bearing from 350 to 10 deg in hundredths, from every current position across the range (and a little
+//    outside it), is checked against a brute-force search of all turns of that bearing: nearest() must pick one
+//    inside the range and no further from the current position than any other inside it (either one at an exact
+//    half turn), or, for a range too narrow to reach it, the limit angularly closer to the bearing
+//  - the sun is followed across north for several turns each way, the way tracking does it (mechanicalAz() from the
+//    axis position, to microsteps): each update must move no more than the bearing did, plus a microstep, except
+//    where the range runs out and the axis unwinds a single turn
+// For comparison, the original arithmetic - the bearing used as the mechanical angle - is run alongside.
+//
+// Build and run from firmwear/:
+//   g++ -O2 -Iinclude -Ilib/Motion/src -o wrap_sweep tools/wrap_sweep.cpp lib/Motion/src/CableWrap.cpp lib/Motion/src/GearRatio.cpp
+//   ./wrap_sweep
+//======================================================================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "CableWrap.h"
+#include "MountConfig.h"
+
+static const GearRatio gearAz = DEFAULT_GEAR_AZ;
+
+#define SWEEP_FROM_DEG 350         // bearings checked: 350 .. 370 (= 10)
+#define SWEEP_TO_DEG 370
+#define SWEEP_STEP (ANGLE_PER_DEG / 100)
+#define CURRENT_STEP (ANGLE_PER_DEG / 4)
+#define CURRENT_OUTSIDE_DEG 30     // current positions checked beyond the limits, as after a jog
+#define TRACK_STEP (ANGLE_PER_DEG / 20)  // bearing change per tracking update
+#define TRACK_TURNS 4
+
+struct Range
+{
+  const char* name;
+  int minDeg;
+  int maxDeg;
+};
+
+static const Range ranges[] = {
+  { "main.cpp", (int)DEFAULT_WRAP_MIN_DEG, (int)DEFAULT_WRAP_MAX_DEG },
+  { "one turn", 0, 360 },
+  { "half each way", -180, 180 },
+  { "a turn and a half", -540, 540 },
+  { "narrow", 30, 200 },
+};
+#define RANGE_COUNT (sizeof(ranges) / sizeof(ranges[0]))
+
+static int64_t distance(int64_t a, int64_t b)
+{
+  return a > b ? a - b : b - a;
+}
+
+// Brute force: a turn of the bearing in range closest to current, or the limit nearer the bearing if none is
+static int64_t bestTarget(const CableWrap& wrap, Angle current, Angle bearing)
+{
+  int64_t best = 0;
+  bool found = false;
+  for (int k = -8; k <= 8; k++)
+  {
+    int64_t t = (int64_t)angleNormalize(bearing) + k * ANGLE_FULL_TURN;
+    if (t < wrap.minAngle() || t > wrap.maxAngle()) continue;
+    if (!found || distance(t, current) < distance(best, current)) best = t;
+    found = true;
+  }
+  if (found) return best;
+  return distance(angleDelta(bearing, wrap.minAngle()), 0) <= distance(angleDelta(bearing, wrap.maxAngle()), 0)
+           ? wrap.minAngle()
+           : wrap.maxAngle();
+}
+
+struct Sweep
+{
+  unsigned long checked;
+  unsigned long outside;     // picked a target outside the range
+  unsigned long wrongTurn;   // not the bearing, or not the closest turn of it
+  double maxSlewDeg;         // largest move from inside the range: over half a turn where the short way is cut off
+  double maxRawSlewDeg;      // the same with the bearing as the mechanical angle
+};
+
+static Sweep sweepNorth(const CableWrap& wrap)
+{
+  Sweep s = { 0, 0, 0, 0, 0 };
+  Angle from = wrap.minAngle() - CURRENT_OUTSIDE_DEG * ANGLE_PER_DEG;
+  Angle to = wrap.maxAngle() + CURRENT_OUTSIDE_DEG * ANGLE_PER_DEG;
+  for (Angle current = from; current <= to; current += CURRENT_STEP)
+    for (Angle b = SWEEP_FROM_DEG * ANGLE_PER_DEG; b <= SWEEP_TO_DEG * ANGLE_PER_DEG; b += SWEEP_STEP)
+    {
+      Angle bearing = angleNormalize(b);
+      Angle target = wrap.nearest(current, bearing);
+      s.checked++;
+      if (target < wrap.minAngle() || target > wrap.maxAngle()) s.outside++;
+      int64_t best = bestTarget(wrap, current, bearing);
+      bool onBearing = angleNormalize(target) == bearing || target == wrap.minAngle() || target == wrap.maxAngle();
+      if (!onBearing || distance(target, current) != distance(best, current)) s.wrongTurn++;
+      if (current < wrap.minAngle() || current > wrap.maxAngle()) continue;
+      double slew = distance(target, current) / (double)ANGLE_PER_DEG;
+      if (slew > s.maxSlewDeg) s.maxSlewDeg = slew;
+      double raw = distance(bearing, current) / (double)ANGLE_PER_DEG;
+      if (raw > s.maxRawSlewDeg) s.maxRawSlewDeg = raw;
+    }
+  return s;
+}
+
+struct Track
+{
+  unsigned long updates;
+  unsigned long crossings;   // of north
+  unsigned long unwinds;     // updates that turned the axis round the long way
+  double maxSlewDeg;         // largest update that was not an unwind
+  double maxUnwindDeg;
+  unsigned long rawSpins;    // updates the original arithmetic turns the mirror more than half a turn
+};
+
+// mechanicalAz() from main.cpp, to microsteps
+static long trackTarget(const CableWrap& wrap, Angle bearing, long fromSteps)
+{
+  Angle current = angleSaturate(gearAz.toAngle(fromSteps));
+  return gearAz.degreesToSteps(angleToDegrees(wrap.nearest(current, bearing)));
+}
+
+static void trackStep(const CableWrap& wrap, Track& t, Angle& bearing, Angle change, long& pos)
+{
+  Angle next = angleNormalize(bearing + change);
+  if ((change > 0 && next < bearing) || (change < 0 && next > bearing)) t.crossings++;
+  long target = trackTarget(wrap, next, pos);
+  double slew = gearAz.stepsToDegrees(labs(target - pos));
+  if (slew > 180)
+  {
+    t.unwinds++;
+    if (slew > t.maxUnwindDeg) t.maxUnwindDeg = slew;
+  }
+  else if (slew > t.maxSlewDeg) t.maxSlewDeg = slew;
+  if (distance(next, bearing) > ANGLE_FULL_TURN / 2) t.rawSpins++;
+  bearing = next;
+  pos = target;
+  t.updates++;
+}
+
+// From the middle of the range, TRACK_TURNS turns clockwise, then back past the start
+static Track trackAcrossNorth(const CableWrap& wrap)
+{
+  Track t = { 0, 0, 0, 0, 0, 0 };
+  Angle bearing = SWEEP_FROM_DEG * ANGLE_PER_DEG;
+  long pos = trackTarget(wrap, bearing, gearAz.toSteps((wrap.minAngle() + wrap.maxAngle()) / 2));
+  for (long k = 0; k < TRACK_TURNS * ANGLE_FULL_TURN / TRACK_STEP; k++)
+    trackStep(wrap, t, bearing, TRACK_STEP, pos);
+  for (long k = 0; k < 2 * TRACK_TURNS * ANGLE_FULL_TURN / TRACK_STEP; k++)
+    trackStep(wrap, t, bearing, -TRACK_STEP, pos);
+  return t;
+}
+
+int main()
+{
+  printf("bearings 350..10 deg from every position in range; then %d turns each way across north\n", TRACK_TURNS);
+  printf("wrap                 range deg    checked  outside  not closest  max slew  raw max | crossings  "
+         "max update  unwinds  max unwind  raw spins\n");
+  int failures = 0;
+  double trackLimit = gearAz.stepsToDegrees(1) + (double)TRACK_STEP / ANGLE_PER_DEG;
+  for (unsigned k = 0; k < RANGE_COUNT; k++)
+  {
+    const Range& r = ranges[k];
+    CableWrap wrap(r.minDeg * ANGLE_PER_DEG, r.maxDeg * ANGLE_PER_DEG);
+    Sweep s = sweepNorth(wrap);
+    Track t = trackAcrossNorth(wrap);
+    bool reachesAll = r.maxDeg - r.minDeg >= 360;
+    // With a range of at least a turn, tracking follows the bearing and unwinds at most a turn
+    bool fail = s.outside || s.wrongTurn ||
+                (reachesAll && (t.maxSlewDeg > trackLimit || t.maxUnwindDeg > 360.0 + trackLimit));
+    printf("%-17s  %5d..%-4d  %9lu  %7lu  %11lu  %8.2f  %7.2f | %9lu  %10.3f  %7lu  %10.2f  %9lu%s\n", r.name, r.minDeg,
+           r.maxDeg, s.checked, s.outside, s.wrongTurn, s.maxSlewDeg, s.maxRawSlewDeg, t.crossings, t.maxSlewDeg,
+           t.unwinds, t.maxUnwindDeg, t.rawSpins, fail ? "  <- FAIL" : "");
+    if (fail) failures++;
+  }
+  if (failures) printf("FAIL: a target left the wrap range or was not the shortest path it allows\n");
+  else printf("PASS: every target within the wrap and the shortest path it allows across 0/360\n");
+  return failures ? 1 : 0;
+}